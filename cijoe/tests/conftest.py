@@ -0,0 +1,15 @@
+from pathlib import Path
+
+import yaml
+
+
+def run_scenario(cijoe, scenario):
+    """Run 'xal_scenarios' and return its YAML report"""
+
+    dev_path = cijoe.getconf("xal.dev_path", None)
+    report_path = Path(cijoe.getconf("xal.artifacts.path")) / f"scenario_{scenario}.yaml"
+
+    err, state = cijoe.run(f"xal_scenarios {scenario} {dev_path} > {report_path}")
+    assert not err
+
+    return yaml.safe_load(report_path.read_text())["xal_scenarios"]
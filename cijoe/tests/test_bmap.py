@@ -48,3 +48,81 @@ def test_compare_to_xfs_bmap(cijoe):
     assert yaml.safe_load(expected_bmap.read_text()) == yaml.safe_load(
         got_bmap.read_text()
     )
+
+
+def test_compact_extents_compare_to_bmap(cijoe):
+
+    dev_path = cijoe.getconf("xal.dev_path", None)
+    artifacts_path = Path(cijoe.getconf("xal.artifacts.path"))
+
+    paths = {
+        "default": artifacts_path / "xal_bmap_default.yaml",
+        "compact": artifacts_path / "xal_bmap_compact.yaml",
+    }
+
+    err, state = cijoe.run(f"xal --bmap {dev_path} > {paths['default']}")
+    assert not err
+
+    err, state = cijoe.run(f"xal --bmap --compact-extents {dev_path} > {paths['compact']}")
+    assert not err
+
+    assert yaml.safe_load(paths["default"].read_text()) == yaml.safe_load(
+        paths["compact"].read_text()
+    )
+
+
+def test_compact_compare_to_bmap(cijoe):
+
+    dev_path = cijoe.getconf("xal.dev_path", None)
+    artifacts_path = Path(cijoe.getconf("xal.artifacts.path"))
+
+    paths = {
+        "default": artifacts_path / "xal_bmap_default.yaml",
+        "relayout": artifacts_path / "xal_bmap_relayout.yaml",
+    }
+
+    err, state = cijoe.run(f"xal --bmap {dev_path} > {paths['default']}")
+    assert not err
+
+    err, state = cijoe.run(f"xal --bmap --compact {dev_path} > {paths['relayout']}")
+    assert not err
+
+    assert yaml.safe_load(paths["default"].read_text()) == yaml.safe_load(
+        paths["relayout"].read_text()
+    )
+
+
+def test_merge_extents_compare_to_bmap(cijoe):
+
+    dev_path = cijoe.getconf("xal.dev_path", None)
+    artifacts_path = Path(cijoe.getconf("xal.artifacts.path"))
+
+    paths = {
+        "default": artifacts_path / "xal_bmap_default.yaml",
+        "merged": artifacts_path / "xal_bmap_merged.yaml",
+    }
+
+    def coalesce(extents):
+        """Merge ranges contiguous in the file and on the device; flags are not in the output"""
+
+        merged = []
+        for extent in extents or []:
+            if merged and merged[-1][1] + 1 == extent[0] and merged[-1][3] + 1 == extent[2]:
+                merged[-1] = [merged[-1][0], extent[1], merged[-1][2], extent[3]]
+            else:
+                merged.append(list(extent))
+        return merged
+
+    err, state = cijoe.run(f"xal --bmap {dev_path} > {paths['default']}")
+    assert not err
+
+    err, state = cijoe.run(f"xal --bmap --merge-extents {dev_path} > {paths['merged']}")
+    assert not err
+
+    default = yaml.safe_load(paths["default"].read_text())
+    merged = yaml.safe_load(paths["merged"].read_text())
+
+    assert default.keys() == merged.keys()
+    for key in default:
+        assert len(merged[key] or []) <= len(default[key] or [])
+        assert coalesce(merged[key]) == coalesce(default[key])
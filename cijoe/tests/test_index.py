@@ -35,3 +35,23 @@ def test_compare_to_find(cijoe):
         diffs.append({"expected": expected, "got": got})
 
     assert not diffs
+
+
+def test_incremental_compare_to_index(cijoe):
+
+    dev_path = cijoe.getconf("xal.dev_path", None)
+    artifacts_path = Path(cijoe.getconf("xal.artifacts.path"))
+
+    paths = {
+        "index": artifacts_path / "xal_find_index.output",
+        "incremental": artifacts_path / "xal_find_incremental.output",
+    }
+
+    err, state = cijoe.run(f"xal --find {dev_path} > {paths['index']}")
+    assert not err
+
+    # A small budget to exercise resuming within each of the phases
+    err, state = cijoe.run(f"xal --find --step-budget 7 {dev_path} > {paths['incremental']}")
+    assert not err
+
+    assert paths["index"].read_text() == paths["incremental"].read_text()
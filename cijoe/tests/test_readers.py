@@ -0,0 +1,56 @@
+import logging as log
+import os
+from pathlib import Path
+
+import yaml
+
+
+def run_stress(cijoe, name, args):
+    """Run 'xal_stress_readers' and return its YAML report"""
+
+    dev_path = cijoe.getconf("xal.dev_path", None)
+    report_path = Path(cijoe.getconf("xal.artifacts.path")) / f"{name}.yaml"
+
+    err, state = cijoe.run(f"xal_stress_readers {args} {dev_path} > {report_path}")
+    assert not err
+
+    return yaml.safe_load(report_path.read_text())["xal_stress_readers"]
+
+
+def test_readers_with_inotify_writer(cijoe):
+
+    report = run_stress(cijoe, "stress_readers_writer", "--threads 8 --seconds 10 --writer")
+
+    assert report["errors"] == 0
+    assert report["inconsistent"] == 0
+    assert report["writes"] > 0
+    assert report["updates"] > 0
+
+
+def test_readers_with_inotify_writer_compact_extents(cijoe):
+
+    report = run_stress(
+        cijoe,
+        "stress_readers_writer_compact",
+        "--threads 8 --seconds 10 --writer --compact-extents",
+    )
+
+    assert report["errors"] == 0
+    assert report["inconsistent"] == 0
+
+
+def test_readers_scale(cijoe):
+
+    nthreads = min(4, os.cpu_count() or 1)
+
+    single = run_stress(cijoe, "stress_readers_1", "--threads 1 --seconds 5")
+    multi = run_stress(cijoe, f"stress_readers_{nthreads}", f"--threads {nthreads} --seconds 5")
+
+    for report in [single, multi]:
+        assert report["errors"] == 0
+        assert report["inconsistent"] == 0
+
+    # Readers share no writable state, thus, lookups are expected to scale with the number of
+    # threads; reported rather than asserted, as throughput on a shared machine is noisy
+    scaling = multi["lookups_per_sec"] / max(single["lookups_per_sec"], 1)
+    log.info(f"threads({nthreads}) scaling({scaling:.2f}) ideal({nthreads})")
@@ -0,0 +1,12 @@
+from conftest import run_scenario
+
+
+def test_recycle_under_repeated_updates(cijoe):
+
+    report = run_scenario(cijoe, "recycle")
+
+    # The small file claims records which the large file released, thus, its claims are served
+    # from the free-lists rather than the end of the pool; and the records recycled describe the
+    # same extents as a fresh index
+    assert report["recycled"] > 0
+    assert report["consistent"]
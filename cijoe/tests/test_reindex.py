@@ -0,0 +1,27 @@
+from conftest import run_scenario
+
+
+def check_reindex(report):
+    """Assert on the report of the 'reindex' scenarios"""
+
+    # Every re-index either publishes a new generation, or is refused with -EBUSY, as a snapshot
+    # pinned the index, leaving the published index, and its generation, in place
+    assert report["published"] + report["busy"] == report["rounds"]
+    assert report["published"] > 0
+    assert report["busy_published"] == 0
+
+    # Readers, and snapshots, of the files which are not modified observe the same extents
+    # throughout, whether a re-index was published or refused
+    assert report["lookups"] > 0
+    assert report["errors"] == 0
+    assert report["inconsistent"] == 0
+
+
+def test_reindex_while_reading(cijoe):
+
+    check_reindex(run_scenario(cijoe, "reindex"))
+
+
+def test_reindex_shared_while_reading(cijoe):
+
+    check_reindex(run_scenario(cijoe, "reindex_shared"))
@@ -0,0 +1,35 @@
+from conftest import run_scenario
+
+
+def test_attach(cijoe):
+
+    report = run_scenario(cijoe, "attach")
+
+    # Nothing to attach to before the producer has published a manifest
+    assert report["attach_missing"] < 0
+
+    # The view describes the same index as the producer, and observes it being re-indexed
+    assert report["files"] > 0
+    assert report["files_view"] == report["files"]
+    assert report["extents_equal"]
+    assert report["generation_follows"]
+
+    # Refreshed after each of two re-indexes, the view follows the pools onto new objects
+    assert report["refreshed"] == 0
+    assert report["files_refreshed"] == report["files"]
+    assert report["refreshed_extents_equal"]
+
+
+def test_seal(cijoe):
+
+    report = run_scenario(cijoe, "seal")
+
+    # A view attached by the descriptors of the memfds describes the same index as the producer
+    assert report["files"] > 0
+    assert report["files_view"] == report["files"]
+    assert report["extents_equal"]
+
+    # Once sealed, the index cannot be modified, yet it can still be attached to
+    assert report["index_sealed"] == -1
+    assert report["compact_sealed"] == -1
+    assert report["sealed_extents_equal"]
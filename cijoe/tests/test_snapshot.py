@@ -0,0 +1,13 @@
+from conftest import run_scenario
+
+
+def test_snapshot_unchanged_by_extent_update(cijoe):
+
+    report = run_scenario(cijoe, "snapshot")
+
+    # The watcher updated the file in the index, while the snapshot kept the extents of when it
+    # was taken; re-indexing is refused while the snapshot is open
+    assert report["live_changed"]
+    assert report["snapshot_unchanged"]
+    assert report["index_while_pinned"] == -16
+    assert report["restored"]
@@ -36,7 +36,25 @@
 
 #define XAL_INODE_NAME_MAXLEN 255
 #define XAL_PATH_MAXLEN 255
+#define XAL_NTHREADS_MAX 256 ///< Upper bound of xal_opts.nthreads
+#define XAL_QDEPTH_MAX 4096  ///< Upper bound of xal_opts.qdepth
+
+/**
+ * Index of an element in the pools of inodes and extents
+ *
+ * With the meson option 'wide-index', the index is 64-bit; for file systems with more than 4G
+ * inodes or extents, at the cost of 48 rather than 32 bytes per inode. Consumers must be built
+ * with the same XAL_WIDE_INDEX setting as the library, as given by its pkg-config cflags.
+ */
+#ifdef XAL_WIDE_INDEX
+typedef uint64_t xal_idx_t;
+#define XAL_POOL_IDX_NONE UINT64_MAX
+#define PRIxal_idx PRIu64
+#else
+typedef uint32_t xal_idx_t;
 #define XAL_POOL_IDX_NONE UINT32_MAX
+#define PRIxal_idx PRIu32
+#endif
 
 enum xal_backend {
 	XAL_BACKEND_XFS     = 1,
@@ -54,18 +72,67 @@ enum xal_file_lookupmode {
 	XAL_FILE_LOOKUPMODE_HASHMAP = 1,   ///< Uses a hash map for constant-time inode lookup in xal_get_inode(), with higher memory usage.
 };
 
+/**
+ * How the XFS backend settles a mounted file system before parsing it on-disk, see xal_opts.quiesce
+ */
+enum xal_quiesce {
+	XAL_QUIESCE_NONE   = 0,  ///< The file system is expected to be unmounted, or a snapshot; nothing is done.
+	XAL_QUIESCE_SYNCFS = 1,  ///< The mounted file system is flushed via syncfs(); best-effort, in-flight changes are not prevented, thus pair it with validation.
+	XAL_QUIESCE_FREEZE = 2,  ///< The mounted file system is frozen via FIFREEZE from xal_dinodes_retrieve() until xal_index() completes; requires CAP_SYS_ADMIN.
+};
+
+/**
+ * Page size backing the pools of inodes, extents and names, see xal_opts.hugepages
+ */
+enum xal_hugepages {
+	XAL_HUGEPAGES_NONE        = 0,  ///< Regular pages
+	XAL_HUGEPAGES_TRANSPARENT = 1,  ///< Transparent huge pages via madvise(MADV_HUGEPAGE); best-effort, as configured in /sys/kernel/mm/transparent_hugepage
+	XAL_HUGEPAGES_EXPLICIT    = 2,  ///< Pre-allocated huge pages via MAP_HUGETLB, or hugetlbfs when shared; falls back to XAL_HUGEPAGES_TRANSPARENT when the initial allocation cannot be satisfied
+};
+
+/**
+ * Placement of the pages of the pools on NUMA nodes, see xal_opts.numa_policy
+ */
+enum xal_numa_policy {
+	XAL_NUMA_DEFAULT    = 0, ///< First-touch; that is, on the node of the indexing thread
+	XAL_NUMA_INTERLEAVE = 1, ///< Interleave the pages across the online nodes, evening out remote accesses
+	XAL_NUMA_BIND       = 2, ///< Place the pages on xal_opts.numa_node
+};
+
+/**
+ * Pre-faulting of the pools, see xal_opts.prefault and xal_prefault(); the flags can be combined
+ */
+enum xal_prefault {
+	XAL_PREFAULT_NONE     = 0,      ///< Pages are faulted in on first access
+	XAL_PREFAULT_POPULATE = 1 << 0, ///< Fault in the pools synchronously, via MADV_POPULATE_READ
+	XAL_PREFAULT_WILLNEED = 1 << 1, ///< Advise the pools as MADV_WILLNEED; read-ahead in the background, e.g. of swapped-out shared memory
+	XAL_PREFAULT_MLOCK    = 1 << 2, ///< Lock the hot pools, that is the inodes, extents and names, in memory; subject to RLIMIT_MEMLOCK
+};
+
 struct xal_opts {
 	enum xal_backend be;
 	enum xal_watchmode watch_mode;
 	enum xal_file_lookupmode file_lookupmode;
-	const char *shm_name; ///< If set, pool memory is backed by POSIX shared memory with this base name, see @xal_from_pools() for sharing the pools across processes
+	const char *shm_name; ///< If set, pool memory is backed by POSIX shared memory with this base name, see @xal_attach() for sharing the pools across processes
+	bool verify_crc;      ///< XFS backend: verify the CRC32C of v5 metadata while decoding, see @xal_get_crc_stats()
+	enum xal_quiesce quiesce; ///< XFS backend: parse a mounted file system on-disk, after quiescing it as described by @xal_quiesce
+	uint32_t validate_every;  ///< XFS backend with quiesce: compare every n'th regular file against FIEMAP, replacing its extents on mismatch; 0 disables
+	uint32_t nthreads;        ///< XFS backend: number of threads decoding inode-chunks in xal_dinodes_retrieve() while reads are in flight; 0 reads and decodes inline; at most XAL_NTHREADS_MAX
+	uint32_t qdepth;          ///< XFS backend with nthreads: number of inode-chunk reads in flight; 0 selects a default; at most XAL_QDEPTH_MAX
+	bool compact_extents;     ///< Store extents in 16-byte records instead of 'struct xal_extent', read them via @xal_extent_get()
+	bool merge_extents;       ///< Coalesce the extents of a file which are contiguous both in the file and on the device, and have the same flag
+	enum xal_hugepages hugepages; ///< Back the pools by huge pages, reducing TLB misses when walking large indexes
+	bool memfd;               ///< Back the pools by anonymous memfds instead of named shared memory, see @xal_seal() and @xal_get_fds()
+	int prefault;             ///< Bitmask of 'enum xal_prefault' applied when opened, see @xal_prefault()
+	enum xal_numa_policy numa_policy; ///< Placement of the pool pages on NUMA nodes; see @xal_replicate() for node-local copies
+	int numa_node;            ///< The node of XAL_NUMA_BIND
 };
 
 struct xal_extent {
-	uint64_t start_offset;
-	uint64_t start_block;
-	uint64_t nblocks;
-	uint8_t flag;
+	uint64_t start_offset; ///< Offset in the file, in blocks
+	uint64_t start_block;  ///< Filesystem block number of the first block
+	uint64_t nblocks;      ///< Number of blocks
+	uint8_t flag;          ///< 1 when the extent is unwritten (preallocated), otherwise 0
 } __attribute__((packed));
 
 int
@@ -89,12 +156,12 @@ xal_extent_converted_pp(struct xal_extent_converted *extent);
 struct xal_inode;
 
 struct xal_dentries {
-	uint32_t inodes_idx; ///< Index of first child in xal->inodes pool
+	xal_idx_t inodes_idx; ///< Index of first child in xal->inodes pool
 	uint32_t count;      ///< Number of children; for directories
 };
 
 struct xal_extents {
-	uint32_t extent_idx; ///< Index of first extent in xal->extents pool
+	xal_idx_t extent_idx; ///< Index of first extent in xal->extents pool
 	uint32_t count;      ///< Number of extents
 };
 
@@ -103,16 +170,29 @@ union xal_inode_content {
 	struct xal_extents extents;
 };
 
+/**
+ * An inode in host-native format
+ *
+ * This is the "hot" part of an inode; the fields needed to walk the tree and to look up extents,
+ * packed in 32 bytes such that two inodes share a cache-line; 48 bytes with XAL_WIDE_INDEX. The
+ * "cold" part, the reference to the name, is kept in a parallel array of the same index; use
+ * xal_inode_name() to retrieve the name. Thus, an inode must be referenced by its location in the
+ * pool and not be copied.
+ */
 struct xal_inode {
 	uint64_t ino;  ///< Inode number of the directory entry; Should the AG be added here?
 	uint64_t size; ///< Size in bytes
 	union xal_inode_content content;
-	uint8_t ftype;			      ///< File-type (directory, filename, symlink etc.)
-	uint8_t namelen;		      ///< Length of the name; not counting nul-termination
-	char name[XAL_INODE_NAME_MAXLEN + 1]; ///< Name; not including nul-termination
-	uint8_t reserved[22];
-	uint32_t parent_idx;
+	xal_idx_t parent_idx; ///< Index of the parent inode; XAL_POOL_IDX_NONE for the root
+	uint16_t namelen;     ///< Length of the name; not counting nul-termination
+	uint8_t ftype;        ///< File-type (directory, filename, symlink etc.)
+#ifdef XAL_WIDE_INDEX
+	uint8_t reserved[5];
+#else
+	uint8_t reserved[1];
+#endif
 };
+XAL_STATIC_ASSERT(sizeof(struct xal_inode) == (sizeof(xal_idx_t) == 8 ? 48 : 32), "Incorrect size");
 
 /**
  * XAL
@@ -142,14 +222,49 @@ struct xal_sb {
 };
 
 struct xal_inode *
-xal_inode_at(struct xal *xal, uint32_t idx);
+xal_inode_at(struct xal *xal, xal_idx_t idx);
 
+/**
+ * Returns a pointer to the extent at the given index in the extents pool
+ *
+ * @return The extent, or NULL when opened with xal_opts.compact_extents, see xal_extent_get()
+ */
 struct xal_extent *
-xal_extent_at(struct xal *xal, uint32_t idx);
+xal_extent_at(struct xal *xal, xal_idx_t idx);
 
-uint32_t
+/**
+ * Retrieve the extent at the given index in the extents pool
+ *
+ * Works with both representations of the extents pool; that is, also when opened with
+ * xal_opts.compact_extents, in which case the extent is decoded from its 16-byte record.
+ *
+ * @param xal The xal struct obtained when opened with xal_open()
+ * @param idx Index of the extent, e.g. xal_extents.extent_idx + i
+ * @param extent Pointer to the extent to populate
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -ESTALE when the extent is beyond the pools mapped by a view, see xal_attach_refresh().
+ */
+int
+xal_extent_get(struct xal *xal, xal_idx_t idx, struct xal_extent *extent);
+
+xal_idx_t
 xal_inode_idx(struct xal *xal, struct xal_inode *inode);
 
+/**
+ * Returns the name of the given inode
+ *
+ * For the XFS backend this is the name of the directory entry, for the FIEMAP backend it is the
+ * absolute path of the file or directory. The root has an empty name.
+ *
+ * @param xal The xal struct obtained when opened with xal_open()
+ * @param inode The inode to retrieve the name of
+ *
+ * @return A nul-terminated string of inode->namelen characters; valid until the next xal_index()
+ */
+const char *
+xal_inode_name(struct xal *xal, const struct xal_inode *inode);
+
 int
 xal_inode_pp(struct xal *xal, struct xal_inode *inode);
 
@@ -215,12 +330,159 @@ xal_is_dirty(struct xal *xal);
 int
 xal_get_seq_lock(struct xal *xal);
 
+/**
+ * Begin a read-section of the index; waits while the index is being modified
+ *
+ * Anything read from the index within the read-section is only valid when xal_read_retry() returns
+ * false; a read-section is retried otherwise. Readers do not write to shared memory, thus, any
+ * number of them proceed concurrently with each other. A typical read-section is::
+ *
+ *   do {
+ *           seq = xal_read_begin(xal);
+ *           err = xal_get_inode(xal, path, &inode);
+ *           size = err ? 0 : inode->size;
+ *   } while (xal_read_retry(xal, seq));
+ *
+ * References obtained within a read-section are not to be dereferenced after it, nor across two
+ * xal_index(); copy out what is needed, e.g. with xal_read_extents().
+ *
+ * @param xal The xal struct obtained when opened with xal_open() or xal_attach()
+ *
+ * @return The even sequence to pass to xal_read_retry()
+ */
+int
+xal_read_begin(struct xal *xal);
+
+/**
+ * End the read-section begun by xal_read_begin(); returns true when it is to be retried, as the
+ * index was modified meanwhile and what was read may be inconsistent
+ *
+ * @param xal The xal struct obtained when opened with xal_open() or xal_attach()
+ * @param seq The sequence returned by xal_read_begin()
+ */
+bool
+xal_read_retry(struct xal *xal, int seq);
+
+/**
+ * Copy the extents of the file at index 'idx' of the inodes pool, consistently with concurrent
+ * modifications of the index
+ *
+ * The extents are decoded as by xal_extent_get(), within a read-section which is retried until no
+ * writer intervened. The index of an inode is stable until the next xal_index() or xal_compact().
+ *
+ * @param xal The xal struct obtained when opened with xal_open() or xal_attach()
+ * @param idx Index of the inode, see xal_inode_idx()
+ * @param extents Array of 'capacity' extents to populate
+ * @param capacity Number of extents that fit 'extents'
+ * @param count Pointer to store the number of extents of the file
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -ENOBUFS when the file has more than 'capacity' extents, of which the first 'capacity'
+ *         are copied.
+ */
+int
+xal_read_inode_extents(struct xal *xal, xal_idx_t idx, struct xal_extent *extents,
+		       uint32_t capacity, uint32_t *count);
+
+/**
+ * Returns the generation of the index; incremented each time an index is published
+ *
+ * An index is published by xal_index(), xal_index_done(), xal_compact() and by updates of
+ * XAL_WATCHMODE_EXTENT_UPDATE. For an xal obtained via xal_attach(), this is the generation of the
+ * producer; thus, a consumer can tell whether the index it attached to has been superseded.
+ *
+ * @param xal The xal struct obtained when opened with xal_open() or xal_attach()
+ */
+uint32_t
+xal_get_generation(struct xal *xal);
+
+/**
+ * Wait until the generation of the index differs from 'last_gen'
+ *
+ * The wait is a futex-wait on the generation, in shared memory when obtained via xal_attach();
+ * thus, any number of consumers sleep until the producer publishes an index, rather than polling
+ * xal_is_dirty(). A typical consumer loop is::
+ *
+ *   gen = xal_get_generation(view);
+ *   ... use the index ...
+ *   xal_wait_generation(view, gen, -1);
+ *   xal_attach_refresh(view);
+ *
+ * @param xal The xal struct obtained when opened with xal_open() or xal_attach()
+ * @param last_gen The generation last observed, see xal_get_generation()
+ * @param timeout_ms Maximum time to wait, in milliseconds; negative waits indefinitely
+ *
+ * @return On success, that is, the generation differs from 'last_gen', 0 is returned. On error,
+ *         negative errno is returned to indicate the error; -ETIMEDOUT when the timeout expired.
+ */
+int
+xal_wait_generation(struct xal *xal, uint32_t last_gen, int timeout_ms);
+
 const struct xal_sb *
 xal_get_sb(struct xal *xal);
 
 uint32_t
 xal_get_sb_blocksize(struct xal *xal);
 
+/**
+ * Metadata block types covered by CRC32C verification, see xal_opts.verify_crc
+ */
+enum xal_crc_blk {
+	XAL_CRC_BLK_IAB3   = 0, ///< Inode allocation B+tree blocks
+	XAL_CRC_BLK_BMA3   = 1, ///< Extent-list B+tree blocks; of files and directories
+	XAL_CRC_BLK_DIR3   = 2, ///< Directory data blocks; XDB3 and XDD3
+	XAL_CRC_BLK_DINODE = 3, ///< Inodes in on-disk-format
+	XAL_CRC_BLK_NTYPES = 4,
+};
+
+struct xal_crc_stats {
+	uint64_t nchecked[XAL_CRC_BLK_NTYPES];  ///< Number of verified blocks, per block type
+	uint64_t nmismatch[XAL_CRC_BLK_NTYPES]; ///< Number of blocks with a checksum mismatch, per block type
+};
+
+int
+xal_crc_stats_pp(struct xal_crc_stats *stats);
+
+/**
+ * Retrieve the CRC32C verification counters
+ *
+ * The counters accumulate over xal_dinodes_retrieve() and xal_index(). A mismatch does not fail
+ * decoding; it is counted, and the caller decides whether the resulting index is to be trusted,
+ * e.g. by re-reading or discarding it when any mismatch is reported.
+ *
+ * @param xal The xal struct obtained when opened with xal_open() and xal_opts.verify_crc set
+ * @param stats Pointer to the struct to populate
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error.
+ */
+int
+xal_get_crc_stats(struct xal *xal, struct xal_crc_stats *stats);
+
+struct xal_validate_stats {
+	uint64_t nfiles;    ///< Number of regular files indexed
+	uint64_t nsampled;  ///< Number of regular files compared against FIEMAP
+	uint64_t nmismatch; ///< Number of sampled files where the on-disk extents differ from FIEMAP
+	uint64_t nfallback; ///< Number of files where the extents were replaced by those from FIEMAP
+};
+
+int
+xal_validate_stats_pp(struct xal_validate_stats *stats);
+
+/**
+ * Retrieve the counters of validating the on-disk parse of a mounted file system
+ *
+ * A high 'nmismatch' relative to 'nsampled' means that the file system changed under the parse;
+ * the unsampled files are then likely stale as well and the index should be rebuilt, e.g. with
+ * XAL_QUIESCE_FREEZE or with the FIEMAP backend.
+ *
+ * @param xal The xal struct obtained when opened with xal_open() and xal_opts.validate_every set
+ * @param stats Pointer to the struct to populate
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error.
+ */
+int
+xal_get_validate_stats(struct xal *xal, struct xal_validate_stats *stats);
+
 typedef int (*xal_walk_cb)(struct xal *xal, struct xal_inode *inode, void *cb_args, int level);
 
 int
@@ -245,6 +507,23 @@ xal_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts);
 void
 xal_close(struct xal *xal);
 
+/**
+ * Mapped pool memory, as given to xal_from_pools()
+ */
+struct xal_pools_mem {
+	void *inodes;      ///< Mapping of the {shm_name}_inodes region; the root inode must be at index 0
+	void *inodes_cold; ///< Mapping of the {shm_name}_inodes_cold region
+	void *extents;     ///< Mapping of the {shm_name}_extents region
+	void *names;       ///< Mapping of the {shm_name}_names region
+	bool compact_extents; ///< Whether the producer was opened with xal_opts.compact_extents
+	size_t inodes_nbytes;      ///< Size of the mapping of inodes; see 'prefault' and 'replicate'
+	size_t inodes_cold_nbytes; ///< Size of the mapping of inodes_cold; see 'prefault' and 'replicate'
+	size_t extents_nbytes;     ///< Size of the mapping of extents; see 'prefault' and 'replicate'
+	size_t names_nbytes;       ///< Size of the mapping of names; see 'prefault' and 'replicate'
+	int prefault;              ///< Bitmask of 'enum xal_prefault' applied by xal_from_pools()
+	bool replicate;            ///< Create per-node replicas, see xal_replicate(); requires the sizes
+};
+
 /**
  * Construct a read-only xal from externally provided pool memory.
  *
@@ -256,17 +535,227 @@ xal_close(struct xal *xal);
  *
  * @param sb           Superblock metadata
  * @param mountpoint   Mountpoint of the file system
- * @param inodes_mem   Pointer to the mapped inode pool memory; the root inode must be at index 0
- * @param extents_mem  Pointer to the mapped extent pool memory
- * @param dirty        Pointer to an atomic bool in shared memory used as the dirty flag; typically
- *                     the mapping of the {shm_name}_dirty region created by the producer
+ * @param mem          Pointers to the mapped pool memory
+ * @param dirty        Pointer to an atomic bool used as the dirty flag; see xal_attach() for
+ *                     attaching to the dirty flag of the producer
  * @param out          Output pointer for the constructed xal
  *
+ * @return On success, 0. On error, negative errno; -EINVAL when 'mem' requests 'replicate' without
+ *         giving the size of every pool.
+ */
+int
+xal_from_pools(const struct xal_sb *sb, const char *mountpoint, const struct xal_pools_mem *mem,
+	       _Atomic bool *dirty, struct xal **out);
+
+/**
+ * Attach, read-only, to the index shared by a producer opened with xal_opts.shm_name
+ *
+ * The producer publishes a manifest, in the {shm_name}_manifest region, describing the index: the
+ * superblock, the index of the root, the representation of the extents and the mountpoint. This
+ * maps the manifest and the pools, at their current size, in one call; no information has to be
+ * passed from the producer out-of-band. The sequence lock and the dirty flag of the resulting xal
+ * are those of the producer, see xal_get_seq_lock() and xal_is_dirty().
+ *
+ * The pools grow as the producer re-indexes, and, with the FIEMAP backend, are replaced by new
+ * objects named after the epoch of the pools in the manifest; to observe an index published
+ * since, see xal_attach_refresh(). Pools replaced while attaching are opened again, under the
+ * names published since. xal_close() unmaps the manifest and the pools; unlinking them remains the
+ * responsibility of the producer.
+ *
+ * @param shm_name The xal_opts.shm_name given to xal_open() by the producer
+ * @param out Output pointer for the constructed xal
+ *
+ * @return On success, 0. On error, negative errno; -EPROTO when the manifest is not of this
+ *         version of the library, -EAGAIN when the pools kept being replaced.
+ */
+int
+xal_attach(const char *shm_name, struct xal **out);
+
+/**
+ * File descriptors of the memfds backing an index opened with xal_opts.memfd
+ */
+struct xal_fds {
+	int manifest;    ///< The manifest, as published in {shm_name}_manifest for named sharing
+	int inodes;      ///< The pool of 'struct xal_inode'
+	int inodes_cold; ///< The pool of 'struct xal_inode_cold'
+	int extents;     ///< The pool of extents, see xal_opts.compact_extents
+	int names;       ///< The pool of names
+};
+
+/**
+ * Seal the index of an xal opened with xal_opts.memfd, making it immutable
+ *
+ * The pools are remapped read-only and their memfds sealed against writes and resizing; hence a
+ * consumer receiving the descriptors, see xal_get_fds(), can rely on the index not changing under
+ * it, without checking the sequence lock. Thereafter, xal_index() and xal_compact() fail with
+ * -EPERM, and extent updates by the watcher mark the index dirty instead of applying them. To
+ * re-index, open a new xal and share its descriptors.
+ *
+ * While sealing, the pools are briefly inaccessible; the watcher is held off and readers in other
+ * processes retry, but readers of 'xal' in this process, including its snapshots, must not run
+ * during the call.
+ *
+ * @param xal The xal struct obtained when opened with xal_open() and xal_opts.memfd
+ *
+ * @return On success, 0. On error, negative errno; -EINVAL if not opened with xal_opts.memfd,
+ *         -EBUSY while the index is being modified.
+ */
+int
+xal_seal(struct xal *xal);
+
+/**
+ * Retrieve the memfds backing an index opened with xal_opts.memfd
+ *
+ * The descriptors remain owned by the xal and are closed by xal_close(); pass them to another
+ * process, e.g. via SCM_RIGHTS over a unix socket, and attach there using xal_attach_fds(). A
+ * re-index with the FIEMAP backend replaces the memfds of the pools; retrieve them again once the
+ * generation has advanced, see xal_wait_generation().
+ *
+ * @param xal The xal struct obtained when opened with xal_open() and xal_opts.memfd
+ * @param fds Output for the descriptors
+ *
+ * @return On success, 0. On error, -EINVAL if not opened with xal_opts.memfd.
+ */
+int
+xal_get_fds(struct xal *xal, struct xal_fds *fds);
+
+/**
+ * Attach, read-only, to the index given by the memfds retrieved via xal_get_fds()
+ *
+ * This is xal_attach() for descriptors instead of names; the descriptors are not closed, nor
+ * owned, by the resulting xal, and can be closed by the caller once attached.
+ *
+ * @param fds The descriptors, as received from the producer
+ * @param out Output pointer for the constructed xal
+ *
+ * @return On success, 0. On error, negative errno; -EPROTO when the manifest is not of this
+ *         version of the library.
+ */
+int
+xal_attach_fds(const struct xal_fds *fds, struct xal **out);
+
+/**
+ * Bring a view obtained via xal_attach() or xal_attach_fds() up to the index last published
+ *
+ * The manifest is read again. When the producer has grown the pools since, their mappings are
+ * extended in place, within the address space reserved when attaching, as given by the manifest;
+ * this is safe while other threads read the view. When the pools were replaced, that is, re-indexed
+ * with the FIEMAP backend, the objects named by the manifest are mapped instead and the previous
+ * mappings unmapped; no other thread may then read the view, nor hold references into it. Either
+ * way, snapshots and replicas of the view are not refreshed.
+ *
+ * A typical consumer loop is::
+ *
+ *   gen = xal_get_generation(view);
+ *   ... use the index ...
+ *   xal_wait_generation(view, gen, -1);
+ *   xal_attach_refresh(view);
+ *
+ * @param xal The view to refresh
+ *
+ * @return On success, 0. On error, negative errno; -EINVAL when 'xal' is not a view attached to
+ *         a manifest, -ESTALE when the pools attached by descriptor were replaced, in which case
+ *         attach to the descriptors retrieved again by the producer, see xal_get_fds().
+ */
+int
+xal_attach_refresh(struct xal *xal);
+
+/**
+ * Fault in, and optionally lock, the pools of the given xal
+ *
+ * The first lookups through a freshly opened, attached or constructed xal otherwise take a page
+ * fault on each page of the pools they touch. With XAL_PREFAULT_POPULATE the pools are faulted in
+ * before returning, with XAL_PREFAULT_WILLNEED the kernel is advised to read them ahead in the
+ * background. With XAL_PREFAULT_MLOCK the pools of inodes, extents and names are locked in memory;
+ * for an xal opened via xal_open(), so are the ranges allocated as the pools grow. The cold inodes
+ * are faulted in, but never locked.
+ *
+ * This is applied by xal_open() and xal_from_pools() given xal_opts.prefault and
+ * xal_pools_mem.prefault; call it directly, e.g. after xal_attach() or after re-indexing.
+ *
+ * @param xal The xal struct obtained when opened with xal_open(), xal_attach() or xal_from_pools()
+ * @param flags Bitmask of 'enum xal_prefault'
+ *
+ * @return On success, 0. On error, negative errno; -ENOMEM or -EPERM when locking exceeds
+ *         RLIMIT_MEMLOCK.
+ */
+int
+xal_prefault(struct xal *xal, int flags);
+
+/**
+ * Take a read-only, point-in-time snapshot of the index, for long reads such as xal_walk()
+ *
+ * Readers of the snapshot need not retry on the sequence lock, as the snapshot does not change;
+ * the writer, e.g. the watcher updating extents, continues once it is taken. For an xal opened via
+ * xal_open() the snapshot is cheap: only the inodes are copied, once, while the watcher is held
+ * off; extents are updated copy-on-write, and released extents are neither reused nor freed, as
+ * long as a snapshot is open; they are freed by the writer once the snapshots are closed.
+ * Meanwhile, xal_index() and xal_compact() fail with -EBUSY. For a view, e.g. of xal_attach(),
+ * the writer is another process, thus, all pools are copied, and the copy is retried when the
+ * writer intervened.
+ *
+ * Release the snapshot via xal_close(), before closing 'xal'.
+ *
+ * @param xal The xal struct obtained when opened with xal_open(), xal_attach() or xal_from_pools()
+ * @param snapshot Output pointer for the snapshot
+ *
+ * @return On success, 0. On error, negative errno; -EBUSY between xal_index_begin() and
+ *         xal_index_done(), -EAGAIN when the index of a view kept changing while copying.
+ */
+int
+xal_snapshot(struct xal *xal, struct xal **snapshot);
+
+/**
+ * Create a read-only replica of the index on each online NUMA node
+ *
+ * Each replica is a private copy of the pools, as they are when called, with its pages bound to
+ * the node; select the replica of the calling thread via xal_replica(). Replicas are snapshots:
+ * xal_get_generation() of a replica is that of 'xal' at the time of replication, and the dirty
+ * flag is shared with 'xal'. Calling this again, e.g. after re-indexing, replaces the replicas;
+ * the caller must ensure that no thread uses the replaced replicas, as when closing an xal.
+ * xal_close() releases the replicas.
+ *
+ * @param xal The xal struct obtained when opened with xal_open(), xal_attach() or xal_from_pools()
+ *
+ * @return On success, 0. On error, negative errno; -EBUSY while the index is being modified.
+ */
+int
+xal_replicate(struct xal *xal);
+
+/**
+ * Return the replica of the NUMA node of the calling CPU, see xal_replicate()
+ *
+ * Intended to be called once per request, or when a thread is (re)scheduled, rather than per
+ * lookup; the returned xal is read-only and valid until xal_replicate() or xal_close() of 'xal'.
+ *
+ * @return The replica of the node, or 'xal' itself when there is no replica of the node.
+ */
+struct xal *
+xal_replica(struct xal *xal);
+
+/**
+ * Number of bytes of each pool which are resident in memory, see xal_get_resident()
+ */
+struct xal_resident {
+	size_t inodes;      ///< Resident bytes of the pool of 'struct xal_inode'
+	size_t inodes_cold; ///< Resident bytes of the pool of 'struct xal_inode_cold'
+	size_t extents;     ///< Resident bytes of the pool of extents
+	size_t names;       ///< Resident bytes of the pool of names
+};
+
+/**
+ * Retrieve the resident set of the pools, as reported by mincore()
+ *
+ * Only the allocated part of each pool is inspected; for an xal constructed via xal_from_pools(),
+ * this requires the sizes in 'struct xal_pools_mem'.
+ *
+ * @param xal The xal struct obtained when opened with xal_open(), xal_attach() or xal_from_pools()
+ * @param resident Output for the number of resident bytes
+ *
  * @return On success, 0. On error, negative errno.
  */
 int
-xal_from_pools(const struct xal_sb *sb, const char *mountpoint, void *inodes_mem,
-	void *extents_mem, _Atomic bool *dirty, struct xal **out);
+xal_get_resident(struct xal *xal, struct xal_resident *resident);
 
 /**
  * Retrieve inodes from disk and decode the on-disk-format of the retrieved data
@@ -291,6 +780,83 @@ xal_dinodes_retrieve(struct xal *xal);
 int
 xal_index(struct xal *xal);
 
+/**
+ * Relayout the index for locality of walks and lookups
+ *
+ * The inodes are rearranged in breadth-first order, starting with the root at index 0; the
+ * children of a directory remain consecutive and in the same order, and the extents of the files
+ * in a directory are stored adjacent to each other, in the order of the files. Space left by
+ * released extents and inodes no longer reachable is reclaimed. The names are not moved.
+ *
+ * The relayout is published under the sequence lock, and the inotify watcher, if any, is held off
+ * meanwhile; thus, it can run while the index is watched. Indices and pointers to inodes and
+ * extents retrieved before the call are invalid after it.
+ *
+ * @param xal The xal struct obtained when opened with xal_open()
+ *
+ * @returns On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *          -EBUSY when the index is being modified, e.g. between xal_index_begin() and
+ *          xal_index_done(), or pinned by snapshots, see xal_snapshot().
+ */
+int
+xal_compact(struct xal *xal);
+
+struct xal_index_progress {
+	uint32_t nags_walked;     ///< Number of allocation groups whose inode B+tree has been walked
+	uint64_t nchunks;         ///< Number of inode-chunks located; final once all AGs are walked
+	uint64_t nchunks_decoded; ///< Number of inode-chunks read and decoded
+	uint64_t ninodes;         ///< Number of inodes processed into the directory tree
+	uint64_t npending;        ///< Number of inodes discovered but not yet processed
+};
+
+/**
+ * Begin incremental indexing; an alternative to xal_dinodes_retrieve() and xal_index()
+ *
+ * The work is done by repeated calls to xal_index_step(), each bounded by a budget, such that
+ * indexing can be interleaved with other work on the same thread, e.g. in a run-to-completion
+ * poller. If the inodes were retrieved already with xal_dinodes_retrieve(), then the steps
+ * start at building the directory tree.
+ *
+ * The sequence lock is odd from this call until xal_index_done().
+ *
+ * @param xal The xal struct obtained when opened with xal_open() with the XFS backend
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -ENOSYS for backends other than XFS, and -EBUSY when indexing is already in progress.
+ */
+int
+xal_index_begin(struct xal *xal);
+
+/**
+ * Perform at most 'budget' units of indexing work
+ *
+ * A unit is the walk of the inode allocation B+tree of one allocation group, the decoding of one
+ * inode-chunk, or the processing of one inode into the directory tree. Inode-chunks are read via
+ * non-blocking submissions when the device supports an asynchronous queue, in which case the call
+ * returns -EAGAIN early when no reads have completed. The B+tree and directory blocks of a unit
+ * are read synchronously.
+ *
+ * @param xal The xal struct given to xal_index_begin()
+ * @param budget Maximum units of work to perform
+ * @param progress Optional pointer to progress counters to populate
+ *
+ * @return 0 when indexing is complete, -EAGAIN when there is more work to do, otherwise negative
+ *         errno indicating the error.
+ */
+int
+xal_index_step(struct xal *xal, uint32_t budget, struct xal_index_progress *progress);
+
+/**
+ * End incremental indexing, releasing the resources of the steps
+ *
+ * When called before xal_index_step() returned 0, indexing is aborted and the representation is
+ * left dirty, see xal_is_dirty().
+ *
+ * @return 0 when indexing completed, -ECANCELED when aborted, otherwise negative errno.
+ */
+int
+xal_index_done(struct xal *xal);
+
 /**
  * Callback invoked by the background watch thread immediately after the xal struct is marked
  * dirty. Dirty means breaking filesystem changes (file creation, deletion, or rename) were
@@ -347,7 +913,9 @@ xal_stop_watching_filesystem(struct xal *xal);
  *   * Directory
  *   * Regular file
  *
- * Returns 0 on success. On error, negative errno is returned to indicate the error.
+ * Returns 0 on success. On error, negative errno is returned to indicate the error; -ESTALE when
+ * the file system has changed, see xal_is_dirty(), or, for a view, when the index has outgrown the
+ * pools it maps, see xal_attach_refresh().
  */
 int
 xal_walk(struct xal *xal, struct xal_inode *inode, xal_walk_cb cb_func, void *cb_data);
@@ -430,6 +998,30 @@ xal_build_lookup_hashmap(struct xal *xal);
 int
 xal_get_extents(struct xal *xal, char *path, struct xal_extents **extents);
 
+/**
+ * Copy the extents of the file at the given path, consistently with concurrent modifications of
+ * the index, e.g. by XAL_WATCHMODE_EXTENT_UPDATE or xal_index()
+ *
+ * The lookup, as by xal_get_inode(), and the copy, as by xal_read_inode_extents(), are within one
+ * read-section, retried until no writer intervened.
+ *
+ * With XAL_FILE_LOOKUPMODE_HASHMAP, the lookup probes the map of paths, which xal_index() and
+ * xal_build_lookup_hashmap() replace; a replaced map is destroyed once no lookup probes it.
+ * Note: File system must be mounted and xal opened with backend FIEMAP.
+ *
+ * @param xal The xal struct obtained when opened with xal_open()
+ * @param path Absolute path to the file
+ * @param extents Array of 'capacity' extents to populate
+ * @param capacity Number of extents that fit 'extents'
+ * @param count Pointer to store the number of extents of the file
+ *
+ * @returns On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *          -ENOBUFS when the file has more than 'capacity' extents.
+ */
+int
+xal_read_extents(struct xal *xal, char *path, struct xal_extent *extents, uint32_t capacity,
+		 uint32_t *count);
+
 /**
  * Retrieve the directory entries for the directory at the given path.
  * 
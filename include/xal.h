@@ -8,12 +8,91 @@
 #define ODF_BLOCK_DIR_BYTES_MAX 64UL * 1024 ///< Maximum size of a directory block
 #define ODF_BLOCK_FS_BYTES_MAX 64UL * 1024  ///< Maximum size of a filestem block
 #define ODF_INODE_MAX_NBYTES 2048	    ///< Maximum size of an inode
-#define XAL_BACKEND_SIZE 64
+#define XAL_BACKEND_SIZE 256
+#define XAL_POOL_RESERVED_MIN (1UL << 20) ///< Headroom of the inode and extent pools, in elements
+#define XAL_POOL_NAMES_GROWBY (1UL << 20) ///< Minimum bytes of names to allocate at a time
+
+#define XAL_MEMFD_NAME "xal" ///< Base name of memfds when xal_opts.shm_name is not given
+#define XAL_SNAPSHOT_ATTEMPTS 1000 ///< Number of attempts at copying a consistent snapshot of a view
+#define XAL_ATTACH_ATTEMPTS 100 ///< Number of attempts at opening the pools of a published epoch
+#define XAL_READ_SPINS 64 ///< Number of polls of an odd sequence lock before xal_read_begin() yields
+#define XAL_MANIFEST_MAGIC 0x4d4c4158 ///< "XALM" in little-endian
+#ifdef XAL_WIDE_INDEX
+#define XAL_MANIFEST_VERSION 0x10003 ///< Version 3 with 64-bit indexes, see xal_idx_t
+#else
+#define XAL_MANIFEST_VERSION 3
+#endif
+
+/**
+ * Bits of 'xal_manifest.pools_hugetlb'; set for the pools which are files in XAL_POOL_HUGETLBFS
+ * rather than POSIX shared memory objects
+ */
+enum xal_manifest_pool {
+	XAL_MANIFEST_POOL_INODES      = 1 << 0,
+	XAL_MANIFEST_POOL_INODES_COLD = 1 << 1,
+	XAL_MANIFEST_POOL_EXTENTS     = 1 << 2,
+	XAL_MANIFEST_POOL_NAMES	      = 1 << 3,
+};
+
+/**
+ * Describes a shared index; published by the producer in the {shm_name}_manifest region
+ *
+ * Along with the names of the pools, derived from the same 'shm_name' and 'pools_epoch', see
+ * xal_pools_name(), this is all a consumer needs to attach to the index, see xal_attach(). The
+ * fields below 'generation' are updated by xal_manifest_update(), within the write-section of
+ * 'seq_lock'.
+ */
+struct xal_manifest {
+	uint32_t magic;		 ///< XAL_MANIFEST_MAGIC
+	uint32_t version;	 ///< XAL_MANIFEST_VERSION; the layout of this struct and of the pools
+	atomic_int seq_lock;	 ///< The sequence lock of the producer, see xal_get_seq_lock()
+	atomic_uint generation;	 ///< Incremented each time the index is published; a futex word
+	atomic_bool dirty;	 ///< The dirty flag of the producer, see xal_is_dirty()
+	bool compact_extents;	 ///< Whether the extents pool holds 'struct xal_extent_compact'
+	uint8_t backend;	 ///< The 'enum xal_backend' of the producer
+	uint8_t pools_hugetlb;	 ///< Bitmask of 'enum xal_manifest_pool'
+	uint32_t pools_epoch;	 ///< Epoch of the pool objects, see xal_pools_name()
+	xal_idx_t root_idx;	 ///< Index of the root inode
+	uint64_t ninodes;	 ///< Number of inodes in use; also the number of cold inodes
+	uint64_t nextents;	 ///< Number of extent records in use
+	uint64_t nnames;	 ///< Number of bytes of names in use
+	uint64_t pools_reserved[4]; ///< Bytes of address space reserved by the pools of inodes,
+				    ///< cold inodes, extents and names; views reserve as much
+	struct xal_sb sb;
+	char mountpoint[XAL_PATH_MAXLEN + 1]; ///< Mountpoint; the FIEMAP backend only
+};
+
+/**
+ * The cold part of an inode, stored at the same index as the inode in xal->inodes_cold
+ */
+struct xal_inode_cold {
+	uint64_t name_ofz; ///< Offset of the name in the pool of names
+};
+
+/**
+ * An extent in the compact representation of the extents pool, see xal_opts.compact_extents
+ *
+ * The bit-layout is that of the XFS on-disk extent record, but in host-endianess:
+ *
+ *   l0: flag[63] | start_offset[62:9] | start_block[51:43] in [8:0]
+ *   l1: start_block[42:0] in [63:21] | nblocks[20:0]
+ */
+struct xal_extent_compact {
+	uint64_t l0;
+	uint64_t l1;
+};
+
+#define XAL_EXTENT_COMPACT_OFFSET_MAX ((1ULL << 54) - 1)
+#define XAL_EXTENT_COMPACT_BLOCK_MAX ((1ULL << 52) - 1)
+#define XAL_EXTENT_COMPACT_NBLOCKS_MAX ((1ULL << 21) - 1)
 
 struct xal_backend_base {
 	enum xal_backend type;
 	int (*index)(struct xal *xal);
 	void (*close)(struct xal *xal);
+	void (*relocate)(struct xal *xal, const xal_idx_t *inodes_map); ///< See xal_compact(); optional
+	void (*lock)(struct xal *xal);   ///< See xal_writer_lock(); optional
+	void (*unlock)(struct xal *xal); ///< See xal_writer_unlock(); optional
 };
 
 /**
@@ -26,13 +105,232 @@ struct xal_backend_base {
  */
 struct xal {
 	struct xnvme_dev *dev;
-	struct xal_pool inodes;  ///< Pool of inodes in host-native format
+	struct xal_pool inodes;  ///< Pool of inodes in host-native format; the hot part
+	struct xal_pool inodes_cold; ///< Pool of 'struct xal_inode_cold', parallel to 'inodes'
 	struct xal_pool extents; ///< Pool of extents in host-native format
-	uint32_t root_idx;       ///< Index of the root inode in the inodes pool
+	struct xal_pool names;   ///< Pool of nul-terminated inode names, referenced by offset
+	xal_idx_t root_idx;      ///< Index of the root inode in the inodes pool
 	struct xal_sb sb;
 	uint8_t be[XAL_BACKEND_SIZE];
 	atomic_bool *dirty;      ///< Whether the file system has changed since last index; may point to external shared memory
 	atomic_bool _dirty_storage; ///< Backing store for dirty when no external pointer is provided
-	atomic_int seq_lock;     ///< An uneven number indicates the struct is being modified and is not safe to read
+	atomic_int *seq_lock;    ///< An uneven number indicates the struct is being modified and is not safe to read; may point to the manifest
+	atomic_int _seq_lock_storage; ///< Backing store for seq_lock when there is no manifest
+	atomic_uint *generation; ///< Incremented when the index is published; may point to the manifest
+	atomic_uint _generation_storage; ///< Backing store for generation when there is no manifest
+	struct xal_manifest *manifest; ///< Mapping of the {shm_name}_manifest region; NULL unless shared
+	int manifest_fd;         ///< The memfd of the manifest with xal_opts.memfd; -1 otherwise
+	atomic_bool sealed;      ///< If true, the pools are sealed by xal_seal() and cannot be modified
+	struct xal *replicas[XAL_POOL_NUMA_NODES_MAX]; ///< Per-node read-only copies, see xal_replicate()
+	atomic_int snapshots;    ///< Number of open snapshots, see xal_snapshot(); while non-zero, extents are updated copy-on-write
+	atomic_int snapshots_epoch; ///< Lower bound of the sequence lock of the open snapshots; extents released since are not reused
+	struct xal *snapshot_of; ///< For a snapshot, the xal it pins; NULL otherwise
+	struct xal_extents *deferred; ///< Extent records released while pinned by snapshots; freed once unpinned, see xal_extents_release()
+	size_t ndeferred;        ///< Number of ranges in 'deferred'
+	size_t deferred_capacity; ///< Number of ranges 'deferred' is allocated for
+	struct xal *standby;     ///< The pools of the previous generation, re-indexed into by xal_pools_stage(); NULL until then
+	char *shm_name;          ///< Base name of the objects of shared pools, see xal_pools_name(); NULL for private pools
+	uint32_t pools_epoch;    ///< Incremented by xal_pools_publish(), as the pools are replaced
 	bool shared_view;        ///< If true, pool memory is owned externally; xal_close() will not unmap it
+	bool attached;           ///< If true, the pools and manifest are mapped by xal_attach() and unmapped by xal_close()
+	bool compact_extents;    ///< If true, the extents pool holds 'struct xal_extent_compact'
+	bool merge_extents;      ///< If true, contiguous extents are coalesced, see xal_extents_merge()
 };
+
+/**
+ * Map the pools of inodes, extents and names as described by xal_opts.shm_name and
+ * xal_opts.compact_extents
+ *
+ * The address space reserved for each pool is sized from the file system: the inodes from the
+ * number of allocated inodes, doubled to leave room for hard links and growth, the names from
+ * the maximum name length of each, and the extents from the number of blocks, as no file system
+ * can have more extents than blocks. Both capped by the range of xal_idx_t.
+ *
+ * @param xal The xal whose pools to map
+ * @param ninodes Number of allocated inodes in the file system; allocated upfront
+ * @param nblocks Number of blocks in the file system
+ * @param opts The options given to xal_open()
+ */
+int
+xal_pools_map(struct xal *xal, size_t ninodes, size_t nblocks, const struct xal_opts *opts);
+
+/**
+ * Name, into 'name' of 'len' bytes, the object of a shared pool with 'suffix', e.g. "_inodes", of
+ * the pools of 'epoch'
+ *
+ * The objects of odd epochs are suffixed by "_1", e.g. {shm_name}_inodes_1; thus, a re-index
+ * creates the objects of the new pools while those published remain in place, see
+ * xal_pools_stage().
+ */
+void
+xal_pools_name(char *name, size_t len, const char *shm_name, const char *suffix, uint32_t epoch);
+
+/**
+ * Write the state of the index to the manifest, if any; to be called within the write-section
+ */
+void
+xal_manifest_update(struct xal *xal);
+
+/**
+ * Publish the state of the index in the manifest, if any, see xal_manifest_update(), increment
+ * the generation and wake the waiters of xal_wait_generation()
+ *
+ * To be called at the end of a modification of the index, while the sequence lock is odd; or, for
+ * modifications not guarded by the sequence lock, such as xal_index() with the XFS backend, once
+ * done.
+ */
+void
+xal_manifest_publish(struct xal *xal);
+
+/**
+ * Exclude the writer of the backend running in this process, e.g. the inotify watcher, which takes
+ * it around each of its updates; a no-op for backends without one
+ *
+ * Writers outside of the backend, such as xal_compact(), take it before entering the write-section,
+ * as the write-section itself does not exclude other writers.
+ */
+void
+xal_writer_lock(struct xal *xal);
+
+/**
+ * Release what xal_writer_lock() took
+ */
+void
+xal_writer_unlock(struct xal *xal);
+
+/**
+ * Enter the write-section of the sequence lock, see xal_read_begin()
+ *
+ * The increment is relaxed, followed by a release fence, ordering it before the stores of the
+ * modification; rather than a sequentially consistent read-modify-write.
+ */
+void
+xal_write_begin(struct xal *xal);
+
+/**
+ * Leave the write-section of the sequence lock, releasing the stores of the modification
+ */
+void
+xal_write_end(struct xal *xal);
+
+/**
+ * Copy up to 'capacity' extents of the inode at 'idx' within the read-section begun at 'seq'
+ *
+ * The caller validates the copy with xal_read_retry(); the pools are only addressed within the
+ * bounds observed in the read-section, thus, a copy racing a writer is torn but does not fault.
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -EAGAIN when a writer intervened before the copy, and as xal_read_inode_extents().
+ */
+int
+xal_inode_extents_copy(struct xal *xal, int seq, xal_idx_t idx, struct xal_extent *extents,
+		       uint32_t capacity, uint32_t *count);
+
+/**
+ * Reset the pools of inodes, extents and names to empty, e.g. before re-indexing
+ */
+void
+xal_pools_clear(struct xal *xal);
+
+/**
+ * Prepare the standby pools of a double-buffered index, and a copy of 'xal' using them, into which
+ * a new index is built while readers continue on the published one; see xal_pools_publish()
+ *
+ * The standby pools are mapped, alike the pools of 'xal', on first use; thereafter, they hold the
+ * previous generation of the index, which is reclaimed here. Thus, a reader holding references
+ * into the index must not hold them across two re-indexes. Shared standby pools are backed by new
+ * objects, named for the next epoch of the pools, see xal_pools_name(), which replace the objects
+ * of the previous generation; consumers still mapping those keep their content.
+ *
+ * @param xal The xal to re-index
+ * @param staged Pointer to store the copy of 'xal' to build the index into; owned by 'xal'
+ */
+int
+xal_pools_stage(struct xal *xal, struct xal **staged);
+
+/**
+ * Publish the index built by xal_pools_stage() in place of that of 'xal'; to be called within the
+ * write-section of the sequence lock
+ *
+ * The pools are swapped with the standby pools, thus, the pools of the previous generation stay
+ * mapped and intact until the next xal_pools_stage(), and the write-section does not depend on
+ * the size of the index. The epoch of the pools is incremented; for shared pools, consumers
+ * follow the manifest, see xal_manifest_update(), onto the new objects.
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -EINVAL when there is no staged index.
+ */
+int
+xal_pools_publish(struct xal *xal);
+
+/**
+ * Claim 'count' consecutive inodes, along with their cold part
+ *
+ * @param xal The xal to claim inodes from
+ * @param count Number of inodes to claim
+ * @param idx Pointer to store the index of the first claimed inode
+ */
+int
+xal_inodes_claim(struct xal *xal, size_t count, xal_idx_t *idx);
+
+/**
+ * Store 'namelen' characters of 'name', nul-terminated, in the pool of names and reference it
+ * from the given inode; the inode must be claimed via xal_inodes_claim()
+ */
+int
+xal_inode_name_set(struct xal *xal, struct xal_inode *inode, const char *name, size_t namelen);
+
+/**
+ * Returns the number of records needed to store an extent of 'nblocks' in the extents pool
+ *
+ * This is one, except with compact extents, where an extent longer than
+ * XAL_EXTENT_COMPACT_NBLOCKS_MAX is split, e.g. when FIEMAP reports adjacent XFS extents as one.
+ */
+uint32_t
+xal_extent_nrecords(struct xal *xal, uint64_t nblocks);
+
+/**
+ * Store the given extent in the extents pool at 'idx', using xal_extent_nrecords() records
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -EOVERFLOW when the extent does not fit the compact representation.
+ */
+int
+xal_extent_set(struct xal *xal, xal_idx_t idx, const struct xal_extent *extent);
+
+/**
+ * Claim 'count' consecutive extent records, recycling released records when possible
+ *
+ * Records released by the current update, that is, at the current value of xal->seq_lock, are not
+ * recycled; see xal_pool_claim_recycled().
+ */
+int
+xal_extents_claim(struct xal *xal, size_t count, xal_idx_t *idx);
+
+/**
+ * Release the 'count' extent records at 'idx'; when at the end of the pool, the pool is shrunk,
+ * otherwise the records are put on a free-list for xal_extents_claim()
+ *
+ * The free-list is kept in the first record of a released range, thus, while snapshots are open,
+ * which may reference the records, the release is deferred until the writer finds them closed.
+ */
+int
+xal_extents_release(struct xal *xal, xal_idx_t idx, size_t count);
+
+/**
+ * Whether snapshots of 'xal' are open, see xal_snapshot(); to be called by the writer while holding
+ * xal_writer_lock(), under which snapshots are pinned, such that a snapshot is either seen here or
+ * taken after the modification
+ */
+bool
+xal_pinned(struct xal *xal);
+
+/**
+ * Coalesce runs of the given extents which are contiguous both in the file and on the device,
+ * and have the same flag
+ *
+ * The extents are merged in place; the records no longer used are released via
+ * xal_extents_release().
+ */
+int
+xal_extents_merge(struct xal *xal, struct xal_extents *extents);
@@ -3,13 +3,40 @@ struct xal_be_fiemap {
 	char *mountpoint;      ///< Path to mountpoint of dev
 	struct xal_inotify *inotify;
 	void *path_inode_map;  ///< Map of paths to inodes
+	atomic_int path_inode_probes; ///< Lookups probing the map, see xal_get_inode()
 
-	uint8_t _rsvd[16];
+	uint8_t _rsvd[180];
 };
 XAL_STATIC_ASSERT(sizeof(struct xal_be_fiemap) == XAL_BACKEND_SIZE, "Incorrect size");
 
 void
 xal_be_fiemap_close(struct xal *xal);
 
+/**
+ * Exclude the inotify watcher from updating the index, see xal_writer_lock()
+ */
+void
+xal_be_fiemap_lock(struct xal *xal);
+
+void
+xal_be_fiemap_unlock(struct xal *xal);
+
+/**
+ * Update the inode pointers of the lookup and inotify hash-maps after xal_compact()
+ */
+void
+xal_be_fiemap_relocate(struct xal *xal, const xal_idx_t *inodes_map);
+
 int
 xal_be_fiemap_open(struct xal **xal, char *mountpoint, struct xal_opts *opts);
+
+struct fiemap;
+
+/**
+ * Retrieve the extent-map of the file at 'path' via FS_IOC_FIEMAP
+ *
+ * On success, '*fiemap' is allocated with 'fm_mapped_extents' populated entries; the caller is
+ * responsible for free()'ing it.
+ */
+int
+xal_be_fiemap_retrieve(const char *path, struct fiemap **fiemap);
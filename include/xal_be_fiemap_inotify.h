@@ -4,6 +4,8 @@ struct xal_inotify {
 	enum xal_watchmode watch_mode;
 	int fd;           ///< File descriptor for inotify events, if opened with some xal_watchmode, else 0
 	void *inode_map;  ///< Map of inodes from inotify watch descriptors
+	void *inode_map_retired; ///< The map of the previous generation of the index, see xal_be_fiemap_inotify_publish()
+	pthread_mutex_t lock; ///< Held by the watcher while updating the index, and by xal_index() while publishing
 	pthread_t watch_thread_id;
 	int flag;
 	xal_dirty_cb cb;
@@ -27,5 +29,41 @@ xal_be_fiemap_inotify_init(struct xal_inotify *inotify, enum xal_watchmode watch
 int
 xal_be_fiemap_inotify_clear_inode_map(struct xal_inotify *inotify);
 
+/**
+ * Initialize 'staged' to add watches as 'inotify' does, into an empty watch descriptor to inode
+ * hash table; its lock is not initialized, thus, it is only for xal_be_fiemap_inotify_add_watcher()
+ *
+ * Used by xal_index() to add the watches of an index built aside from the published one; the
+ * table is either swapped in by xal_be_fiemap_inotify_publish() or destroyed by
+ * xal_be_fiemap_inotify_discard().
+ */
+int
+xal_be_fiemap_inotify_stage(struct xal_inotify *inotify, struct xal_inotify *staged);
+
+/**
+ * Replace the watch descriptor to inode hash table of 'inotify' by that of 'staged'
+ *
+ * The replaced table is kept until the next publish, as the index it points into.
+ */
+void
+xal_be_fiemap_inotify_publish(struct xal_inotify *inotify, struct xal_inotify *staged);
+
+/**
+ * Destroy the watch descriptor to inode hash table of a 'staged' which is not to be published
+ */
+void
+xal_be_fiemap_inotify_discard(struct xal_inotify *staged);
+
+/**
+ * Update the watch descriptor to inode hash table after the inodes are relocated by xal_compact()
+ *
+ * @param inotify  Pointer to the xal_inotify struct.
+ * @param xal  The xal whose inodes are relocated
+ * @param inodes_map  The new index of each inode, by its old index
+ */
+void
+xal_be_fiemap_inotify_relocate(struct xal_inotify *inotify, struct xal *xal,
+			       const xal_idx_t *inodes_map);
+
 int
 xal_be_fiemap_inotify_add_watcher(struct xal_inotify *inotify, char *path, struct xal_inode *inode);
@@ -15,16 +15,53 @@ struct xal_ag {
 	uint32_t agi_level;  ///< levels in inode btree
 };
 
+/**
+ * Geometry derived from the superblock at xal_open()
+ *
+ * These replace divisions and multiplications by runtime values, e.g. 'sb.blocksize', with shifts
+ * and masks in the decoding paths.
+ */
+struct xal_be_xfs_geo {
+	uint8_t blocklog;     ///< log2 of sb.blocksize
+	uint8_t inodelog;     ///< log2 of sb.inodesize
+	uint8_t dirblkfsblog; ///< log2 of the number of fs-blocks in a directory block
+	uint8_t agblklog;     ///< log2 of sb.agblocks (rounded up)
+	uint8_t _rsvd[4];
+	uint64_t agbno_mask;  ///< Mask for the AG-relative block number of a fsbno
+};
+
+/**
+ * Decoders specialised for a given geometry, see xal_be_xfs.c
+ */
+struct xal_be_xfs_decoders;
+
+/**
+ * State of incremental indexing, see xal_index_begin() and xal_be_xfs.c
+ */
+struct xal_be_xfs_step;
+
 struct xal_be_xfs {
 	struct xal_backend_base base;
 	void *buf;            ///< A single buffer for repetitive IO
 	uint8_t *dinodes;     ///< Array of inodes in on-disk-format
 	void *dinodes_map;    ///< Map of dinodes for O(1) ~ avg. lookup
 	struct xal_ag *ags;   ///< Array of 'agcount' number of allocation-groups
+	bool verify_crc;      ///< Whether to verify CRC32C of metadata blocks as they are decoded
+	struct xal_crc_stats crc_stats;
+	struct xal_be_xfs_geo geo;
+	const struct xal_be_xfs_decoders *decoders; ///< Selected at xal_open() from the geometry
+	char *mountpoint;     ///< Mountpoint of dev; only set when parsing a mounted file system
+	enum xal_quiesce quiesce;
+	uint32_t validate_every;
+	int freeze_fd;        ///< Descriptor of the mountpoint while frozen; -1 otherwise
+	struct xal_validate_stats validate_stats;
+	uint32_t nthreads;    ///< Number of decoder threads in xal_dinodes_retrieve(); 0 for inline
+	uint32_t qdepth;      ///< Number of inode-chunk reads in flight when 'nthreads' > 0
+	struct xal_be_xfs_step *step; ///< Set between xal_index_begin() and xal_index_done()
 
 	uint8_t _rsvd[8];
 };
 XAL_STATIC_ASSERT(sizeof(struct xal_be_xfs) == XAL_BACKEND_SIZE, "Incorrect size");
 
 int
-xal_be_xfs_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts);
+xal_be_xfs_open(struct xnvme_dev *dev, struct xal **xal, char *mountpoint, struct xal_opts *opts);
@@ -0,0 +1,30 @@
+/**
+ * CRC32C (Castagnoli) as used by XFS v5 to protect metadata blocks
+ *
+ * The implementation is selected on first use: SSE4.2 on x86_64, the ARMv8 CRC extension on
+ * aarch64, and a table-driven slice-by-8 fallback everywhere else.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Update 'crc' with 'len' bytes of 'buf'; no pre- or post-inversion is applied
+ */
+uint32_t
+xal_crc32c(uint32_t crc, const void *buf, size_t len);
+
+/**
+ * Verify the XFS checksum of a metadata buffer
+ *
+ * XFS computes the checksum over the entire buffer with the four-byte checksum field treated as
+ * zero, and stores the inverted result in little-endian format at 'cksum_ofz'.
+ *
+ * @param buf Buffer in on-disk format; that is, before any endianess conversion
+ * @param nbytes Size of the buffer covered by the checksum, e.g. the block or inode size
+ * @param cksum_ofz Offset, in bytes, of the checksum field within the buffer
+ *
+ * @return True if the stored checksum matches the computed one, false otherwise.
+ */
+bool
+xal_crc32c_verify(const void *buf, size_t nbytes, size_t cksum_ofz);
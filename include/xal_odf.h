@@ -57,6 +57,15 @@ typedef struct {
 #define XAL_ODF_DIR3_BLOCK_MAGIC 0x58444233 /* XDB3: single block dirs */
 #define XAL_ODF_DIR3_DATA_MAGIC 0x58444433  /* XDD3: multiblock dirs */
 
+/**
+ * The logical address space of a directory is split into segments of XAL_ODF_DIR2_SPACE_SIZE
+ * bytes; directory entries are in data blocks (XDB3/XDD3) in the first segment, followed by the
+ * leaf (hash index) segment and the free-index segment.
+ */
+#define XAL_ODF_DIR2_SPACE_SIZE (1ULL << 35)
+#define XAL_ODF_DIR2_LEAF_OFFSET (1ULL * XAL_ODF_DIR2_SPACE_SIZE) ///< Logical offset of leaf blocks
+#define XAL_ODF_DIR2_FREE_OFFSET (2ULL * XAL_ODF_DIR2_SPACE_SIZE) ///< Logical offset of free-index blocks
+
 #define XAL_ODF_BMAP_CRC_MAGIC 0x424d4133 /* B+Tree Extent List, v5 only */
 
 /**
@@ -88,8 +97,9 @@ struct xal_odf_sb {
 
 	char fname[XAL_ODF_LABEL_MAX]; ///< file system name
 
-	uint8_t _reserved_5[3];
-
+	uint8_t blocklog; ///< log2 of blocksize
+	uint8_t sectlog;  ///< log2 of sectsize
+	uint8_t inodelog; ///< log2 of inodesize
 	uint8_t inopblog; ///< log2 of sb_inopblock
 	uint8_t agblklog; ///< log2 of sb_agblocks (rounded up)
 
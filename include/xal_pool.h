@@ -1,5 +1,11 @@
+#include <libxal.h>
+#include <stdbool.h>
 #include <stdint.h>
 
+#define XAL_POOL_NCLASSES 32 ///< Number of size classes of released ranges; one per power of two
+#define XAL_POOL_HUGETLBFS "/dev/hugepages" ///< Mountpoint of hugetlbfs for shared, explicit huge pages
+#define XAL_POOL_NUMA_NODES_MAX 64 ///< Number of NUMA nodes representable by 'xal_pool.numa_nodemask'
+
 /**
  * A pool of mmap backed memory for fixed-size elements.
  *
@@ -10,10 +16,39 @@
 struct xal_pool {
 	size_t reserved;     ///< Maximum number of elements in the pool
 	size_t allocated;    ///< Number of reserved elements that are allocated
-	size_t growby;	     ///< Number of reserved elements to allocate at a time
+	size_t growby;	     ///< Minimum number of reserved elements to allocate at a time
 	size_t free;	     ///< Index / position of the next free element
+	size_t used;	     ///< High-water mark of 'free' since the pool was last cleared
 	size_t element_size; ///< Size of a single element in bytes
+	size_t pagesize;     ///< Size of the pages backing 'memory'; growth is aligned to it
+	bool shared;	     ///< Whether 'memory' is a shared mapping of a file / shm object
+	bool hugetlb;	     ///< Whether backed by explicit huge pages; shared: of a file in hugetlbfs
+	bool thp;	     ///< Whether grown ranges are advised as MADV_HUGEPAGE
+	bool mlock;	     ///< Whether grown ranges are locked in memory, see xal_pool_prefault()
+	int numa_mode;	     ///< Memory policy, MPOL_INTERLEAVE or MPOL_BIND; 0 for first-touch
+	unsigned long numa_nodemask; ///< Nodes of 'numa_mode'
+	int fd;		     ///< Descriptor of the object backing a shared mapping; -1 otherwise
+	bool memfd;	     ///< Whether 'fd' is a memfd, see xal_pool_seal()
 	void *memory;	     ///< Memory space for elements
+
+	xal_idx_t freelist[XAL_POOL_NCLASSES]; ///< Heads of released ranges, class k holds [2^k, 2^(k+1))
+};
+
+/**
+ * Header of a released range of elements; stored in-place, in the first element of the range
+ */
+struct xal_pool_range {
+	xal_idx_t next;	///< Index of the next range in the same size class; XAL_POOL_IDX_NONE if last
+	uint32_t count; ///< Number of elements in the range
+	uint32_t epoch; ///< Epoch at which the range was released
+};
+
+struct xal_pool_opts {
+	const char *shm_name;         ///< Name of the POSIX shared memory object; NULL for private memory
+	enum xal_hugepages hugepages; ///< Page size backing the pool
+	bool memfd;                   ///< Back the pool by an anonymous, sealable memfd named 'shm_name'
+	enum xal_numa_policy numa_policy; ///< Placement of the pages of the pool on NUMA nodes
+	int numa_node;                ///< The node of XAL_NUMA_BIND
 };
 
 int
@@ -24,29 +59,206 @@ xal_pool_unmap(struct xal_pool *pool);
  *
  * This will produce a pool of 'reserved' number of inodes, that is, overcommitted memory which is
  * not usable. A subset of this memory, specifically memory for an 'allocated' amount of inodes is
- * made available for read / write, and written to by "zeroing" out the memory.
+ * made available for read / write; it reads as zeroes and is committed as it is written.
  *
  * See the xal_pool_claim() helper, which provides arrays of allocated memory usable for
- * inode-storage. The number of allocated inodes are grown, when claimed, until the reserved space
- * is exhausted.
+ * inode-storage. The number of allocated inodes are grown geometrically, when claimed, until the
+ * reserved space is exhausted; a claim may be of any size up to the reserved space.
  *
- * If shm_name is NULL, uses private anonymous memory with lazy mprotect growth.
- * If shm_name is non-NULL, backs the pool with a POSIX shared memory object of that name.
- * In the shm case the full reserved size is committed upfront and the caller is responsible
- * for shm_unlink() when the shm is no longer needed.
+ * If opts->shm_name is NULL, uses private anonymous memory with lazy mprotect growth.
+ * If opts->shm_name is non-NULL, backs the pool with a POSIX shared memory object of that name.
+ * In the shm case the address space is reserved likewise, and the object is extended with
+ * ftruncate() as the pool grows; thus, the size of the object is that of the allocated elements.
+ * The caller is responsible for shm_unlink() when the shm is no longer needed; or, with explicit
+ * huge pages, for unlink() of the file of that name in XAL_POOL_HUGETLBFS. With opts->memfd, the
+ * object is a memfd instead, 'shm_name' only names it for debugging, and nothing is to be unlinked.
  */
 int
 xal_pool_map(struct xal_pool *pool, size_t reserved, size_t allocated, size_t element_size,
-             const char *shm_name);
+             const struct xal_pool_opts *opts);
+
+/**
+ *
+ */
+int
+xal_pool_claim_extents(struct xal_pool *pool, size_t count, xal_idx_t *idx);
+
+int
+xal_pool_claim_inodes(struct xal_pool *pool, size_t count, xal_idx_t *idx);
+
+/**
+ * Fault in the allocated elements of the pool, as given by 'flags' of 'enum xal_prefault'
+ *
+ * With XAL_PREFAULT_MLOCK, the allocated elements are locked in memory, and so are elements
+ * allocated as the pool grows.
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -ENOMEM or -EPERM when exceeding RLIMIT_MEMLOCK.
+ */
+int
+xal_pool_prefault(struct xal_pool *pool, int flags);
+
+/**
+ * Copy the elements in use, 'src->free', into a new, read-only, private pool on NUMA node 'node'
+ *
+ * The copy has the element size of 'src' but cannot grow; xal_pool_unmap() unmaps it. With a negative
+ * 'node', the pages of the copy are placed by first-touch.
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error.
+ */
+int
+xal_pool_replicate(struct xal_pool *dst, const struct xal_pool *src, int node);
+
+/**
+ * Map a pool with the geometry and placement of 'src'; empty, and growing as 'src' does
+ *
+ * The pool is backed by anonymous memory, or, given 'shm_name', by a new object of that name and
+ * of the kind of 'src', e.g. as the standby of a double-buffered index, see xal_pools_stage().
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error.
+ */
+int
+xal_pool_map_like(struct xal_pool *dst, const struct xal_pool *src, const char *shm_name);
+
+/**
+ * Empty the pool; a shared pool is backed by a new object named 'shm_name' at the same address
+ *
+ * A private pool is cleared, see xal_pool_clear(). The object of a shared pool is closed and its
+ * range replaced by a reservation, thus, those mapping it elsewhere keep their content, while a
+ * reader in this process addressing the pool reads zeroes rather than faulting.
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error.
+ */
+int
+xal_pool_renew(struct xal_pool *pool, const char *shm_name);
+
+/**
+ * Remove the object named 'shm_name' of the kind backing 'pool'; a no-op for private and memfd
+ * pools
+ *
+ * @return On success, or when there is no such object, 0 is returned. On error, negative errno.
+ */
+int
+xal_pool_unlink(const struct xal_pool *pool, const char *shm_name);
+
+/**
+ * Retrieve the mask of online NUMA nodes, limited to XAL_POOL_NUMA_NODES_MAX; node 0 when unknown
+ */
+unsigned long
+xal_pool_numa_online(void);
+
+/**
+ * Return the number of bytes of the allocated elements which are resident in memory
+ */
+size_t
+xal_pool_resident(const struct xal_pool *pool);
+
+/**
+ * Make the memfd backing the pool immutable; the pool is remapped read-only and the memfd sealed
+ * with F_SEAL_SHRINK, F_SEAL_GROW, F_SEAL_WRITE and F_SEAL_SEAL
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -EINVAL when the pool is not backed by a memfd, -EBUSY when the memfd is mapped writable
+ *         elsewhere.
+ */
+int
+xal_pool_seal(struct xal_pool *pool);
+
+/**
+ * Map, read-only, the pool backed by 'fd', at its current size; 'fd' is not closed
+ *
+ * The address space of 'reserved_nbytes' is reserved, such that xal_pool_refresh() can grow the
+ * mapping in place as the producer grows the pool; the object is opened again for it, read-only,
+ * as a mapping of a descriptor open for writing would refuse xal_pool_seal() to the producer.
+ *
+ * @param pool The pool to initialize
+ * @param fd Descriptor of the shared memory object, e.g. a memfd received from another process
+ * @param hugetlb Whether the object is backed by huge pages of hugetlbfs
+ * @param element_size Size of a single element in bytes
+ * @param reserved_nbytes Size of the address space reserved by the pool of the producer
+ */
+int
+xal_pool_attach_fd(struct xal_pool *pool, int fd, bool hugetlb, size_t element_size,
+		   size_t reserved_nbytes);
+
+/**
+ * Map, read-only, the pool published by another process under 'shm_name', at its current size
+ *
+ * The pool is not to be grown or claimed from; xal_pool_unmap() unmaps it.
+ *
+ * @param pool The pool to initialize
+ * @param shm_name Name of the POSIX shared memory object, as given to xal_pool_map()
+ * @param hugetlb Whether the object is a file in XAL_POOL_HUGETLBFS rather than in shared memory
+ * @param element_size Size of a single element in bytes
+ * @param reserved_nbytes As for xal_pool_attach_fd()
+ */
+int
+xal_pool_attach(struct xal_pool *pool, const char *shm_name, bool hugetlb, size_t element_size,
+		size_t reserved_nbytes);
+
+/**
+ * Extend the mapping of an attached pool to the current size of its object, within the address
+ * space reserved by xal_pool_attach_fd(); the elements already mapped stay in place
+ *
+ * @return On success, 0 is returned. On error, negative errno is returned to indicate the error;
+ *         -EINVAL when the pool is not attached.
+ */
+int
+xal_pool_refresh(struct xal_pool *pool);
+
+/**
+ * Claim 'count' bytes from a pool of single-byte elements, such as the pool of names
+ *
+ * Unlike the inodes and extents, the offset of the claimed bytes can exceed the xal_idx_t range.
+ */
+int
+xal_pool_claim_bytes(struct xal_pool *pool, size_t count, uint64_t *ofz);
 
 /**
+ * Put the range of 'count' elements at 'idx' on the free-list of its size class
  *
+ * Released ranges are not reused before the epoch has advanced beyond 'epoch', that is, a range
+ * released while updating the index is not handed out again by the same update; this makes the
+ * reuse safe for readers which validate what they read against the epoch, e.g. xal->seq_lock.
+ * The elements must be at least sizeof(struct xal_pool_range) bytes.
  */
 int
-xal_pool_claim_extents(struct xal_pool *pool, size_t count, uint32_t *idx);
+xal_pool_free(struct xal_pool *pool, xal_idx_t idx, size_t count, uint32_t epoch);
 
+/**
+ * Claim 'count' consecutive elements, preferably from a range released before 'epoch'
+ *
+ * The size class of 'count' is searched first, for a range of at least 'count' elements, then the
+ * larger classes, where any range fits; the remainder of a larger range is put back on its
+ * free-list. When no released range is eligible, the elements are
+ * claimed from the end of the pool, as with xal_pool_claim_extents(). Unlike a claim from the end
+ * of the pool, the elements are not zeroed.
+ */
 int
-xal_pool_claim_inodes(struct xal_pool *pool, size_t count, uint32_t *idx);
+xal_pool_claim_recycled(struct xal_pool *pool, size_t count, uint32_t epoch, xal_idx_t *idx);
 
+/**
+ * Return the last 'count' claimed elements to the pool; their memory is zeroed
+ */
+int
+xal_pool_release(struct xal_pool *pool, size_t count);
+
+/**
+ * Shrink the pool to its first 'count' elements; the rest are zeroed and released ranges dropped
+ *
+ * For use when the elements have been rearranged, e.g. by xal_compact(), such that the free-lists
+ * no longer describe unused elements.
+ */
+int
+xal_pool_truncate(struct xal_pool *pool, size_t count);
+
+/**
+ * Empty the pool such that it reads as zeroes, touching only the elements used since last cleared
+ *
+ * The whole pages of the used prefix are handed back to the kernel, with MADV_DONTNEED for private
+ * memory and MADV_REMOVE for shared memory, thus a cleared pool does not retain resident memory
+ * across repeated re-indexing; the remainder is zeroed. The allocation is kept as is, such that
+ * re-populating the pool does not repeat the growth.
+ */
 int
 xal_pool_clear(struct xal_pool *pool);
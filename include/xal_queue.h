@@ -0,0 +1,43 @@
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * A bounded, blocking, multi-producer multi-consumer queue of pointers
+ *
+ * This connects the stages of the XFS decoding pipeline; producers block while the queue is full
+ * and consumers block while it is empty, thus the capacity bounds the work in flight between two
+ * stages.
+ */
+struct xal_queue {
+	void **items;      ///< Ring of 'capacity' number of items
+	uint32_t capacity; ///< Maximum number of items in the queue
+	uint32_t head;     ///< Position of the next item to pop
+	uint32_t count;    ///< Number of items in the queue
+	pthread_mutex_t mutex;
+	pthread_cond_t nonempty;
+	pthread_cond_t nonfull;
+};
+
+int
+xal_queue_init(struct xal_queue *queue, uint32_t capacity);
+
+void
+xal_queue_term(struct xal_queue *queue);
+
+/**
+ * Push 'item' onto the queue; blocks while the queue is full
+ */
+void
+xal_queue_push(struct xal_queue *queue, void *item);
+
+/**
+ * Pop an item from the queue; blocks while the queue is empty
+ */
+void *
+xal_queue_pop(struct xal_queue *queue);
+
+/**
+ * Pop an item from the queue without blocking; returns NULL when the queue is empty
+ */
+void *
+xal_queue_trypop(struct xal_queue *queue);
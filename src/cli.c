@@ -11,6 +11,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -22,7 +23,20 @@ struct xal_cli_args {
 	bool meta;
 	bool stats;
 	bool file_lookup_map;
+	bool verify_crc;
+	bool compact_extents;
+	bool merge_extents;
+	bool compact;
 	char *backend;
+	char *quiesce;
+	char *hugepages;
+	char *prefault;
+	char *numa;
+	int numa_node;
+	uint32_t validate_every;
+	uint32_t nthreads;
+	uint32_t qdepth;
+	uint32_t step_budget;
 	char *dev_uri;
 	char *filename;
 };
@@ -52,6 +66,68 @@ parse_args(int argc, char *argv[], struct xal_cli_args *args)
 			args->stats = 1;
 		} else if (strcmp(argv[i], "--file_lookup_map") == 0) {
 			args->file_lookup_map = 1;
+		} else if (strcmp(argv[i], "--verify-crc") == 0) {
+			args->verify_crc = 1;
+		} else if (strcmp(argv[i], "--compact-extents") == 0) {
+			args->compact_extents = 1;
+		} else if (strcmp(argv[i], "--merge-extents") == 0) {
+			args->merge_extents = 1;
+		} else if (strcmp(argv[i], "--compact") == 0) {
+			args->compact = 1;
+		} else if (strcmp(argv[i], "--quiesce") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: Quiesce argument must define a valid mode (choices: syncfs, freeze)\n");
+				return -EINVAL;
+			}
+			args->quiesce = argv[++i];
+		} else if (strcmp(argv[i], "--hugepages") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: Hugepages argument must define a valid mode (choices: none, transparent, explicit)\n");
+				return -EINVAL;
+			}
+			args->hugepages = argv[++i];
+		} else if (strcmp(argv[i], "--prefault") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: Prefault argument must define a valid mode (choices: none, populate, willneed, mlock)\n");
+				return -EINVAL;
+			}
+			args->prefault = argv[++i];
+		} else if (strcmp(argv[i], "--numa") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: NUMA argument must define a valid policy (choices: default, interleave, bind)\n");
+				return -EINVAL;
+			}
+			args->numa = argv[++i];
+		} else if (strcmp(argv[i], "--numa-node") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: NUMA node argument must define a node: --numa-node <n>\n");
+				return -EINVAL;
+			}
+			args->numa_node = strtol(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--validate-every") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: Validate argument must define a sample interval: --validate-every <n>\n");
+				return -EINVAL;
+			}
+			args->validate_every = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--nthreads") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: Threads argument must define a count: --nthreads <n>\n");
+				return -EINVAL;
+			}
+			args->nthreads = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--qdepth") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: Queue-depth argument must define a depth: --qdepth <n>\n");
+				return -EINVAL;
+			}
+			args->qdepth = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--step-budget") == 0) {
+			if (i+1 >= argc) {
+				fprintf(stderr, "Error: Step argument must define a budget: --step-budget <n>\n");
+				return -EINVAL;
+			}
+			args->step_budget = strtoul(argv[++i], NULL, 10);
 		} else if (strcmp(argv[i], "--backend") == 0) {
 			if (i+1 >= argc) {
 				fprintf(stderr, "Error: Backend argument must define a valid backend (choices: xfs, fiemap)\n");
@@ -94,7 +170,7 @@ node_inspector_find(struct xal *xal, struct xal_inode *inode, void *cb_args,
 	} else if (xal_inode_is_file(inode)) {
 		args->nfiles += 1;
 	} else {
-		printf("# UNKNOWN(%.*s)", inode->namelen, inode->name);
+		printf("# UNKNOWN(%.*s)", inode->namelen, xal_inode_name(xal, inode));
 		return 0;
 	}
 
@@ -114,13 +190,19 @@ pp_inode_extents(struct xal *xal, struct xal_inode *inode)
 	uint32_t blocksize = xal_get_sb_blocksize(xal);
 
 	for (uint32_t i = 0; i < inode->content.extents.count; ++i) {
-		struct xal_extent *extent = xal_extent_at(xal, inode->content.extents.extent_idx + i);
+		struct xal_extent extent;
 		size_t fofz_begin, fofz_end, bofz_begin, bofz_end;
+		int err;
+
+		err = xal_extent_get(xal, inode->content.extents.extent_idx + i, &extent);
+		if (err) {
+			return err;
+		}
 
-		fofz_begin = (extent->start_offset * blocksize) / 512;
-		fofz_end = fofz_begin + (extent->nblocks * blocksize) / 512 - 1;
-		bofz_begin = xal_fsbno_offset(xal, extent->start_block) / 512;
-		bofz_end = bofz_begin + (extent->nblocks * blocksize) / 512 - 1;
+		fofz_begin = (extent.start_offset * blocksize) / 512;
+		fofz_end = fofz_begin + (extent.nblocks * blocksize) / 512 - 1;
+		bofz_begin = xal_fsbno_offset(xal, extent.start_block) / 512;
+		bofz_end = bofz_begin + (extent.nblocks * blocksize) / 512 - 1;
 
 		printf("- [%" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 "]\n", fofz_begin,
 		       fofz_end, bofz_begin, bofz_end);
@@ -140,7 +222,7 @@ node_inspector_bmap(struct xal *xal, struct xal_inode *inode, void *cb_args, int
 	} else if (xal_inode_is_file(inode)) {
 		args->nfiles += 1;
 	} else {
-		printf("# UNKNOWN(%.*s)", inode->namelen, inode->name);
+		printf("# UNKNOWN(%.*s)", inode->namelen, xal_inode_name(xal, inode));
 		return 0;
 	}
 
@@ -204,6 +286,77 @@ main(int argc, char *argv[])
 		opts.file_lookupmode = XAL_FILE_LOOKUPMODE_HASHMAP;
 	}
 
+	if (args.verify_crc) {
+		opts.verify_crc = true;
+	}
+
+	if (args.compact_extents) {
+		opts.compact_extents = true;
+	}
+
+	if (args.merge_extents) {
+		opts.merge_extents = true;
+	}
+
+	if (args.hugepages) {
+		if (strcmp(args.hugepages, "none") == 0) {
+			opts.hugepages = XAL_HUGEPAGES_NONE;
+		} else if (strcmp(args.hugepages, "transparent") == 0) {
+			opts.hugepages = XAL_HUGEPAGES_TRANSPARENT;
+		} else if (strcmp(args.hugepages, "explicit") == 0) {
+			opts.hugepages = XAL_HUGEPAGES_EXPLICIT;
+		} else {
+			printf("Invalid hugepages: %s; Valid choices: none, transparent, explicit\n",
+			       args.hugepages);
+			return -EINVAL;
+		}
+	}
+
+	if (args.prefault) {
+		if (strcmp(args.prefault, "none") == 0) {
+			opts.prefault = XAL_PREFAULT_NONE;
+		} else if (strcmp(args.prefault, "populate") == 0) {
+			opts.prefault = XAL_PREFAULT_POPULATE;
+		} else if (strcmp(args.prefault, "willneed") == 0) {
+			opts.prefault = XAL_PREFAULT_WILLNEED;
+		} else if (strcmp(args.prefault, "mlock") == 0) {
+			opts.prefault = XAL_PREFAULT_POPULATE | XAL_PREFAULT_MLOCK;
+		} else {
+			printf("Invalid prefault: %s; Valid choices: none, populate, willneed, mlock\n",
+			       args.prefault);
+			return -EINVAL;
+		}
+	}
+
+	if (args.numa) {
+		if (strcmp(args.numa, "default") == 0) {
+			opts.numa_policy = XAL_NUMA_DEFAULT;
+		} else if (strcmp(args.numa, "interleave") == 0) {
+			opts.numa_policy = XAL_NUMA_INTERLEAVE;
+		} else if (strcmp(args.numa, "bind") == 0) {
+			opts.numa_policy = XAL_NUMA_BIND;
+		} else {
+			printf("Invalid numa: %s; Valid choices: default, interleave, bind\n", args.numa);
+			return -EINVAL;
+		}
+	}
+	opts.numa_node = args.numa_node;
+
+	opts.nthreads = args.nthreads;
+	opts.qdepth = args.qdepth;
+
+	if (args.quiesce) {
+		if (strcmp(args.quiesce, "syncfs") == 0) {
+			opts.quiesce = XAL_QUIESCE_SYNCFS;
+		} else if (strcmp(args.quiesce, "freeze") == 0) {
+			opts.quiesce = XAL_QUIESCE_FREEZE;
+		} else {
+			printf("Invalid quiesce: %s; Valid choices: syncfs, freeze\n", args.quiesce);
+			return -EINVAL;
+		}
+		opts.validate_every = args.validate_every;
+	}
+
 	err = xal_open(dev, &xal, &opts);
 	if (err < 0) {
 		printf("xal_open(...); err(%d)\n", err);
@@ -214,16 +367,57 @@ main(int argc, char *argv[])
 		xal_pp(xal);
 	}
 
-	err = xal_dinodes_retrieve(xal);
-	if (err) {
-		printf("xal_dinodes_retrieve(...); err(%d)\n", err);
-		return err;
+	if (args.step_budget) {
+		struct xal_index_progress progress = {0};
+		uint64_t nsteps = 0;
+
+		err = xal_index_begin(xal);
+		if (err) {
+			printf("xal_index_begin(...); err(%d)\n", err);
+			goto exit;
+		}
+
+		do {
+			err = xal_index_step(xal, args.step_budget, &progress);
+			nsteps += 1;
+		} while (err == -EAGAIN);
+
+		if (err) {
+			printf("xal_index_step(...); err(%d)\n", err);
+			xal_index_done(xal);
+			goto exit;
+		}
+
+		err = xal_index_done(xal);
+		if (err) {
+			printf("xal_index_done(...); err(%d)\n", err);
+			goto exit;
+		}
+
+		if (args.stats) {
+			printf("nsteps(%" PRIu64 "); nchunks(%" PRIu64 "); ninodes(%" PRIu64 ")\n",
+			       nsteps, progress.nchunks, progress.ninodes);
+		}
+	} else {
+		err = xal_dinodes_retrieve(xal);
+		if (err) {
+			printf("xal_dinodes_retrieve(...); err(%d)\n", err);
+			return err;
+		}
+
+		err = xal_index(xal);
+		if (err) {
+			printf("xal_index(...); err(%d)\n", err);
+			goto exit;
+		}
 	}
 
-	err = xal_index(xal);
-	if (err) {
-		printf("xal_index(...); err(%d)\n", err);
-		goto exit;
+	if (args.compact) {
+		err = xal_compact(xal);
+		if (err) {
+			printf("xal_compact(...); err(%d)\n", err);
+			goto exit;
+		}
 	}
 
 	if (args.bmap) {
@@ -261,12 +455,46 @@ main(int argc, char *argv[])
 			goto exit;
 		}
 
-		printf("'%s':\n", inode->name);
+		printf("'%s':\n", xal_inode_name(xal, inode));
 		pp_inode_extents(xal, inode);
 	}
 
 	if (args.stats) {
+		struct xal_resident resident;
+
 		printf("ndirs(%" PRIu64 "); nfiles(%" PRIu64 ")\n", cb_args.ndirs, cb_args.nfiles);
+
+		err = xal_get_resident(xal, &resident);
+		if (err) {
+			printf("xal_get_resident(...); err(%d)\n", err);
+			goto exit;
+		}
+		printf("resident inodes(%zu); inodes_cold(%zu); extents(%zu); names(%zu)\n",
+		       resident.inodes, resident.inodes_cold, resident.extents, resident.names);
+	}
+
+	if (args.verify_crc) {
+		struct xal_crc_stats crc_stats;
+
+		err = xal_get_crc_stats(xal, &crc_stats);
+		if (err) {
+			printf("xal_get_crc_stats(...); err(%d)\n", err);
+			goto exit;
+		}
+
+		xal_crc_stats_pp(&crc_stats);
+	}
+
+	if (args.quiesce && args.validate_every) {
+		struct xal_validate_stats validate_stats;
+
+		err = xal_get_validate_stats(xal, &validate_stats);
+		if (err) {
+			printf("xal_get_validate_stats(...); err(%d)\n", err);
+			goto exit;
+		}
+
+		xal_validate_stats_pp(&validate_stats);
 	}
 
 exit:
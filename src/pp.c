@@ -174,8 +174,8 @@ xal_inode_pp(struct xal *xal, struct xal_inode *inode)
 	wrtn += printf("xal_inode:\n");
 	wrtn += printf("  ino: 0x%08" PRIX64 "\n", inode->ino);
 	wrtn += printf("  size: %" PRIu64 "\n", inode->size);
-	wrtn += printf("  namelen: %" PRIu8 "\n", inode->namelen);
-	wrtn += printf("  name: '%.256s'\n", inode->name);
+	wrtn += printf("  namelen: %" PRIu16 "\n", inode->namelen);
+	wrtn += printf("  name: '%.*s'\n", inode->namelen, xal_inode_name(xal, inode));
 	wrtn += printf("  ftype: %" PRIu8 "\n", inode->ftype);
 
 	switch (inode->ftype) {
@@ -194,13 +194,17 @@ xal_inode_pp(struct xal *xal, struct xal_inode *inode)
 		uint32_t blocksize = xal_get_sb_blocksize(xal);
 		wrtn += printf("  extents.count: %u\n", inode->content.extents.count);
 		for (uint32_t i = 0; i < inode->content.extents.count; ++i) {
-			struct xal_extent *extent = xal_extent_at(xal, inode->content.extents.extent_idx + i);
+			struct xal_extent extent;
 	        size_t fofz_begin, fofz_end, bofz_begin, bofz_end;
 
-	        fofz_begin = (extent->start_offset * blocksize) / BMAP_BLOCK_SIZE;
-	        fofz_end = fofz_begin + (extent->nblocks * blocksize) / BMAP_BLOCK_SIZE - 1;
-	        bofz_begin = xal_fsbno_offset(xal, extent->start_block) / BMAP_BLOCK_SIZE;
-	        bofz_end = bofz_begin + (extent->nblocks * blocksize) / BMAP_BLOCK_SIZE - 1;
+	        if (xal_extent_get(xal, inode->content.extents.extent_idx + i, &extent)) {
+	                break;
+	        }
+
+	        fofz_begin = (extent.start_offset * blocksize) / BMAP_BLOCK_SIZE;
+	        fofz_end = fofz_begin + (extent.nblocks * blocksize) / BMAP_BLOCK_SIZE - 1;
+	        bofz_begin = xal_fsbno_offset(xal, extent.start_block) / BMAP_BLOCK_SIZE;
+	        bofz_end = bofz_begin + (extent.nblocks * blocksize) / BMAP_BLOCK_SIZE - 1;
 			wrtn += printf("- [%" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %"
 				    PRIu64 "]\n", fofz_begin, fofz_end, bofz_begin, bofz_end);
 		}
@@ -346,6 +350,56 @@ xal_be_xfs_pp(struct xal *xal, struct xal_be_xfs *be)
 		wrtn += xal_ag_pp(&be->ags[i]);
 	}
 
+	if (be->verify_crc) {
+		wrtn += xal_crc_stats_pp(&be->crc_stats);
+	}
+
+	if (be->mountpoint) {
+		wrtn += printf("xal_be_xfs:\n");
+		wrtn += printf("  mountpoint: %s\n", be->mountpoint);
+		wrtn += printf("  quiesce: %d\n", be->quiesce);
+		wrtn += printf("  validate_every: %" PRIu32 "\n", be->validate_every);
+	}
+
+	return wrtn;
+}
+
+int
+xal_crc_stats_pp(struct xal_crc_stats *stats)
+{
+	const char *names[XAL_CRC_BLK_NTYPES] = {"iab3", "bma3", "dir3", "dinode"};
+	int wrtn = 0;
+
+	if (!stats) {
+		wrtn += printf("xal_crc_stats: ~\n");
+		return wrtn;
+	}
+
+	wrtn += printf("xal_crc_stats:\n");
+	for (int type = 0; type < XAL_CRC_BLK_NTYPES; ++type) {
+		wrtn += printf("  %s: {nchecked: %" PRIu64 ", nmismatch: %" PRIu64 "}\n",
+			       names[type], stats->nchecked[type], stats->nmismatch[type]);
+	}
+
+	return wrtn;
+}
+
+int
+xal_validate_stats_pp(struct xal_validate_stats *stats)
+{
+	int wrtn = 0;
+
+	if (!stats) {
+		wrtn += printf("xal_validate_stats: ~\n");
+		return wrtn;
+	}
+
+	wrtn += printf("xal_validate_stats:\n");
+	wrtn += printf("  nfiles: %" PRIu64 "\n", stats->nfiles);
+	wrtn += printf("  nsampled: %" PRIu64 "\n", stats->nsampled);
+	wrtn += printf("  nmismatch: %" PRIu64 "\n", stats->nmismatch);
+	wrtn += printf("  nfallback: %" PRIu64 "\n", stats->nfallback);
+
 	return wrtn;
 }
 
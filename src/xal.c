@@ -1,11 +1,14 @@
+#define _GNU_SOURCE
 #include <asm-generic/errno.h>
 #include <libxnvme.h>
-#define _GNU_SOURCE
 #include <assert.h>
 #include <endian.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <libxal.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -13,6 +16,8 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 #include <xal.h>
 #include <xal_be_fiemap.h>
@@ -21,93 +26,1457 @@
 #include <xal_pp.h>
 
 /**
- * Calculate the on-disk offset of the given filesystem block number
- *
- * Format Assumption
- * =================
- * |       agno        |       bno        |
- * | 64 - agblklog     |  agblklog        |
+ * Calculate the on-disk offset of the given filesystem block number
+ *
+ * Format Assumption
+ * =================
+ * |       agno        |       bno        |
+ * | 64 - agblklog     |  agblklog        |
+ */
+uint64_t
+xal_fsbno_offset(struct xal *xal, uint64_t fsbno)
+{
+	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+
+	switch (be->type) {
+		case XAL_BACKEND_FIEMAP:
+			return fsbno * xal->sb.blocksize;
+
+		case XAL_BACKEND_XFS:
+			const struct xal_be_xfs_geo *geo = &((struct xal_be_xfs *)be)->geo;
+			uint64_t ag, bno;
+
+			ag = fsbno >> geo->agblklog;
+			bno = fsbno & geo->agbno_mask;
+
+			return (ag * xal->sb.agblocks + bno) << geo->blocklog;
+
+		default:
+			XAL_DEBUG("FAILED: Unknown backend type(%d)", be->type);
+			return -EINVAL;
+	}
+}
+
+struct xal_inode *
+xal_inode_at(struct xal *xal, xal_idx_t idx)
+{
+	return (struct xal_inode *)xal->inodes.memory + idx;
+}
+
+struct xal_extent *
+xal_extent_at(struct xal *xal, xal_idx_t idx)
+{
+	if (xal->compact_extents) {
+		return NULL;
+	}
+
+	return (struct xal_extent *)xal->extents.memory + idx;
+}
+
+/**
+ * Decode the extent at 'idx' of the extents pool at 'memory', in either representation
+ */
+static void
+extent_decode(const void *memory, bool compact, xal_idx_t idx, struct xal_extent *extent)
+{
+	const struct xal_extent_compact *rec;
+
+	if (!compact) {
+		*extent = ((const struct xal_extent *)memory)[idx];
+		return;
+	}
+
+	rec = (const struct xal_extent_compact *)memory + idx;
+
+	extent->start_offset = (rec->l0 << 1) >> 10;
+	extent->start_block = ((rec->l0 & 0x1FF) << 43) | (rec->l1 >> 21);
+	extent->nblocks = rec->l1 & XAL_EXTENT_COMPACT_NBLOCKS_MAX;
+	extent->flag = rec->l0 >> 63;
+}
+
+/**
+ * Whether the 'count' elements at 'idx' are within the allocation of 'pool'; that of a view can
+ * lag behind the producer, see xal_attach_refresh(). Pools of unknown size, as given to
+ * xal_from_pools() without it, are not checked.
+ */
+static bool
+pool_holds(const struct xal_pool *pool, size_t idx, size_t count)
+{
+	if (!pool->allocated || !count) {
+		return true;
+	}
+
+	return idx < pool->allocated && count <= pool->allocated - idx;
+}
+
+int
+xal_extent_get(struct xal *xal, xal_idx_t idx, struct xal_extent *extent)
+{
+	if (!pool_holds(&xal->extents, idx, 1)) {
+		XAL_DEBUG("FAILED: extent(%" PRIxal_idx ") beyond the mapped pool", idx);
+		return -ESTALE;
+	}
+
+	extent_decode(xal->extents.memory, xal->compact_extents, idx, extent);
+
+	return 0;
+}
+
+uint32_t
+xal_extent_nrecords(struct xal *xal, uint64_t nblocks)
+{
+	if (!xal->compact_extents || !nblocks) {
+		return 1;
+	}
+
+	return (nblocks + XAL_EXTENT_COMPACT_NBLOCKS_MAX - 1) / XAL_EXTENT_COMPACT_NBLOCKS_MAX;
+}
+
+int
+xal_extent_set(struct xal *xal, xal_idx_t idx, const struct xal_extent *extent)
+{
+	struct xal_extent_compact *rec;
+	uint64_t start_offset = extent->start_offset;
+	uint64_t start_block = extent->start_block;
+	uint64_t nblocks = extent->nblocks;
+
+	if (!xal->compact_extents) {
+		((struct xal_extent *)xal->extents.memory)[idx] = *extent;
+		return 0;
+	}
+
+	if ((extent->flag > 1) ||
+	    (start_offset + nblocks > XAL_EXTENT_COMPACT_OFFSET_MAX + 1) ||
+	    (start_block + nblocks > XAL_EXTENT_COMPACT_BLOCK_MAX + 1)) {
+		XAL_DEBUG("FAILED: extent does not fit the compact representation");
+		return -EOVERFLOW;
+	}
+
+	rec = (struct xal_extent_compact *)xal->extents.memory + idx;
+	do {
+		uint64_t len = nblocks < XAL_EXTENT_COMPACT_NBLOCKS_MAX
+				   ? nblocks
+				   : XAL_EXTENT_COMPACT_NBLOCKS_MAX;
+
+		rec->l0 = ((uint64_t)extent->flag << 63) | (start_offset << 9) | (start_block >> 43);
+		rec->l1 = (start_block << 21) | len;
+
+		start_offset += len;
+		start_block += len;
+		nblocks -= len;
+		rec += 1;
+	} while (nblocks);
+
+	return 0;
+}
+
+xal_idx_t
+xal_inode_idx(struct xal *xal, struct xal_inode *inode)
+{
+	return (xal_idx_t)(inode - (struct xal_inode *)xal->inodes.memory);
+}
+
+static struct xal_inode_cold *
+inode_cold(struct xal *xal, const struct xal_inode *inode)
+{
+	return (struct xal_inode_cold *)xal->inodes_cold.memory +
+	       (inode - (const struct xal_inode *)xal->inodes.memory);
+}
+
+const char *
+xal_inode_name(struct xal *xal, const struct xal_inode *inode)
+{
+	return (const char *)xal->names.memory + inode_cold(xal, inode)->name_ofz;
+}
+
+int
+xal_inodes_claim(struct xal *xal, size_t count, xal_idx_t *idx)
+{
+	xal_idx_t cold_idx;
+	int err;
+
+	err = xal_pool_claim_inodes(&xal->inodes, count, idx);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_claim_inodes(inodes); err(%d)", err);
+		return err;
+	}
+
+	err = xal_pool_claim_inodes(&xal->inodes_cold, count, &cold_idx);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_claim_inodes(inodes_cold); err(%d)", err);
+		xal_pool_release(&xal->inodes, count);
+		return err;
+	}
+
+	if (*idx != cold_idx) {
+		XAL_DEBUG("FAILED: inodes(%" PRIxal_idx ") and inodes_cold(%" PRIxal_idx ") diverged", *idx,
+			  cold_idx);
+		xal_pool_release(&xal->inodes_cold, count);
+		xal_pool_release(&xal->inodes, count);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static long
+futex(atomic_uint *uaddr, int op, uint32_t val, const struct timespec *timeout, uint32_t val3)
+{
+	return syscall(SYS_futex, uaddr, op, val, timeout, NULL, val3);
+}
+
+void
+xal_pools_name(char *name, size_t len, const char *shm_name, const char *suffix, uint32_t epoch)
+{
+	snprintf(name, len, "%s%s%s", shm_name, suffix, epoch & 1 ? "_1" : "");
+}
+
+void
+xal_manifest_update(struct xal *xal)
+{
+	struct xal_manifest *manifest = xal->manifest;
+	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+
+	if (manifest) {
+		manifest->compact_extents = xal->compact_extents;
+		manifest->backend = be->type;
+		manifest->pools_hugetlb =
+			(xal->inodes.hugetlb ? XAL_MANIFEST_POOL_INODES : 0) |
+			(xal->inodes_cold.hugetlb ? XAL_MANIFEST_POOL_INODES_COLD : 0) |
+			(xal->extents.hugetlb ? XAL_MANIFEST_POOL_EXTENTS : 0) |
+			(xal->names.hugetlb ? XAL_MANIFEST_POOL_NAMES : 0);
+		manifest->pools_epoch = xal->pools_epoch;
+		manifest->root_idx = xal->root_idx;
+		manifest->ninodes = xal->inodes.free;
+		manifest->nextents = xal->extents.free;
+		manifest->nnames = xal->names.free;
+		manifest->pools_reserved[0] = xal->inodes.reserved * xal->inodes.element_size;
+		manifest->pools_reserved[1] =
+			xal->inodes_cold.reserved * xal->inodes_cold.element_size;
+		manifest->pools_reserved[2] = xal->extents.reserved * xal->extents.element_size;
+		manifest->pools_reserved[3] = xal->names.reserved * xal->names.element_size;
+		manifest->sb = xal->sb;
+
+		if (be->type == XAL_BACKEND_FIEMAP) {
+			struct xal_be_fiemap *fiemap = (struct xal_be_fiemap *)&xal->be;
+
+			snprintf(manifest->mountpoint, sizeof(manifest->mountpoint), "%s",
+				 fiemap->mountpoint ? fiemap->mountpoint : "");
+		}
+	}
+}
+
+void
+xal_manifest_publish(struct xal *xal)
+{
+	xal_manifest_update(xal);
+
+	atomic_fetch_add_explicit(xal->generation, 1, memory_order_release);
+
+	/**
+	 * Not FUTEX_PRIVATE_FLAG, as the waiters are typically other processes, attached to the
+	 * manifest via xal_attach()
+	 */
+	futex(xal->generation, FUTEX_WAKE, INT_MAX, NULL, 0);
+}
+
+uint32_t
+xal_get_generation(struct xal *xal)
+{
+	return atomic_load_explicit(xal->generation, memory_order_acquire);
+}
+
+int
+xal_wait_generation(struct xal *xal, uint32_t last_gen, int timeout_ms)
+{
+	struct timespec deadline;
+
+	if (timeout_ms >= 0) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += timeout_ms / 1000;
+		deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec += 1;
+			deadline.tv_nsec -= 1000000000L;
+		}
+	}
+
+	/**
+	 * FUTEX_WAIT_BITSET takes an absolute timeout, thus, the deadline holds across spurious
+	 * wake-ups and signals
+	 */
+	while (xal_get_generation(xal) == last_gen) {
+		if (futex(xal->generation, FUTEX_WAIT_BITSET, last_gen,
+			  timeout_ms >= 0 ? &deadline : NULL, FUTEX_BITSET_MATCH_ANY)) {
+			switch (errno) {
+			case EAGAIN:
+			case EINTR:
+				break;
+			case ETIMEDOUT:
+				return -ETIMEDOUT;
+			default:
+				XAL_DEBUG("FAILED: futex(FUTEX_WAIT_BITSET); errno(%d)", errno);
+				return -errno;
+			}
+		}
+	}
+
+	return 0;
+}
+
+void
+xal_pools_clear(struct xal *xal)
+{
+	xal_pool_clear(&xal->inodes);
+	xal_pool_clear(&xal->inodes_cold);
+	xal_pool_clear(&xal->extents);
+	xal_pool_clear(&xal->names);
+	xal->ndeferred = 0;
+}
+
+int
+xal_pools_stage(struct xal *xal, struct xal **staged)
+{
+	const char *suffixes[] = {"_inodes", "_inodes_cold", "_extents", "_names"};
+	struct xal_pool *live[] = {&xal->inodes, &xal->inodes_cold, &xal->extents, &xal->names};
+	struct xal *standby = xal->standby;
+	struct xal_pool inodes, inodes_cold, extents, names;
+	char name[XAL_PATH_MAXLEN + 16];
+	struct xal_pool *next[4];
+	int err = 0;
+
+	if (!standby) {
+		standby = calloc(1, sizeof(*standby));
+		if (!standby) {
+			XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+			return -errno;
+		}
+	}
+
+	next[0] = &standby->inodes;
+	next[1] = &standby->inodes_cold;
+	next[2] = &standby->extents;
+	next[3] = &standby->names;
+
+	/**
+	 * The objects of the previous generation are unlinked before those of the next are created
+	 * under the same names; consumers still mapping them keep their content
+	 */
+	for (size_t i = 0; i < sizeof(live) / sizeof(*live) && !err; ++i) {
+		const char *shm = NULL;
+
+		if (live[i]->shared) {
+			xal_pools_name(name, sizeof(name), xal->shm_name, suffixes[i],
+				       xal->pools_epoch + 1);
+			shm = name;
+		}
+
+		if (!xal->standby) {
+			err = xal_pool_unlink(live[i], shm);
+			err = err ? err : xal_pool_map_like(next[i], live[i], shm);
+		} else {
+			err = xal_pool_unlink(next[i], shm);
+			err = err ? err : xal_pool_renew(next[i], shm);
+		}
+	}
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_map_like() or xal_pool_renew(); err(%d)", err);
+		if (!xal->standby) {
+			for (size_t i = 0; i < sizeof(next) / sizeof(*next); ++i) {
+				xal_pool_unmap(next[i]);
+			}
+			free(standby);
+		}
+		return err;
+	}
+
+	xal->standby = standby;
+
+	inodes = standby->inodes;
+	inodes_cold = standby->inodes_cold;
+	extents = standby->extents;
+	names = standby->names;
+
+	memcpy(standby, xal, sizeof(*standby));
+
+	standby->inodes = inodes;
+	standby->inodes_cold = inodes_cold;
+	standby->extents = extents;
+	standby->names = names;
+	standby->root_idx = XAL_POOL_IDX_NONE;
+	standby->manifest = NULL;
+	standby->manifest_fd = -1;
+	standby->standby = NULL;
+	standby->deferred = NULL;
+	standby->ndeferred = 0;
+	standby->deferred_capacity = 0;
+	memset(standby->replicas, 0, sizeof(standby->replicas));
+
+	*staged = standby;
+
+	return 0;
+}
+
+int
+xal_pools_publish(struct xal *xal)
+{
+	struct xal *standby = xal->standby;
+	struct xal_pool *live[] = {&xal->inodes, &xal->inodes_cold, &xal->extents, &xal->names};
+	struct xal_pool *next[4];
+
+	if (!standby) {
+		XAL_DEBUG("FAILED: no staged index, see xal_pools_stage()");
+		return -EINVAL;
+	}
+
+	next[0] = &standby->inodes;
+	next[1] = &standby->inodes_cold;
+	next[2] = &standby->extents;
+	next[3] = &standby->names;
+
+	for (size_t i = 0; i < sizeof(live) / sizeof(*live); ++i) {
+		struct xal_pool retired = *live[i];
+
+		*live[i] = *next[i];
+		*next[i] = retired;
+	}
+	xal->pools_epoch += 1;
+	xal->root_idx = standby->root_idx;
+	xal->ndeferred = 0;
+
+	return 0;
+}
+
+int
+xal_inode_name_set(struct xal *xal, struct xal_inode *inode, const char *name, size_t namelen)
+{
+	struct xal_inode_cold *cold = inode_cold(xal, inode);
+	char *dst;
+	int err;
+
+	if (namelen > UINT16_MAX) {
+		XAL_DEBUG("FAILED: namelen(%zu) exceeds UINT16_MAX", namelen);
+		return -ENAMETOOLONG;
+	}
+
+	err = xal_pool_claim_bytes(&xal->names, namelen + 1, &cold->name_ofz);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_claim_bytes(); err(%d)", err);
+		return err;
+	}
+
+	dst = (char *)xal->names.memory + cold->name_ofz;
+	memcpy(dst, name, namelen);
+	dst[namelen] = '\0';
+
+	inode->namelen = namelen;
+
+	return 0;
+}
+
+bool
+xal_pinned(struct xal *xal)
+{
+	/**
+	 * The pin of xal_snapshot() is ordered by xal_writer_lock(); the fence orders it for writers
+	 * of backends without one
+	 */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	return atomic_load(&xal->snapshots) != 0;
+}
+
+/**
+ * Free the extent records of which the release was deferred while snapshots were open
+ */
+static int
+extents_drain(struct xal *xal)
+{
+	int epoch = atomic_load(xal->seq_lock);
+	int err;
+
+	while (xal->ndeferred) {
+		const struct xal_extents *range = &xal->deferred[xal->ndeferred - 1];
+
+		err = xal_pool_free(&xal->extents, range->extent_idx, range->count, epoch);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_pool_free(); err(%d)", err);
+			return err;
+		}
+		xal->ndeferred -= 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Defer the release of extent records referenced by open snapshots, see extents_drain()
+ */
+static int
+extents_defer(struct xal *xal, xal_idx_t idx, size_t count)
+{
+	if (count > UINT32_MAX) {
+		XAL_DEBUG("FAILED: invalid range; count(%zu)", count);
+		return -EINVAL;
+	}
+
+	if (xal->ndeferred == xal->deferred_capacity) {
+		size_t capacity = xal->deferred_capacity ? 2 * xal->deferred_capacity : 64;
+		struct xal_extents *deferred;
+
+		deferred = realloc(xal->deferred, capacity * sizeof(*deferred));
+		if (!deferred) {
+			XAL_DEBUG("FAILED: realloc(); errno(%d)", errno);
+			return -ENOMEM;
+		}
+		xal->deferred = deferred;
+		xal->deferred_capacity = capacity;
+	}
+
+	xal->deferred[xal->ndeferred].extent_idx = idx;
+	xal->deferred[xal->ndeferred].count = count;
+	xal->ndeferred += 1;
+
+	return 0;
+}
+
+int
+xal_extents_claim(struct xal *xal, size_t count, xal_idx_t *idx)
+{
+	int epoch = atomic_load(xal->seq_lock);
+	int err;
+
+	/**
+	 * Ranges released since the oldest open snapshot was taken may be referenced by it
+	 */
+	if (xal_pinned(xal)) {
+		int pinned = atomic_load(&xal->snapshots_epoch);
+
+		epoch = pinned < epoch ? pinned : epoch;
+	} else {
+		err = extents_drain(xal);
+		if (err) {
+			XAL_DEBUG("FAILED: extents_drain(); err(%d)", err);
+			return err;
+		}
+	}
+
+	return xal_pool_claim_recycled(&xal->extents, count, epoch, idx);
+}
+
+int
+xal_extents_release(struct xal *xal, xal_idx_t idx, size_t count)
+{
+	int err;
+
+	if (!count) {
+		return 0;
+	}
+
+	if (xal_pinned(xal)) {
+		return extents_defer(xal, idx, count);
+	}
+
+	err = extents_drain(xal);
+	if (err) {
+		XAL_DEBUG("FAILED: extents_drain(); err(%d)", err);
+		return err;
+	}
+
+	if ((size_t)idx + count == xal->extents.free) {
+		return xal_pool_release(&xal->extents, count);
+	}
+
+	return xal_pool_free(&xal->extents, idx, count, atomic_load(xal->seq_lock));
+}
+
+int
+xal_extents_merge(struct xal *xal, struct xal_extents *extents)
+{
+	struct xal_extent prev;
+	uint32_t count = 0;
+	int err;
+
+	for (uint32_t i = 0; i < extents->count; ++i) {
+		struct xal_extent cur;
+
+		xal_extent_get(xal, extents->extent_idx + i, &cur);
+
+		if (count && (prev.flag == cur.flag) &&
+		    (prev.start_offset + prev.nblocks == cur.start_offset) &&
+		    (prev.start_block + prev.nblocks == cur.start_block) &&
+		    (xal_extent_nrecords(xal, prev.nblocks + cur.nblocks) == 1)) {
+			prev.nblocks += cur.nblocks;
+		} else {
+			if (count) {
+				err = xal_extent_set(xal, extents->extent_idx + count - 1, &prev);
+				if (err) {
+					XAL_DEBUG("FAILED: xal_extent_set(); err(%d)", err);
+					return err;
+				}
+			}
+			prev = cur;
+			count += 1;
+		}
+	}
+
+	if (count) {
+		err = xal_extent_set(xal, extents->extent_idx + count - 1, &prev);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extent_set(); err(%d)", err);
+			return err;
+		}
+	}
+
+	err = xal_extents_release(xal, extents->extent_idx + count, extents->count - count);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_extents_release(); err(%d)", err);
+		return err;
+	}
+	extents->count = count;
+
+	return 0;
+}
+
+int
+xal_pools_map(struct xal *xal, size_t ninodes, size_t nblocks, const struct xal_opts *opts)
+{
+	const char *shm_name = opts->shm_name ? opts->shm_name : (opts->memfd ? XAL_MEMFD_NAME : NULL);
+	struct xal_pool_opts pool_opts = {
+		.shm_name = NULL,
+		.hugepages = opts->hugepages,
+		.memfd = opts->memfd,
+		.numa_policy = opts->numa_policy,
+		.numa_node = opts->numa_node,
+	};
+	size_t inodes_reserved = 2 * ninodes + XAL_POOL_RESERVED_MIN;
+	size_t extents_reserved = nblocks + XAL_POOL_RESERVED_MIN;
+	char shm[XAL_PATH_MAXLEN + 16];
+	int err;
+
+	inodes_reserved = inodes_reserved < XAL_POOL_IDX_NONE ? inodes_reserved : XAL_POOL_IDX_NONE;
+	extents_reserved = extents_reserved < XAL_POOL_IDX_NONE ? extents_reserved : XAL_POOL_IDX_NONE;
+
+	XAL_DEBUG("INFO: reserved inodes(%zu), extents(%zu)", inodes_reserved, extents_reserved);
+
+	xal->compact_extents = opts->compact_extents;
+
+	if (shm_name && strlen(shm_name) > XAL_PATH_MAXLEN) {
+		XAL_DEBUG("FAILED: shm_name too long");
+		return -EINVAL;
+	}
+
+	if (shm_name) {
+		xal->shm_name = strdup(shm_name);
+		if (!xal->shm_name) {
+			XAL_DEBUG("FAILED: strdup(); errno(%d)", errno);
+			return -ENOMEM;
+		}
+	}
+
+	pool_opts.shm_name = shm_name ? shm : NULL;
+
+	xal_pools_name(shm, sizeof(shm), shm_name ? shm_name : "", "_inodes", 0);
+	err = xal_pool_map(&xal->inodes, inodes_reserved, ninodes, sizeof(struct xal_inode),
+			   &pool_opts);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_map(inodes); err(%d)", err);
+		return err;
+	}
+
+	xal_pools_name(shm, sizeof(shm), shm_name ? shm_name : "", "_inodes_cold", 0);
+	err = xal_pool_map(&xal->inodes_cold, inodes_reserved, ninodes,
+			   sizeof(struct xal_inode_cold), &pool_opts);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_map(inodes_cold); err(%d)", err);
+		return err;
+	}
+
+	xal_pools_name(shm, sizeof(shm), shm_name ? shm_name : "", "_extents", 0);
+	err = xal_pool_map(&xal->extents, extents_reserved, ninodes,
+			   xal->compact_extents ? sizeof(struct xal_extent_compact)
+						: sizeof(struct xal_extent),
+			   &pool_opts);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_map(extents); err(%d)", err);
+		return err;
+	}
+
+	xal_pools_name(shm, sizeof(shm), shm_name ? shm_name : "", "_names", 0);
+	err = xal_pool_map(&xal->names, inodes_reserved * (XAL_INODE_NAME_MAXLEN + 1),
+			   XAL_POOL_NAMES_GROWBY, 1, &pool_opts);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_map(names); err(%d)", err);
+		return err;
+	}
+
+	return 0;
+}
+
+int
+xal_from_pools(const struct xal_sb *sb, const char *mountpoint, const struct xal_pools_mem *mem,
+	       _Atomic bool *dirty, struct xal **out)
+{
+	struct xal *xal;
+
+	if (!dirty || !mem || !mem->inodes || !mem->inodes_cold || !mem->extents || !mem->names) {
+		return -EINVAL;
+	}
+	if (mem->replicate && (!mem->inodes_nbytes || !mem->inodes_cold_nbytes ||
+			       !mem->extents_nbytes || !mem->names_nbytes)) {
+		XAL_DEBUG("FAILED: replicate without the size of the pools");
+		return -EINVAL;
+	}
+
+	xal = calloc(1, sizeof(*xal));
+	if (!xal) {
+		return -ENOMEM;
+	}
+
+	xal->sb = *sb;
+	xal->root_idx = 0;
+	xal->shared_view = true;
+	xal->dirty = dirty;
+	xal->seq_lock = &xal->_seq_lock_storage;
+	xal->generation = &xal->_generation_storage;
+	xal->manifest_fd = -1;
+
+	if (mountpoint) {
+		struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
+		be->base.type = XAL_BACKEND_FIEMAP;
+		be->base.close = xal_be_fiemap_close;
+		be->mountpoint = strdup(mountpoint);
+		if (!be->mountpoint) {
+			free(xal);
+			return -ENOMEM;
+		}
+	}
+
+	xal->inodes.memory = mem->inodes;
+	xal->inodes.element_size = sizeof(struct xal_inode);
+
+	xal->inodes_cold.memory = mem->inodes_cold;
+	xal->inodes_cold.element_size = sizeof(struct xal_inode_cold);
+
+	xal->compact_extents = mem->compact_extents;
+	xal->extents.memory = mem->extents;
+	xal->extents.element_size = mem->compact_extents ? sizeof(struct xal_extent_compact)
+							 : sizeof(struct xal_extent);
+
+	xal->names.memory = mem->names;
+	xal->names.element_size = 1;
+
+	xal->inodes.allocated = mem->inodes_nbytes / xal->inodes.element_size;
+	xal->inodes_cold.allocated = mem->inodes_cold_nbytes / xal->inodes_cold.element_size;
+	xal->extents.allocated = mem->extents_nbytes / xal->extents.element_size;
+	xal->names.allocated = mem->names_nbytes;
+
+	if (mem->prefault) {
+		int err = xal_prefault(xal, mem->prefault);
+
+		if (err) {
+			XAL_DEBUG("FAILED: xal_prefault(); err(%d)", err);
+			xal_close(xal);
+			return err;
+		}
+	}
+
+	if (mem->replicate) {
+		int err = xal_replicate(xal);
+
+		if (err) {
+			XAL_DEBUG("FAILED: xal_replicate(); err(%d)", err);
+			xal_close(xal);
+			return err;
+		}
+	}
+
+	*out = xal;
+
+	return 0;
+}
+
+/**
+ * Read the published state of the index from the manifest of 'xal', consistently, that is, not
+ * while the producer is modifying it; along with the epoch of the pools, which are in hugetlbfs,
+ * and the address space they reserve
+ */
+static void
+manifest_read(struct xal *xal, uint32_t *epoch, uint8_t *hugetlb, uint64_t reserved[4])
+{
+	const struct xal_manifest *manifest = xal->manifest;
+	int seq;
+
+	do {
+		seq = atomic_load(xal->seq_lock);
+		if (seq & 1) {
+			sched_yield();
+			continue;
+		}
+
+		xal->sb = manifest->sb;
+		xal->root_idx = manifest->root_idx;
+		xal->compact_extents = manifest->compact_extents;
+		*epoch = manifest->pools_epoch;
+		*hugetlb = manifest->pools_hugetlb;
+		for (int i = 0; i < 4; ++i) {
+			reserved[i] = manifest->pools_reserved[i];
+		}
+	} while ((seq & 1) || seq != atomic_load(xal->seq_lock));
+}
+
+/**
+ * Map, read-only, into 'dst', the pools described by the manifest of 'xal', reading the published
+ * state along; the pools are given either by 'fds', or else by the names derived from 'shm_name'
+ * and the epoch of the pools, in which case pools replaced meanwhile are opened again
+ */
+static int
+attach_pools(struct xal *xal, const char *shm_name, const struct xal_fds *fds,
+	     struct xal_pool dst[4])
+{
+	const struct {
+		const char *suffix;
+		enum xal_manifest_pool bit;
+	} pools[] = {
+		{"_inodes", XAL_MANIFEST_POOL_INODES},
+		{"_inodes_cold", XAL_MANIFEST_POOL_INODES_COLD},
+		{"_extents", XAL_MANIFEST_POOL_EXTENTS},
+		{"_names", XAL_MANIFEST_POOL_NAMES},
+	};
+	char name[XAL_PATH_MAXLEN + 16];
+	size_t element_sizes[4];
+	int pool_fds[4] = {-1, -1, -1, -1};
+	uint32_t epoch, epoch_now;
+	uint64_t reserved[4];
+	uint8_t hugetlb;
+	int err = -EAGAIN;
+
+	manifest_read(xal, &epoch, &hugetlb, reserved);
+
+	element_sizes[0] = sizeof(struct xal_inode);
+	element_sizes[1] = sizeof(struct xal_inode_cold);
+	element_sizes[2] = xal->compact_extents ? sizeof(struct xal_extent_compact)
+						: sizeof(struct xal_extent);
+	element_sizes[3] = 1;
+
+	if (fds) {
+		pool_fds[0] = fds->inodes;
+		pool_fds[1] = fds->inodes_cold;
+		pool_fds[2] = fds->extents;
+		pool_fds[3] = fds->names;
+	}
+
+	for (int attempt = 0; attempt < XAL_ATTACH_ATTEMPTS; ++attempt) {
+		err = 0;
+		for (int i = 0; i < 4 && !err; ++i) {
+			bool pool_hugetlb = hugetlb & pools[i].bit;
+
+			if (fds) {
+				err = xal_pool_attach_fd(&dst[i], pool_fds[i], pool_hugetlb,
+							 element_sizes[i], reserved[i]);
+			} else {
+				xal_pools_name(name, sizeof(name), shm_name, pools[i].suffix,
+					       epoch);
+				err = xal_pool_attach(&dst[i], name, pool_hugetlb, element_sizes[i],
+						      reserved[i]);
+			}
+			if (err) {
+				XAL_DEBUG("FAILED: xal_pool_attach*(%s); err(%d)", pools[i].suffix,
+					  err);
+			}
+		}
+
+		/**
+		 * The objects of an epoch are replaced by the re-index following the next, thus,
+		 * those opened are of 'epoch' when it is still the published one; otherwise, they
+		 * are opened again, under the names of the epoch published since
+		 */
+		manifest_read(xal, &epoch_now, &hugetlb, reserved);
+		if (fds || epoch_now == epoch) {
+			break;
+		}
+
+		XAL_DEBUG("INFO: pools replaced while attaching; epoch(%" PRIu32 ") != (%" PRIu32
+			  ")", epoch_now, epoch);
+		for (int i = 0; i < 4; ++i) {
+			xal_pool_unmap(&dst[i]);
+			memset(&dst[i], 0, sizeof(dst[i]));
+		}
+		epoch = epoch_now;
+		err = -EAGAIN;
+	}
+	if (err) {
+		for (int i = 0; i < 4; ++i) {
+			xal_pool_unmap(&dst[i]);
+			memset(&dst[i], 0, sizeof(dst[i]));
+		}
+		return err;
+	}
+
+	xal->pools_epoch = epoch;
+
+	return 0;
+}
+
+/**
+ * Map, read-only, the manifest given by 'manifest_fd' and the pools it describes; the pools are
+ * given either by 'fds', or else by the names derived from 'shm_name', see attach_pools()
+ */
+static int
+attach(int manifest_fd, const char *shm_name, const struct xal_fds *fds, struct xal **out)
+{
+	struct xal_pool pools[4] = {0};
+	struct xal_manifest *manifest;
+	struct xal *xal;
+	struct stat st;
+	int err;
+
+	if (fstat(manifest_fd, &st) || (size_t)st.st_size < sizeof(*manifest)) {
+		XAL_DEBUG("FAILED: fstat(%d); errno(%d)", manifest_fd, errno);
+		return -EPROTO;
+	}
+
+	manifest = mmap(NULL, sizeof(*manifest), PROT_READ, MAP_SHARED, manifest_fd, 0);
+	if (manifest == MAP_FAILED) {
+		XAL_DEBUG("FAILED: mmap(%d); errno(%d)", manifest_fd, errno);
+		return -errno;
+	}
+
+	if (manifest->magic != XAL_MANIFEST_MAGIC || manifest->version != XAL_MANIFEST_VERSION) {
+		XAL_DEBUG("FAILED: magic(0x%" PRIx32 ") or version(%" PRIu32 ") mismatch",
+			  manifest->magic, manifest->version);
+		munmap(manifest, sizeof(*manifest));
+		return -EPROTO;
+	}
+
+	xal = calloc(1, sizeof(*xal));
+	if (!xal) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		munmap(manifest, sizeof(*manifest));
+		return -ENOMEM;
+	}
+
+	xal->shared_view = true;
+	xal->attached = true;
+	xal->manifest = manifest;
+	xal->manifest_fd = -1;
+	xal->dirty = &manifest->dirty;
+	xal->seq_lock = &manifest->seq_lock;
+	xal->generation = &manifest->generation;
+
+	if (manifest->backend == XAL_BACKEND_FIEMAP) {
+		struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
+
+		be->base.type = XAL_BACKEND_FIEMAP;
+		be->base.close = xal_be_fiemap_close;
+		be->mountpoint = strndup(manifest->mountpoint, XAL_PATH_MAXLEN);
+		if (!be->mountpoint) {
+			XAL_DEBUG("FAILED: strndup(); errno(%d)", errno);
+			xal_close(xal);
+			return -ENOMEM;
+		}
+	}
+
+	if (shm_name) {
+		xal->shm_name = strdup(shm_name);
+		if (!xal->shm_name) {
+			XAL_DEBUG("FAILED: strdup(); errno(%d)", errno);
+			xal_close(xal);
+			return -ENOMEM;
+		}
+	}
+
+	err = attach_pools(xal, shm_name, fds, pools);
+	if (err) {
+		XAL_DEBUG("FAILED: attach_pools(); err(%d)", err);
+		xal_close(xal);
+		return err;
+	}
+
+	xal->inodes = pools[0];
+	xal->inodes_cold = pools[1];
+	xal->extents = pools[2];
+	xal->names = pools[3];
+
+	*out = xal;
+
+	return 0;
+}
+
+int
+xal_attach(const char *shm_name, struct xal **out)
+{
+	char name[XAL_PATH_MAXLEN + 16];
+	int fd, err;
+
+	if (!shm_name || !out || strlen(shm_name) > XAL_PATH_MAXLEN) {
+		XAL_DEBUG("FAILED: invalid arguments");
+		return -EINVAL;
+	}
+
+	snprintf(name, sizeof(name), "%s_manifest", shm_name);
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		XAL_DEBUG("FAILED: shm_open(%s); errno(%d)", name, errno);
+		return -errno;
+	}
+
+	err = attach(fd, shm_name, NULL, out);
+	close(fd);
+
+	return err;
+}
+
+int
+xal_attach_fds(const struct xal_fds *fds, struct xal **out)
+{
+	if (!fds || !out) {
+		XAL_DEBUG("FAILED: invalid arguments");
+		return -EINVAL;
+	}
+
+	return attach(fds->manifest, NULL, fds, out);
+}
+
+int
+xal_attach_refresh(struct xal *xal)
+{
+	struct xal_pool *live[] = {&xal->inodes, &xal->inodes_cold, &xal->extents, &xal->names};
+	struct xal_pool pools[4] = {0};
+	xal_idx_t root_idx = xal->root_idx;
+	struct xal_sb sb = xal->sb;
+	uint64_t reserved[4];
+	uint32_t epoch;
+	uint8_t hugetlb;
+	int err;
+
+	if (!xal->attached) {
+		XAL_DEBUG("FAILED: not attached, see xal_attach()");
+		return -EINVAL;
+	}
+
+	manifest_read(xal, &epoch, &hugetlb, reserved);
+
+	if (epoch == xal->pools_epoch) {
+		for (size_t i = 0; i < sizeof(live) / sizeof(*live); ++i) {
+			err = xal_pool_refresh(live[i]);
+			if (err) {
+				XAL_DEBUG("FAILED: xal_pool_refresh(); err(%d)", err);
+				return err;
+			}
+		}
+
+		return 0;
+	}
+
+	/**
+	 * The state read along describes the replacing pools; the view is left as it was, until
+	 * they are mapped
+	 */
+	if (!xal->shm_name) {
+		XAL_DEBUG("FAILED: pools replaced; attach to the descriptors again");
+		xal->root_idx = root_idx;
+		xal->sb = sb;
+		return -ESTALE;
+	}
+
+	err = attach_pools(xal, xal->shm_name, NULL, pools);
+	if (err) {
+		XAL_DEBUG("FAILED: attach_pools(); err(%d)", err);
+		xal->root_idx = root_idx;
+		xal->sb = sb;
+		return err;
+	}
+
+	for (size_t i = 0; i < sizeof(live) / sizeof(*live); ++i) {
+		xal_pool_unmap(live[i]);
+		*live[i] = pools[i];
+	}
+
+	return 0;
+}
+
+int
+xal_get_fds(struct xal *xal, struct xal_fds *fds)
+{
+	if (!xal->inodes.memfd || xal->manifest_fd < 0) {
+		XAL_DEBUG("FAILED: not opened with xal_opts.memfd");
+		return -EINVAL;
+	}
+
+	fds->manifest = xal->manifest_fd;
+	fds->inodes = xal->inodes.fd;
+	fds->inodes_cold = xal->inodes_cold.fd;
+	fds->extents = xal->extents.fd;
+	fds->names = xal->names.fd;
+
+	return 0;
+}
+
+int
+xal_prefault(struct xal *xal, int flags)
+{
+	struct xal_pool *hot[] = {&xal->inodes, &xal->extents, &xal->names};
+	int err;
+
+	err = xal_pool_prefault(&xal->inodes_cold, flags & ~XAL_PREFAULT_MLOCK);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_prefault(inodes_cold); err(%d)", err);
+		return err;
+	}
+
+	for (size_t i = 0; i < sizeof(hot) / sizeof(*hot); ++i) {
+		err = xal_pool_prefault(hot[i], flags);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_pool_prefault(); err(%d)", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static void
+replicas_close(struct xal *xal)
+{
+	for (int node = 0; node < XAL_POOL_NUMA_NODES_MAX; ++node) {
+		xal_close(xal->replicas[node]);
+		xal->replicas[node] = NULL;
+	}
+}
+
+/**
+ * Construct a read-only copy of the index of 'xal' with its pools on the given NUMA node
+ *
+ * Only the elements in use are copied. A view does not track the use of its pools, thus, it is
+ * taken from the manifest of an attached view, and a view of xal_from_pools() is copied whole.
+ */
+static int
+replica_create(struct xal *xal, int node, struct xal **out)
+{
+	struct xal_pool src[] = {xal->inodes, xal->inodes_cold, xal->extents, xal->names};
+	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+	struct xal *replica;
+	struct xal_pool *dst[4];
+	int err;
+
+	if (xal->manifest && xal->attached) {
+		const struct xal_manifest *manifest = xal->manifest;
+		const uint64_t nused[] = {manifest->ninodes, manifest->ninodes, manifest->nextents,
+					  manifest->nnames};
+
+		for (int i = 0; i < 4; ++i) {
+			src[i].free = nused[i] < src[i].allocated ? nused[i] : src[i].allocated;
+		}
+	} else if (xal->shared_view) {
+		for (int i = 0; i < 4; ++i) {
+			src[i].free = src[i].allocated;
+		}
+	}
+
+	replica = calloc(1, sizeof(*replica));
+	if (!replica) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		return -ENOMEM;
+	}
+
+	replica->sb = xal->sb;
+	replica->root_idx = xal->root_idx;
+	replica->compact_extents = xal->compact_extents;
+	replica->shared_view = true;
+	replica->attached = true;
+	replica->manifest_fd = -1;
+	replica->dirty = xal->dirty;
+	replica->seq_lock = &replica->_seq_lock_storage;
+	replica->generation = &replica->_generation_storage;
+	atomic_store(replica->generation, atomic_load(xal->generation));
+
+	if (be->type == XAL_BACKEND_FIEMAP) {
+		struct xal_be_fiemap *src_be = (struct xal_be_fiemap *)&xal->be;
+		struct xal_be_fiemap *dst_be = (struct xal_be_fiemap *)&replica->be;
+
+		dst_be->base.type = XAL_BACKEND_FIEMAP;
+		dst_be->base.close = xal_be_fiemap_close;
+		dst_be->mountpoint = strdup(src_be->mountpoint);
+		if (!dst_be->mountpoint) {
+			XAL_DEBUG("FAILED: strdup(); errno(%d)", errno);
+			xal_close(replica);
+			return -ENOMEM;
+		}
+	}
+
+	dst[0] = &replica->inodes;
+	dst[1] = &replica->inodes_cold;
+	dst[2] = &replica->extents;
+	dst[3] = &replica->names;
+
+	for (int i = 0; i < 4; ++i) {
+		err = xal_pool_replicate(dst[i], &src[i], node);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_pool_replicate(); err(%d)", err);
+			xal_close(replica);
+			return err;
+		}
+	}
+
+	*out = replica;
+
+	return 0;
+}
+
+int
+xal_replicate(struct xal *xal)
+{
+	unsigned long nodemask = xal_pool_numa_online();
+	int seq, err;
+
+	seq = atomic_load(xal->seq_lock);
+	if (seq & 1) {
+		XAL_DEBUG("FAILED: the index is being modified");
+		return -EBUSY;
+	}
+
+	replicas_close(xal);
+
+	for (int node = 0; node < XAL_POOL_NUMA_NODES_MAX; ++node) {
+		if (!(nodemask & (1UL << node))) {
+			continue;
+		}
+
+		err = replica_create(xal, node, &xal->replicas[node]);
+		if (err) {
+			XAL_DEBUG("FAILED: replica_create(%d); err(%d)", node, err);
+			replicas_close(xal);
+			return err;
+		}
+	}
+
+	if (seq != atomic_load(xal->seq_lock)) {
+		XAL_DEBUG("FAILED: the index was modified while replicating");
+		replicas_close(xal);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+/**
+ * Snapshot of a view, e.g. of xal_attach(), by copying the pools; the writer is not in this process
  */
-uint64_t
-xal_fsbno_offset(struct xal *xal, uint64_t fsbno)
+static int
+snapshot_copy(struct xal *xal, struct xal **snapshot)
 {
-	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+	for (int attempt = 0; attempt < XAL_SNAPSHOT_ATTEMPTS; ++attempt) {
+		struct xal *cand;
+		int seq, err;
+
+		seq = atomic_load(xal->seq_lock);
+		if (seq & 1) {
+			sched_yield();
+			continue;
+		}
 
-	switch (be->type) {
-		case XAL_BACKEND_FIEMAP:
-			return fsbno * xal->sb.blocksize;
+		err = replica_create(xal, -1, &cand);
+		if (err) {
+			XAL_DEBUG("FAILED: replica_create(); err(%d)", err);
+			return err;
+		}
 
-		case XAL_BACKEND_XFS:
-			uint64_t ag, bno;
+		if (seq != atomic_load(xal->seq_lock)) {
+			xal_close(cand);
+			continue;
+		}
 
-			ag = fsbno >> xal->sb.agblklog;
-			bno = fsbno & ((1 << xal->sb.agblklog) - 1);
+		cand->dirty = &cand->_dirty_storage;
+		atomic_store(cand->dirty, atomic_load(xal->dirty));
 
-			return (ag * xal->sb.agblocks + bno) * xal->sb.blocksize;
+		*snapshot = cand;
 
-		default:
-			XAL_DEBUG("FAILED: Unknown backend type(%d)", be->type);
-			return -EINVAL;
+		return 0;
 	}
+
+	XAL_DEBUG("FAILED: the index kept changing");
+
+	return -EAGAIN;
 }
 
-struct xal_inode *
-xal_inode_at(struct xal *xal, uint32_t idx)
+int
+xal_snapshot(struct xal *xal, struct xal **snapshot)
 {
-	return (struct xal_inode *)xal->inodes.memory + idx;
+	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+	struct xal *cand;
+	int pins, seq, err;
+
+	if (!xal || !snapshot) {
+		return -EINVAL;
+	}
+
+	if (xal->shared_view) {
+		return snapshot_copy(xal, snapshot);
+	}
+
+	cand = calloc(1, sizeof(*cand));
+	if (!cand) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		return -ENOMEM;
+	}
+
+	cand->shared_view = true;
+	cand->manifest_fd = -1;
+	cand->compact_extents = xal->compact_extents;
+	cand->dirty = &cand->_dirty_storage;
+	cand->seq_lock = &cand->_seq_lock_storage;
+	cand->generation = &cand->_generation_storage;
+
+	if (be->type == XAL_BACKEND_FIEMAP) {
+		struct xal_be_fiemap *src_be = (struct xal_be_fiemap *)&xal->be;
+		struct xal_be_fiemap *dst_be = (struct xal_be_fiemap *)&cand->be;
+
+		dst_be->base.type = XAL_BACKEND_FIEMAP;
+		dst_be->base.close = xal_be_fiemap_close;
+		dst_be->mountpoint = strdup(src_be->mountpoint);
+		if (!dst_be->mountpoint) {
+			XAL_DEBUG("FAILED: strdup(); errno(%d)", errno);
+			xal_close(cand);
+			return -ENOMEM;
+		}
+	}
+
+	/**
+	 * The writer is held off while pinning and copying, thus, the copy is consistent as taken;
+	 * a writer not excluded by it, i.e. xal_index_begin(), holds the sequence lock odd
+	 */
+	xal_writer_lock(xal);
+
+	seq = atomic_load(xal->seq_lock);
+	if (seq & 1) {
+		XAL_DEBUG("FAILED: the index is being modified");
+		xal_writer_unlock(xal);
+		xal_close(cand);
+		return -EBUSY;
+	}
+
+	/**
+	 * Pin before copying; from here on, the writer does not modify extents in-place, nor reuse
+	 * those released since 'seq'. The epoch is only published by the first pin, and a stale one
+	 * is lower, thus, the writer errs on not reusing a released range.
+	 */
+	pins = atomic_load(&xal->snapshots);
+	while (!atomic_compare_exchange_weak(&xal->snapshots, &pins, pins + 1)) {
+		;
+	}
+	if (!pins) {
+		atomic_store(&xal->snapshots_epoch, seq);
+	}
+	cand->snapshot_of = xal;
+
+	/**
+	 * Only the inodes are modified in-place by the writer, thus, these are copied while the
+	 * other pools are shared with the pinned xal
+	 */
+	err = xal_pool_replicate(&cand->inodes, &xal->inodes, -1);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_replicate(); err(%d)", err);
+		xal_writer_unlock(xal);
+		xal_close(cand);
+		return err;
+	}
+	cand->inodes_cold = xal->inodes_cold;
+	cand->extents = xal->extents;
+	cand->names = xal->names;
+	cand->sb = xal->sb;
+	cand->root_idx = xal->root_idx;
+	atomic_store(cand->dirty, atomic_load(xal->dirty));
+	atomic_store(cand->generation, atomic_load(xal->generation));
+
+	xal_writer_unlock(xal);
+
+	*snapshot = cand;
+
+	return 0;
 }
 
-struct xal_extent *
-xal_extent_at(struct xal *xal, uint32_t idx)
+struct xal *
+xal_replica(struct xal *xal)
 {
-	return (struct xal_extent *)xal->extents.memory + idx;
+	unsigned int cpu, node;
+
+	if (getcpu(&cpu, &node) || node >= XAL_POOL_NUMA_NODES_MAX || !xal->replicas[node]) {
+		return xal;
+	}
+
+	return xal->replicas[node];
 }
 
-uint32_t
-xal_inode_idx(struct xal *xal, struct xal_inode *inode)
+int
+xal_get_resident(struct xal *xal, struct xal_resident *resident)
 {
-	return (uint32_t)(inode - (struct xal_inode *)xal->inodes.memory);
+	if (!xal || !resident) {
+		return -EINVAL;
+	}
+
+	resident->inodes = xal_pool_resident(&xal->inodes);
+	resident->inodes_cold = xal_pool_resident(&xal->inodes_cold);
+	resident->extents = xal_pool_resident(&xal->extents);
+	resident->names = xal_pool_resident(&xal->names);
+
+	return 0;
 }
 
 int
-xal_from_pools(const struct xal_sb *sb, const char *mountpoint, void *inodes_mem,
-	void *extents_mem, _Atomic bool *dirty, struct xal **out)
+xal_seal(struct xal *xal)
 {
-	struct xal *xal;
-
-	xal = calloc(1, sizeof(*xal));
-	if (!xal) {
-		return -ENOMEM;
-	}
+	struct xal_pool *pools[] = {&xal->inodes, &xal->inodes_cold, &xal->extents, &xal->names};
+	int seq, err;
 
-	if (!dirty) {
-		free(xal);
+	if (xal->shared_view || !xal->inodes.memfd || xal->manifest_fd < 0) {
+		XAL_DEBUG("FAILED: not opened with xal_opts.memfd");
 		return -EINVAL;
 	}
+	if (atomic_load(&xal->sealed)) {
+		return 0;
+	}
 
-	xal->sb = *sb;
-	xal->root_idx = 0;
-	xal->shared_view = true;
-	xal->dirty = dirty;
+	/**
+	 * The pools are inaccessible while they are sealed, see xal_pool_seal(); thus, the watcher
+	 * is held off, and readers in other processes retry, until they are mapped read-only, after
+	 * which the watcher finds the index sealed
+	 */
+	xal_writer_lock(xal);
+
+	seq = atomic_load_explicit(xal->seq_lock, memory_order_relaxed);
+	if ((seq & 1) || !atomic_compare_exchange_strong_explicit(xal->seq_lock, &seq, seq + 1,
+								  memory_order_relaxed,
+								  memory_order_relaxed)) {
+		XAL_DEBUG("FAILED: the index is being modified");
+		xal_writer_unlock(xal);
+		return -EBUSY;
+	}
+	atomic_thread_fence(memory_order_release);
 
-	if (mountpoint) {
-		struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
-		be->base.type = XAL_BACKEND_FIEMAP;
-		be->base.close = xal_be_fiemap_close;
-		be->mountpoint = strdup(mountpoint);
-		if (!be->mountpoint) {
-			free(xal);
-			return -ENOMEM;
+	for (size_t i = 0; i < sizeof(pools) / sizeof(*pools); ++i) {
+		err = xal_pool_seal(pools[i]);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_pool_seal(); err(%d)", err);
+			xal_write_end(xal);
+			xal_writer_unlock(xal);
+			return err;
 		}
 	}
+	atomic_store(&xal->sealed, true);
 
-	xal->inodes.memory = inodes_mem;
-	xal->inodes.element_size = sizeof(struct xal_inode);
-
-	xal->extents.memory = extents_mem;
-	xal->extents.element_size = sizeof(struct xal_extent);
+	xal_write_end(xal);
+	xal_writer_unlock(xal);
 
-	*out = xal;
+	/**
+	 * The manifest remains writable by the producer, for the dirty flag and the generation; it
+	 * cannot be resized, nor mapped writable by others
+	 */
+	if (fcntl(xal->manifest_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE)) {
+		XAL_DEBUG("FAILED: fcntl(F_ADD_SEALS); errno(%d)", errno);
+		return -errno;
+	}
 
 	return 0;
 }
@@ -121,20 +1490,36 @@ xal_close(struct xal *xal)
 		return;
 	}
 
-	if (xal->shared_view) {
-		be = (struct xal_backend_base *)&xal->be;
-		if (be->close) {
-			be->close(xal);
-		}
-		free(xal);
-		return;
+	replicas_close(xal);
+
+	if (xal->snapshot_of) {
+		xal_pool_unmap(&xal->inodes);
+		atomic_fetch_sub(&xal->snapshot_of->snapshots, 1);
 	}
 
-	xal_pool_unmap(&xal->inodes);
-	xal_pool_unmap(&xal->extents);
+	if (xal->standby) {
+		xal_pool_unmap(&xal->standby->inodes);
+		xal_pool_unmap(&xal->standby->inodes_cold);
+		xal_pool_unmap(&xal->standby->extents);
+		xal_pool_unmap(&xal->standby->names);
+		free(xal->standby->deferred);
+		free(xal->standby);
+	}
+	free(xal->deferred);
+	free(xal->shm_name);
+
+	if (!xal->shared_view || xal->attached) {
+		xal_pool_unmap(&xal->inodes);
+		xal_pool_unmap(&xal->inodes_cold);
+		xal_pool_unmap(&xal->extents);
+		xal_pool_unmap(&xal->names);
+	}
 
-	if (xal->dirty != &xal->_dirty_storage) {
-		munmap(xal->dirty, sizeof(atomic_bool));
+	if (xal->manifest) {
+		munmap(xal->manifest, sizeof(*xal->manifest));
+	}
+	if (xal->manifest_fd >= 0) {
+		close(xal->manifest_fd);
 	}
 
 	be = (struct xal_backend_base *)&xal->be;
@@ -208,13 +1593,21 @@ xal_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts)
 			err = 0;
 		} else {
 			XAL_DEBUG("INFO: dev(%s) mounted at path(%s)", ident->uri, mountpoint);
-			opts->be = XAL_BACKEND_FIEMAP;
+			opts->be = opts->quiesce ? XAL_BACKEND_XFS : XAL_BACKEND_FIEMAP;
 		}
 	}
 
 	switch (opts->be) {
 		case XAL_BACKEND_XFS:
-			err = xal_be_xfs_open(dev, xal, opts);
+			if (opts->quiesce && (strlen(mountpoint) == 0)) {
+				err = retrieve_mountpoint(ident->uri, mountpoint);
+				if (err) {
+					XAL_DEBUG("FAILED: retrieve_mountpoint(); quiesce requires a mount");
+					return err;
+				}
+			}
+
+			err = xal_be_xfs_open(dev, xal, opts->quiesce ? mountpoint : NULL, opts);
 			if (err) {
 				XAL_DEBUG("FAILED: xal_be_xfs_open(); err(%d)", err);
 				return err;
@@ -246,21 +1639,26 @@ xal_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts)
 
 	(*xal)->dev = dev;
 
-	if (opts->shm_name) {
-		char shm_name[XAL_PATH_MAXLEN + 9];
+	if (opts->shm_name || opts->memfd) {
+		char shm_name[XAL_PATH_MAXLEN + 16];
+		struct xal_manifest *manifest;
 		int fd;
-		void *mem;
 
-		snprintf(shm_name, sizeof(shm_name), "%s_dirty", opts->shm_name);
+		snprintf(shm_name, sizeof(shm_name), "%s_manifest",
+			 opts->shm_name ? opts->shm_name : XAL_MEMFD_NAME);
 
-		fd = shm_open(shm_name, O_CREAT | O_RDWR, 0666);
+		if (opts->memfd) {
+			fd = memfd_create(shm_name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		} else {
+			fd = shm_open(shm_name, O_CREAT | O_RDWR, 0666);
+		}
 		if (fd < 0) {
-			XAL_DEBUG("FAILED: shm_open(%s); errno(%d)", shm_name, errno);
+			XAL_DEBUG("FAILED: open(%s); errno(%d)", shm_name, errno);
 			xal_close(*xal);
 			return -errno;
 		}
 
-		err = ftruncate(fd, sizeof(atomic_bool));
+		err = ftruncate(fd, 0) || ftruncate(fd, sizeof(*manifest));
 		if (err) {
 			XAL_DEBUG("FAILED: ftruncate(); errno(%d)", errno);
 			close(fd);
@@ -268,15 +1666,29 @@ xal_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts)
 			return -errno;
 		}
 
-		mem = mmap(NULL, sizeof(atomic_bool), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-		close(fd);
-		if (mem == MAP_FAILED) {
+		manifest = mmap(NULL, sizeof(*manifest), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (manifest == MAP_FAILED) {
 			XAL_DEBUG("FAILED: mmap(); errno(%d)", errno);
+			close(fd);
 			xal_close(*xal);
 			return -errno;
 		}
+		if (opts->memfd) {
+			(*xal)->manifest_fd = fd;
+		} else {
+			close(fd);
+		}
 
-		(*xal)->dirty = mem;
+		manifest->magic = XAL_MANIFEST_MAGIC;
+		manifest->version = XAL_MANIFEST_VERSION;
+		atomic_store(&manifest->seq_lock, atomic_load((*xal)->seq_lock));
+		atomic_store(&manifest->dirty, atomic_load((*xal)->dirty));
+		atomic_store(&manifest->generation, atomic_load((*xal)->generation));
+
+		(*xal)->manifest = manifest;
+		(*xal)->seq_lock = &manifest->seq_lock;
+		(*xal)->dirty = &manifest->dirty;
+		(*xal)->generation = &manifest->generation;
 	}
 
 	ns = xnvme_dev_get_ns(dev);
@@ -293,6 +1705,17 @@ xal_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts)
 
 	(*xal)->sb.lba_blksze = 1U << ns->lbaf[fidx].ds;
 
+	if (opts->prefault) {
+		err = xal_prefault(*xal, opts->prefault);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_prefault(); err(%d)", err);
+			xal_close(*xal);
+			return err;
+		}
+	}
+
+	xal_manifest_publish(*xal);
+
 	return 0;
 }
 
@@ -301,11 +1724,182 @@ xal_index(struct xal *xal)
 {
 	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
 
+	int err;
+
+	if (xal->shared_view) {
+		return -EINVAL;
+	}
+	if (atomic_load(&xal->sealed)) {
+		XAL_DEBUG("FAILED: the index is sealed");
+		return -EPERM;
+	}
+	if (atomic_load(&xal->snapshots)) {
+		XAL_DEBUG("FAILED: the index is pinned by snapshots");
+		return -EBUSY;
+	}
+
+	err = be->index(xal);
+	if (err) {
+		return err;
+	}
+
+	xal_manifest_publish(xal);
+
+	return 0;
+}
+
+int
+xal_compact(struct xal *xal)
+{
+	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+	const size_t ext_nbytes = xal->extents.element_size;
+	size_t ninodes = xal->inodes.free;
+	size_t nextents = xal->extents.free;
+	struct xal_inode_cold *inodes_cold = NULL;
+	struct xal_inode *inodes = NULL;
+	xal_idx_t *inodes_map = NULL;
+	uint8_t *extents = NULL;
+	xal_idx_t inodes_next = 1, extents_next = 0;
+	int seq, err = 0;
+
 	if (xal->shared_view) {
+		XAL_DEBUG("FAILED: cannot compact a shared view");
 		return -EINVAL;
 	}
+	if (atomic_load(&xal->sealed)) {
+		XAL_DEBUG("FAILED: the index is sealed");
+		return -EPERM;
+	}
+	if (atomic_load(&xal->snapshots)) {
+		XAL_DEBUG("FAILED: the index is pinned by snapshots");
+		return -EBUSY;
+	}
+
+	if (!ninodes || xal->root_idx >= ninodes) {
+		return 0;
+	}
+
+	inodes = malloc(ninodes * sizeof(*inodes));
+	inodes_cold = malloc(ninodes * sizeof(*inodes_cold));
+	inodes_map = malloc(ninodes * sizeof(*inodes_map));
+	extents = malloc(nextents ? nextents * ext_nbytes : 1);
+	if (!inodes || !inodes_cold || !inodes_map || !extents) {
+		XAL_DEBUG("FAILED: malloc(); errno(%d)", errno);
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	/**
+	 * The watcher updates the inodes which are rearranged here, through the pointers of its map,
+	 * which are relocated here; thus, it is excluded for the duration
+	 */
+	xal_writer_lock(xal);
+
+	seq = atomic_load_explicit(xal->seq_lock, memory_order_relaxed);
+	if ((seq & 1) || !atomic_compare_exchange_strong_explicit(xal->seq_lock, &seq, seq + 1,
+								  memory_order_relaxed,
+								  memory_order_relaxed)) {
+		XAL_DEBUG("FAILED: the index is being modified");
+		xal_writer_unlock(xal);
+		err = -EBUSY;
+		goto exit;
+	}
+	atomic_thread_fence(memory_order_release);
+
+	/**
+	 * A snapshot taken since the check above shares the extents rearranged here
+	 */
+	if (xal_pinned(xal)) {
+		XAL_DEBUG("FAILED: the index was pinned by a snapshot");
+		err = -EBUSY;
+		goto unlock;
+	}
+
+	for (size_t i = 0; i < ninodes; ++i) {
+		inodes_map[i] = XAL_POOL_IDX_NONE;
+	}
+
+	inodes[0] = *xal_inode_at(xal, xal->root_idx);
+	inodes_cold[0] = *inode_cold(xal, xal_inode_at(xal, xal->root_idx));
+	inodes_map[xal->root_idx] = 0;
+
+	/**
+	 * The new layout is built in breadth-first order; as directories are visited in the order
+	 * they are placed, the next free slot is where the children of the visited directory go.
+	 */
+	for (xal_idx_t cur = 0; cur < inodes_next; ++cur) {
+		struct xal_inode *inode = &inodes[cur];
+
+		if (xal_inode_is_dir(inode)) {
+			xal_idx_t first = inode->content.dentries.inodes_idx;
+			uint32_t count = inode->content.dentries.count;
+
+			if ((size_t)first + count > ninodes || inodes_next + count > ninodes) {
+				XAL_DEBUG("FAILED: dentries out of bounds; idx(%" PRIxal_idx ")", first);
+				err = -EIO;
+				goto unlock;
+			}
+
+			memcpy(&inodes[inodes_next], xal_inode_at(xal, first), count * sizeof(*inodes));
+			memcpy(&inodes_cold[inodes_next], inode_cold(xal, xal_inode_at(xal, first)),
+			       count * sizeof(*inodes_cold));
+
+			for (uint32_t i = 0; i < count; ++i) {
+				inodes_map[first + i] = inodes_next + i;
+				inodes[inodes_next + i].parent_idx = cur;
+			}
+
+			inode->content.dentries.inodes_idx = inodes_next;
+			inodes_next += count;
+		} else if (xal_inode_is_file(inode) && inode->content.extents.count) {
+			xal_idx_t first = inode->content.extents.extent_idx;
+			uint32_t count = inode->content.extents.count;
+
+			if ((size_t)first + count > nextents || extents_next + count > nextents) {
+				XAL_DEBUG("FAILED: extents out of bounds; idx(%" PRIxal_idx ")", first);
+				err = -EIO;
+				goto unlock;
+			}
+
+			memcpy(&extents[extents_next * ext_nbytes],
+			       (uint8_t *)xal->extents.memory + first * ext_nbytes, count * ext_nbytes);
+
+			inode->content.extents.extent_idx = extents_next;
+			extents_next += count;
+		}
+	}
+
+	memcpy(xal->inodes.memory, inodes, inodes_next * sizeof(*inodes));
+	memcpy(xal->inodes_cold.memory, inodes_cold, inodes_next * sizeof(*inodes_cold));
+	memcpy(xal->extents.memory, extents, extents_next * ext_nbytes);
+
+	err = xal_pool_truncate(&xal->inodes, inodes_next);
+	err = err ? err : xal_pool_truncate(&xal->inodes_cold, inodes_next);
+	err = err ? err : xal_pool_truncate(&xal->extents, extents_next);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_truncate(); err(%d)", err);
+		goto unlock;
+	}
+	xal->root_idx = 0;
+	xal->ndeferred = 0;
+
+	if (be->relocate) {
+		be->relocate(xal, inodes_map);
+	}
+
+	xal_manifest_publish(xal);
+
+unlock:
+	xal_write_end(xal);
+	xal_writer_unlock(xal);
+
+exit:
+	free(inodes);
+	free(inodes_cold);
+	free(inodes_map);
+	free(extents);
 
-	return be->index(xal);
+	return err;
 }
 
 static int
@@ -329,6 +1923,14 @@ _walk(struct xal *xal, struct xal_inode *inode, xal_walk_cb cb_func, void *cb_da
 	case XAL_ODF_DIR3_FT_DIR: {
 		struct xal_inode *inodes = xal_inode_at(xal, inode->content.dentries.inodes_idx);
 
+		if (!pool_holds(&xal->inodes, inode->content.dentries.inodes_idx,
+				inode->content.dentries.count) ||
+		    !pool_holds(&xal->inodes_cold, inode->content.dentries.inodes_idx,
+				inode->content.dentries.count)) {
+			XAL_DEBUG("FAILED: dentries beyond the mapped pools");
+			return -ESTALE;
+		}
+
 		for (uint32_t i = 0; i < inode->content.dentries.count; ++i) {
 			err = _walk(xal, &inodes[i], cb_func, cb_data, depth + 1);
 			if (err) {
@@ -369,7 +1971,133 @@ xal_is_dirty(struct xal *xal)
 int
 xal_get_seq_lock(struct xal *xal)
 {
-	return atomic_load(&xal->seq_lock);
+	return atomic_load(xal->seq_lock);
+}
+
+int
+xal_read_begin(struct xal *xal)
+{
+	int seq;
+
+	for (int spins = 0;; ++spins) {
+		seq = atomic_load_explicit(xal->seq_lock, memory_order_acquire);
+		if (!(seq & 1)) {
+			return seq;
+		}
+
+		/**
+		 * Most write-sections are a handful of stores, see xal_index(); those which are not,
+		 * e.g. the incremental index of the XFS backend, are waited out without burning the CPU
+		 */
+		if (spins >= XAL_READ_SPINS) {
+			sched_yield();
+		}
+	}
+}
+
+bool
+xal_read_retry(struct xal *xal, int seq)
+{
+	/**
+	 * Orders the loads of the read-section before the load of the sequence; pairs with the
+	 * release fence of xal_write_begin()
+	 */
+	atomic_thread_fence(memory_order_acquire);
+
+	return atomic_load_explicit(xal->seq_lock, memory_order_relaxed) != seq;
+}
+
+void
+xal_writer_lock(struct xal *xal)
+{
+	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+
+	if (be->lock) {
+		be->lock(xal);
+	}
+}
+
+void
+xal_writer_unlock(struct xal *xal)
+{
+	struct xal_backend_base *be = (struct xal_backend_base *)&xal->be;
+
+	if (be->unlock) {
+		be->unlock(xal);
+	}
+}
+
+void
+xal_write_begin(struct xal *xal)
+{
+	atomic_fetch_add_explicit(xal->seq_lock, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+void
+xal_write_end(struct xal *xal)
+{
+	atomic_fetch_add_explicit(xal->seq_lock, 1, memory_order_release);
+}
+
+int
+xal_inode_extents_copy(struct xal *xal, int seq, xal_idx_t idx, struct xal_extent *extents,
+		       uint32_t capacity, uint32_t *count)
+{
+	const struct xal_inode *inodes = xal->inodes.memory;
+	const void *extents_memory = xal->extents.memory;
+	size_t ninodes = xal->inodes.allocated;
+	size_t nextents = xal->extents.allocated;
+	bool compact = xal->compact_extents;
+	struct xal_extents content;
+	uint8_t ftype;
+
+	/**
+	 * The geometry of the pools is validated before it is used for addressing; thereafter, the
+	 * pools may be replaced by a re-index, but stay mapped until xal_close(): the replaced
+	 * pools become the standby of xal_pools_stage(), whose shared objects are renewed in place
+	 */
+	if (xal_read_retry(xal, seq)) {
+		return -EAGAIN;
+	}
+
+	if (idx >= ninodes) {
+		XAL_DEBUG("FAILED: idx(%" PRIxal_idx ") out of bounds", idx);
+		return -EINVAL;
+	}
+
+	ftype = inodes[idx].ftype;
+	content = inodes[idx].content.extents;
+
+	if (ftype != XAL_ODF_DIR3_FT_REG_FILE) {
+		XAL_DEBUG("FAILED: idx(%" PRIxal_idx ") is not a file", idx);
+		return -EINVAL;
+	}
+	if (content.count && (size_t)content.extent_idx + content.count > nextents) {
+		XAL_DEBUG("FAILED: extents out of bounds; idx(%" PRIxal_idx ")", content.extent_idx);
+		return -EIO;
+	}
+
+	for (uint32_t i = 0; i < content.count && i < capacity; ++i) {
+		extent_decode(extents_memory, compact, content.extent_idx + i, &extents[i]);
+	}
+	*count = content.count;
+
+	return content.count > capacity ? -ENOBUFS : 0;
+}
+
+int
+xal_read_inode_extents(struct xal *xal, xal_idx_t idx, struct xal_extent *extents,
+		       uint32_t capacity, uint32_t *count)
+{
+	int seq, err;
+
+	do {
+		seq = xal_read_begin(xal);
+		err = xal_inode_extents_copy(xal, seq, idx, extents, capacity, count);
+	} while (xal_read_retry(xal, seq));
+
+	return err;
 }
 
 const struct xal_sb *
@@ -397,7 +2125,7 @@ xal_inode_path_pp(struct xal *xal, struct xal_inode *inode)
 	}
 
 	wrtn += xal_inode_path_pp(xal, xal_inode_at(xal, inode->parent_idx));
-	wrtn += printf("/%.*s", inode->namelen, inode->name);
+	wrtn += printf("/%.*s", inode->namelen, xal_inode_name(xal, inode));
 
 	return wrtn;
 }
@@ -9,6 +9,7 @@
 #include <linux/fiemap.h>
 #include <linux/fs.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -16,6 +17,7 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <unistd.h>
 #include <xal.h>
 #include <xal_be_fiemap.h>
@@ -57,6 +59,68 @@ xal_be_fiemap_close(struct xal *xal)
 	return;
 }
 
+void
+xal_be_fiemap_lock(struct xal *xal)
+{
+	struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
+
+	if (be->inotify) {
+		pthread_mutex_lock(&be->inotify->lock);
+	}
+}
+
+void
+xal_be_fiemap_unlock(struct xal *xal)
+{
+	struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
+
+	if (be->inotify) {
+		pthread_mutex_unlock(&be->inotify->lock);
+	}
+}
+
+/**
+ * Destroy a map of paths replaced within a write-section; lookups count themselves before loading
+ * the map, thus, once none are counted after the replacement, none probes the replaced map
+ */
+static void
+path_inode_map_retire(struct xal_be_fiemap *be, khash_t(path_to_inode) *replaced)
+{
+	if (!replaced) {
+		return;
+	}
+
+	atomic_thread_fence(memory_order_seq_cst);
+	while (atomic_load(&be->path_inode_probes)) {
+		sched_yield();
+	}
+
+	kh_destroy(path_to_inode, replaced);
+}
+
+void
+xal_be_fiemap_relocate(struct xal *xal, const xal_idx_t *inodes_map)
+{
+	struct xal_be_fiemap *be = (struct xal_be_fiemap *)xal->be;
+	khash_t(path_to_inode) *map = be->path_inode_map;
+
+	if (be->inotify) {
+		xal_be_fiemap_inotify_relocate(be->inotify, xal, inodes_map);
+	}
+
+	if (!map) {
+		return;
+	}
+
+	for (khiter_t iter = kh_begin(map); iter != kh_end(map); ++iter) {
+		if (kh_exist(map, iter)) {
+			xal_idx_t idx = inodes_map[xal_inode_idx(xal, kh_value(map, iter))];
+
+			kh_value(map, iter) = xal_inode_at(xal, idx);
+		}
+	}
+}
+
 static bool
 _is_directory_member(char *name)
 {
@@ -128,9 +192,8 @@ xal_be_fiemap_open(struct xal **xal, char *mountpoint, struct xal_opts *opts)
 {
 	struct xal *cand;
 	struct stat sb;
+	struct statvfs vfs;
 	struct xal_be_fiemap *be;
-	char shm_name[XAL_PATH_MAXLEN + 9];
-	const char *shm;
 	int nallocated, err;
 
 	if (!mountpoint) {
@@ -146,12 +209,19 @@ xal_be_fiemap_open(struct xal **xal, char *mountpoint, struct xal_opts *opts)
 
 	cand->root_idx = XAL_POOL_IDX_NONE;
 	cand->dirty = &cand->_dirty_storage;
+	cand->seq_lock = &cand->_seq_lock_storage;
+	cand->generation = &cand->_generation_storage;
+	cand->manifest_fd = -1;
+	cand->merge_extents = opts->merge_extents;
 
 	be = (struct xal_be_fiemap *)&cand->be;
 
 	be->base.type = XAL_BACKEND_FIEMAP;
 	be->base.close = xal_be_fiemap_close;
 	be->base.index = xal_be_fiemap_index;
+	be->base.relocate = xal_be_fiemap_relocate;
+	be->base.lock = xal_be_fiemap_lock;
+	be->base.unlock = xal_be_fiemap_unlock;
 
 	be->mountpoint = calloc(strlen(mountpoint) + 1, sizeof(char));
 	if (!be->mountpoint) {
@@ -194,31 +264,17 @@ xal_be_fiemap_open(struct xal **xal, char *mountpoint, struct xal_opts *opts)
 	cand->sb.blocksize = sb.st_blksize;
 	cand->sb.rootino = sb.st_ino;
 
-	if (opts->shm_name && strlen(opts->shm_name) > XAL_PATH_MAXLEN) {
-		XAL_DEBUG("FAILED: shm_name too long");
-		err = -EINVAL;
-		goto failed;
-	}
-
-	shm = NULL;
-	if (opts->shm_name) {
-		snprintf(shm_name, sizeof(shm_name), "%s_inodes", opts->shm_name);
-		shm = shm_name;
-	}
-	err = xal_pool_map(&cand->inodes, 40000000UL, nallocated, sizeof(struct xal_inode), shm);
+	err = statvfs(be->mountpoint, &vfs);
 	if (err) {
-		XAL_DEBUG("FAILED: xal_pool_map(inodes); err(%d)", err);
+		XAL_DEBUG("FAILED: statvfs(%s); errno(%d)", be->mountpoint, errno);
+		err = -errno;
 		goto failed;
 	}
 
-	shm = NULL;
-	if (opts->shm_name) {
-		snprintf(shm_name, sizeof(shm_name), "%s_extents", opts->shm_name);
-		shm = shm_name;
-	}
-	err = xal_pool_map(&cand->extents, 40000000UL, nallocated, sizeof(struct xal_extent), shm);
+	err = xal_pools_map(cand, nallocated, (size_t)vfs.f_blocks * vfs.f_frsize / sb.st_blksize,
+			    opts);
 	if (err) {
-		XAL_DEBUG("FAILED: xal_pool_map(extents); err(%d)", err);
+		XAL_DEBUG("FAILED: xal_pools_map(); err(%d)", err);
 		goto failed;
 	}
 
@@ -315,9 +371,9 @@ xal_be_fiemap_process_inode_dir(struct xal *xal, char *path, struct xal_inode *i
 
 	qsort(entries, n_entries, sizeof(*entries), compare_dirent);
 
-	err = xal_pool_claim_inodes(&xal->inodes, n_entries, &inode->content.dentries.inodes_idx);
+	err = xal_inodes_claim(xal, n_entries, &inode->content.dentries.inodes_idx);
 	if (err) {
-		XAL_DEBUG("FAILED: xal_pool_claim_inodes(); err(%d)", err);
+		XAL_DEBUG("FAILED: xal_inodes_claim(); err(%d)", err);
 		goto exit;
 	}
 	inode->content.dentries.count = 0;
@@ -331,8 +387,11 @@ xal_be_fiemap_process_inode_dir(struct xal *xal, char *path, struct xal_inode *i
 		char dentry_path[strlen(path) + 1 + strlen(entry_name) + 1];
 		snprintf(dentry_path, sizeof(dentry_path), "%s/%s", path, entry_name);
 
-		strcpy(dentry->name, dentry_path);
-		dentry->namelen = strlen(dentry->name);
+		err = xal_inode_name_set(xal, dentry, dentry_path, strlen(dentry_path));
+		if (err) {
+			XAL_DEBUG("FAILED: xal_inode_name_set(); err(%d)", err);
+			goto exit;
+		}
 		dentry->parent_idx = xal_inode_idx(xal, inode);
 
 		inode->content.dentries.count += 1;
@@ -348,7 +407,7 @@ xal_be_fiemap_process_inode_dir(struct xal *xal, char *path, struct xal_inode *i
 		khash_t(path_to_inode) *map = be->path_inode_map;
 		khiter_t iter;
 
-		iter = kh_put(path_to_inode, map, inode->name, &err);
+		iter = kh_put(path_to_inode, map, xal_inode_name(xal, inode), &err);
 		if (err < 0) {
 			XAL_DEBUG("FAILED: kh_put(); err(%d)", err);
 			err = -EIO;
@@ -419,67 +478,129 @@ read_fiemap(int fd, struct fiemap **fiemap_ptr)
 	return 0;
 }
 
+int
+xal_be_fiemap_retrieve(const char *path, struct fiemap **fiemap)
+{
+	struct fiemap *cand;
+	int fd, err;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		XAL_DEBUG("FAILED: open(%s); errno(%d)", path, errno);
+		return -errno;
+	}
+
+	cand = calloc(1, sizeof(*cand));
+	if (!cand) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		err = -errno;
+		close(fd);
+		return err;
+	}
+
+	err = read_fiemap(fd, &cand);
+	close(fd);
+	if (err) {
+		XAL_DEBUG("FAILED: read_fiemap(); err(%d)", err);
+		free(cand);
+		return err;
+	}
+
+	*fiemap = cand;
+
+	return 0;
+}
+
 int
 xal_be_fiemap_process_inode_file(struct xal *xal, char *path, struct xal_inode *inode)
 {
 	struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
+	struct xal_extents *extents;
 	struct fiemap *fiemap;
-	int fd, err = 0;
+	uint32_t capacity, nrecords = 0;
+	int err = 0;
 
 	if (!xal_inode_is_file(inode)) {
 		XAL_DEBUG("FAILED: cannot process file at path(%s) - not a file", path);
 		return -EINVAL;
 	}
 
-	fd = open(path, O_RDONLY);
-	if (fd < 0) {
-		XAL_DEBUG("FAILED: open(%s); errno(%d)", path, errno);
-		return -errno;
+	err = xal_be_fiemap_retrieve(path, &fiemap);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_be_fiemap_retrieve(); err(%d)", err);
+		return err;
 	}
 
-	fiemap = malloc(sizeof(struct fiemap));
-	if (!fiemap) {
-		XAL_DEBUG("FAILED: malloc(); errno(%d)", errno);
-		goto failed;
-	}
-	memset(fiemap, 0, sizeof(struct fiemap));
+	/**
+	 * When re-processing a file, e.g. on XAL_WATCHMODE_EXTENT_UPDATE, its records are updated
+	 * in-place if the new extents fit; otherwise, or while snapshots reference the records, see
+	 * xal_snapshot(), they are released and records are claimed anew
+	 */
+	capacity = inode->content.extents.count;
+	extents = &inode->content.extents;
 
-	err = read_fiemap(fd, &fiemap);
-	if (err) {
-		XAL_DEBUG("FAILED: read_fiemap(); err(%d)", err);
-		goto failed;
+	for (uint32_t i = 0; i < fiemap->fm_mapped_extents; i++) {
+		nrecords += xal_extent_nrecords(xal, fiemap->fm_extents[i].fe_length / xal->sb.blocksize);
 	}
 
-	if (fiemap->fm_mapped_extents > 0) {
-		struct xal_extents *extents;
+	if (nrecords > capacity || xal_pinned(xal)) {
+		err = xal_extents_release(xal, extents->extent_idx, capacity);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extents_release(); err(%d)", err);
+			free(fiemap);
+			return err;
+		}
+		extents->count = 0;
 
-		err = xal_pool_claim_extents(&xal->extents, fiemap->fm_mapped_extents, &inode->content.extents.extent_idx);
+		err = xal_extents_claim(xal, nrecords, &extents->extent_idx);
 		if (err) {
-			XAL_DEBUG("FAILED: xal_pool_claim_extents(); err(%d)", err);
-			goto failed;
+			XAL_DEBUG("FAILED: xal_extents_claim(); err(%d)", err);
+			free(fiemap);
+			return err;
+		}
+	} else {
+		err = xal_extents_release(xal, extents->extent_idx + nrecords, capacity - nrecords);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extents_release(); err(%d)", err);
+			free(fiemap);
+			return err;
 		}
+	}
+	extents->count = 0;
 
-		extents = &inode->content.extents;
-		extents->count = fiemap->fm_mapped_extents;
+	for (uint32_t i = 0; i < fiemap->fm_mapped_extents; i++) {
+		struct xal_extent extent = {0};
 
-		for (uint32_t i = 0; i < extents->count; i++) {
-			struct xal_extent *extent = xal_extent_at(xal, extents->extent_idx + i);
+		extent.start_offset = fiemap->fm_extents[i].fe_logical / xal->sb.blocksize;
+		extent.start_block  = fiemap->fm_extents[i].fe_physical / xal->sb.blocksize;
+		extent.nblocks      = fiemap->fm_extents[i].fe_length / xal->sb.blocksize;
+		extent.flag         = !!(fiemap->fm_extents[i].fe_flags & FIEMAP_EXTENT_UNWRITTEN);
 
-			extent->start_offset = fiemap->fm_extents[i].fe_logical / xal->sb.blocksize;
-			extent->start_block  = fiemap->fm_extents[i].fe_physical / xal->sb.blocksize;
-			extent->nblocks      = fiemap->fm_extents[i].fe_length / xal->sb.blocksize;
-			extent->flag         = fiemap->fm_extents[i].fe_flags;
+		err = xal_extent_set(xal, extents->extent_idx + extents->count, &extent);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extent_set(); err(%d)", err);
+			free(fiemap);
+			return err;
+		}
+		extents->count += xal_extent_nrecords(xal, extent.nblocks);
+	}
+
+	if (xal->merge_extents && extents->count) {
+		err = xal_extents_merge(xal, extents);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extents_merge(); err(%d)", err);
+			free(fiemap);
+			return err;
 		}
 	}
 
 	free(fiemap);
-	close(fd);
 
 	if (be->path_inode_map) {
 		khash_t(path_to_inode) *map = be->path_inode_map;
 		khiter_t iter;
 
-		iter = kh_put(path_to_inode, map, inode->name, &err);
+		iter = kh_put(path_to_inode, map, xal_inode_name(xal, inode), &err);
 		if (err < 0) {
 			XAL_DEBUG("FAILED: kh_put(); err(%d)", err);
 			return -EIO;
@@ -488,14 +609,6 @@ xal_be_fiemap_process_inode_file(struct xal *xal, char *path, struct xal_inode *
 	}
 
 	return 0;
-
-failed:
-	free(fiemap);
-	if (fd) {
-		close(fd);
-	}
-
-	return err;
 }
 
 static int
@@ -555,11 +668,26 @@ process_ino_fiemap(struct xal *xal, char *path, struct xal_inode *self)
 	return 0;
 }
 
+/**
+ * Build the index aside, into the standby pools, while readers continue on the published index;
+ * the write-section of the sequence lock covers only the publish of the new pools and root
+ *
+ * The publish is serialised with the updates of the inotify watcher, and fails with -EBUSY when a
+ * snapshot was taken while building; on failure, the published index is left in place. The index
+ * is left dirty when the watcher updated it, or the file system was marked changed, while building,
+ * as those changes may have been missed by the walk.
+ */
 int
 xal_be_fiemap_index(struct xal *xal)
 {
 	struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
+	struct xal_inotify staged_inotify = {0};
+	khash_t(path_to_inode) *replaced = NULL;
+	struct xal_be_fiemap *staged_be;
 	struct xal_inode *root;
+	struct xal *staged;
+	uint32_t generation;
+	bool was_dirty, dirty;
 	int err;
 
 	if (!strlen(be->mountpoint)) {
@@ -567,62 +695,143 @@ xal_be_fiemap_index(struct xal *xal)
 		return -EINVAL;
 	}
 
-	XAL_DEBUG("INFO: waiting for xal lock");
-	atomic_fetch_add(&xal->seq_lock, 1);
+	/**
+	 * Taken between the updates of the watcher; those it publishes since advance the
+	 * generation, while the changes it cannot apply mark the index dirty
+	 */
+	xal_be_fiemap_lock(xal);
+	generation = xal_get_generation(xal);
+	was_dirty = atomic_load(xal->dirty);
+	xal_be_fiemap_unlock(xal);
+
+	err = xal_pools_stage(xal, &staged);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pools_stage(); err(%d)", err);
+		return err;
+	}
+
+	staged_be = (struct xal_be_fiemap *)&staged->be;
+	atomic_store(&staged_be->path_inode_probes, 0);
 
-	xal_pool_clear(&xal->inodes);
-	xal_pool_clear(&xal->extents);
+	if (be->path_inode_map) {
+		staged_be->path_inode_map = kh_init(path_to_inode);
+		if (!staged_be->path_inode_map) {
+			XAL_DEBUG("FAILED: kh_init()");
+			err = -ENOMEM;
+			goto failed;
+		}
+	}
 
 	if (be->inotify) {
-		err = xal_be_fiemap_inotify_clear_inode_map(be->inotify);
+		err = xal_be_fiemap_inotify_stage(be->inotify, &staged_inotify);
 		if (err) {
-			XAL_DEBUG("FAILED: xal_be_fiemap_inotify_clear_inode_map(); err(%d)", err);
-			goto exit;
+			XAL_DEBUG("FAILED: xal_be_fiemap_inotify_stage(); err(%d)", err);
+			goto failed;
 		}
+		staged_be->inotify = &staged_inotify;
 	}
 
-	err = xal_pool_claim_inodes(&xal->inodes, 1, &xal->root_idx);
+	err = xal_inodes_claim(staged, 1, &staged->root_idx);
 	if (err) {
-		XAL_DEBUG("FAILED: xal_pool_claim_inodes(); err(%d)", err);
-		goto exit;
+		XAL_DEBUG("FAILED: xal_inodes_claim(); err(%d)", err);
+		goto failed;
 	}
 
-	root = xal_inode_at(xal, xal->root_idx);
-	root->ino = xal->sb.rootino;
+	root = xal_inode_at(staged, staged->root_idx);
+	root->ino = staged->sb.rootino;
 	root->ftype = XAL_ODF_DIR3_FT_DIR;
-	root->namelen = 0;
 	root->parent_idx = XAL_POOL_IDX_NONE;
 	root->content.extents.count = 0;
 	root->content.dentries.count = 0;
 
-	err = process_ino_fiemap(xal, be->mountpoint, root);
+	err = xal_inode_name_set(staged, root, "", 0);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_inode_name_set(); err(%d)", err);
+		goto failed;
+	}
+
+	err = process_ino_fiemap(staged, be->mountpoint, root);
 	if (err) {
 		XAL_DEBUG("FAILED: process_ino_fiemap(); err(%d)", err);
-		goto exit;
+		goto failed;
 	}
 
-	atomic_store(xal->dirty, false);
+	xal_be_fiemap_lock(xal);
 
-exit:
-	atomic_fetch_add(&xal->seq_lock, 1);
+	XAL_DEBUG("INFO: waiting for xal lock");
+	xal_write_begin(xal);
+
+	/**
+	 * A snapshot taken while building shares the pools about to be replaced
+	 */
+	if (xal_pinned(xal)) {
+		XAL_DEBUG("FAILED: the index was pinned by a snapshot while re-indexing");
+		err = -EBUSY;
+		goto failed_with_lock;
+	}
+
+	err = xal_pools_publish(xal);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pools_publish(); err(%d)", err);
+		goto failed_with_lock;
+	}
+
+	if (be->path_inode_map) {
+		replaced = be->path_inode_map;
+		be->path_inode_map = staged_be->path_inode_map;
+		staged_be->path_inode_map = NULL;
+	}
+	if (be->inotify) {
+		xal_be_fiemap_inotify_publish(be->inotify, &staged_inotify);
+		staged_be->inotify = NULL;
+	}
+
+	dirty = xal_get_generation(xal) != generation || (atomic_load(xal->dirty) && !was_dirty);
+	atomic_store(xal->dirty, dirty);
+
+	xal_manifest_update(xal);
+
+	xal_write_end(xal);
+	xal_be_fiemap_unlock(xal);
+
+	path_inode_map_retire(be, replaced);
+
+	return 0;
+
+failed_with_lock:
+	xal_write_end(xal);
+	xal_be_fiemap_unlock(xal);
+
+failed:
+	if (staged_be->path_inode_map) {
+		kh_destroy(path_to_inode, staged_be->path_inode_map);
+		staged_be->path_inode_map = NULL;
+	}
+	xal_be_fiemap_inotify_discard(&staged_inotify);
+	staged_be->inotify = NULL;
 
 	return err;
 }
 
+struct name_search_key {
+	struct xal *xal;
+	const char *component;
+};
+
 static int
 compare_name_to_inode(const void *key, const void *elem)
 {
-	const char *component = key;
-	const struct xal_inode *inode = elem;
+	const struct name_search_key *search = key;
+	const char *name = xal_inode_name(search->xal, elem);
 
-	const char *basename = strrchr(inode->name, '/');
+	const char *basename = strrchr(name, '/');
 	if (basename) {
 		basename++;
 	} else {
-		basename = inode->name;
+		basename = name;
 	}
 
-	return strcmp(component, basename);
+	return strcmp(search->component, basename);
 }
 
 static int
@@ -660,13 +869,14 @@ search_by_traversal(struct xal *xal, struct xal_inode *root, char *path, struct
 		struct xal_inode *child;
 		size_t search_len = search_end ? (size_t)(search_end - search_begin) : strlen(search_begin);
 		char component[search_len + 1];
+		struct name_search_key key = {.xal = xal, .component = component};
 
 		memcpy(component, search_begin, search_len);
 		component[search_len] = '\0';
 
 		XAL_DEBUG("Searching for component(%s)", component);
 
-		child = bsearch(component, xal_inode_at(xal, search->content.dentries.inodes_idx),
+		child = bsearch(&key, xal_inode_at(xal, search->content.dentries.inodes_idx),
 				search->content.dentries.count, sizeof(struct xal_inode), compare_name_to_inode);
 
 		if (!child) {
@@ -696,17 +906,15 @@ search_by_traversal(struct xal *xal, struct xal_inode *root, char *path, struct
 }
 
 static int
-build_hashmap_walk(struct xal *xal, struct xal_inode *inode)
+build_hashmap_walk(struct xal *xal, khash_t(path_to_inode) *map, struct xal_inode *inode)
 {
-	struct xal_be_fiemap *be = (struct xal_be_fiemap *)&xal->be;
-	khash_t(path_to_inode) *map = be->path_inode_map;
 	khiter_t iter;
 	int err;
 
 	if (inode->namelen > 0) {
-		iter = kh_put(path_to_inode, map, inode->name, &err);
+		iter = kh_put(path_to_inode, map, xal_inode_name(xal, inode), &err);
 		if (err < 0) {
-			XAL_DEBUG("FAILED: kh_put(%s); err(%d)", inode->name, err);
+			XAL_DEBUG("FAILED: kh_put(%s); err(%d)", xal_inode_name(xal, inode), err);
 			return -EIO;
 		}
 		kh_value(map, iter) = inode;
@@ -716,7 +924,7 @@ build_hashmap_walk(struct xal *xal, struct xal_inode *inode)
 		for (uint32_t i = 0; i < inode->content.dentries.count; i++) {
 			struct xal_inode *child = xal_inode_at(xal, inode->content.dentries.inodes_idx + i);
 
-			err = build_hashmap_walk(xal, child);
+			err = build_hashmap_walk(xal, map, child);
 			if (err) {
 				return err;
 			}
@@ -729,6 +937,7 @@ build_hashmap_walk(struct xal *xal, struct xal_inode *inode)
 int
 xal_build_lookup_hashmap(struct xal *xal)
 {
+	khash_t(path_to_inode) *map, *replaced;
 	struct xal_be_fiemap *be;
 	int err;
 
@@ -743,24 +952,29 @@ xal_build_lookup_hashmap(struct xal *xal)
 		return -EINVAL;
 	}
 
-	if (be->path_inode_map) {
-		kh_destroy(path_to_inode, be->path_inode_map);
-	}
-
-	be->path_inode_map = kh_init(path_to_inode);
-	if (!be->path_inode_map) {
+	map = kh_init(path_to_inode);
+	if (!map) {
 		XAL_DEBUG("FAILED: kh_init()");
 		return -ENOMEM;
 	}
 
-	err = build_hashmap_walk(xal, xal_inode_at(xal, xal->root_idx));
+	err = build_hashmap_walk(xal, map, xal_inode_at(xal, xal->root_idx));
 	if (err) {
 		XAL_DEBUG("FAILED: build_hashmap_walk(); err(%d)", err);
-		kh_destroy(path_to_inode, be->path_inode_map);
-		be->path_inode_map = NULL;
+		kh_destroy(path_to_inode, map);
 		return err;
 	}
 
+	/**
+	 * Replaced as by xal_index(), thus, a concurrent xal_read_extents() retries its lookup
+	 */
+	xal_write_begin(xal);
+	replaced = be->path_inode_map;
+	be->path_inode_map = map;
+	xal_write_end(xal);
+
+	path_inode_map_retire(be, replaced);
+
 	return 0;
 }
 
@@ -788,16 +1002,28 @@ xal_get_inode(struct xal *xal, char *path, struct xal_inode **inode)
 	}
 
 	if (be->path_inode_map) {
-		kh_path_to_inode_t *map = be->path_inode_map;
-		khiter_t iter = kh_get(path_to_inode, map, path);
+		kh_path_to_inode_t *map;
+		khiter_t iter;
+		bool found;
+
+		/**
+		 * Counted before loading the map, such that a map replaced meanwhile is not
+		 * destroyed while probed, see path_inode_map_retire()
+		 */
+		atomic_fetch_add(&be->path_inode_probes, 1);
+		map = be->path_inode_map;
+		iter = kh_get(path_to_inode, map, path);
+		found = iter != kh_end(map);
+		if (found) {
+			*inode = kh_val(map, iter);
+		}
+		atomic_fetch_sub(&be->path_inode_probes, 1);
 
-		if (iter == kh_end(map)) {
+		if (!found) {
 			XAL_DEBUG("FAILED: kh_get(%s)", path);
 			return -EINVAL;
 		}
 
-		*inode = kh_val(map, iter);
-
 	} else {
 		err = search_by_traversal(xal, xal_inode_at(xal, xal->root_idx), path, inode);
 		if (err) {
@@ -831,6 +1057,29 @@ xal_get_extents(struct xal *xal, char *path, struct xal_extents **extents)
 	return 0;
 }
 
+int
+xal_read_extents(struct xal *xal, char *path, struct xal_extent *extents, uint32_t capacity,
+		 uint32_t *count)
+{
+	struct xal_inode *inode;
+	int seq, err;
+
+	do {
+		seq = xal_read_begin(xal);
+
+		err = xal_get_inode(xal, path, &inode);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_get_inode(); err(%d)", err);
+			continue;
+		}
+
+		err = xal_inode_extents_copy(xal, seq, xal_inode_idx(xal, inode), extents, capacity,
+					     count);
+	} while (xal_read_retry(xal, seq));
+
+	return err;
+}
+
 int
 xal_get_dentries(struct xal *xal, char *path, struct xal_dentries **dentries)
 {
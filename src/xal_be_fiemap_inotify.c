@@ -3,6 +3,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <khash.h>
+#include <limits.h>
 #include <libxal.h>
 #include <linux/fs.h>
 #include <poll.h>
@@ -38,6 +39,9 @@ xal_be_fiemap_inotify_close(struct xal_inotify *inotify)
 	if (inode_map) {
 		kh_destroy(wd_to_inode, inode_map);
 	}
+	if (inotify->inode_map_retired) {
+		kh_destroy(wd_to_inode, inotify->inode_map_retired);
+	}
 
 	if (inotify->fd) {
 		close(inotify->fd);
@@ -46,11 +50,15 @@ xal_be_fiemap_inotify_close(struct xal_inotify *inotify)
 	if (inotify->flag & XAL_BE_FIEMAP_INOTIFY_RUNNING) {
 		pthread_cancel(inotify->watch_thread_id);
 	}
+
+	pthread_mutex_destroy(&inotify->lock);
 }
 
 int
 xal_be_fiemap_inotify_init(struct xal_inotify *inotify, enum xal_watchmode watch_mode)
 {
+	int err;
+
 	if (!inotify) {
 		XAL_DEBUG("FAILED: No xal_inotify given");
 		return -EINVAL;
@@ -58,6 +66,12 @@ xal_be_fiemap_inotify_init(struct xal_inotify *inotify, enum xal_watchmode watch
 
 	inotify->watch_mode = watch_mode;
 
+	err = pthread_mutex_init(&inotify->lock, NULL);
+	if (err) {
+		XAL_DEBUG("FAILED: pthread_mutex_init(); err(%d)", err);
+		return -err;
+	}
+
 	if (!inotify->watch_mode) {
 		XAL_DEBUG("INFO: Skipping xal_be_fiemap_inotify_init(), watch mode none given");
 		return 0;
@@ -95,6 +109,62 @@ xal_be_fiemap_inotify_clear_inode_map(struct xal_inotify *inotify)
 	return 0;
 }
 
+int
+xal_be_fiemap_inotify_stage(struct xal_inotify *inotify, struct xal_inotify *staged)
+{
+	/**
+	 * Only what adding watches takes is copied; not 'lock', which is not to be copied, nor the
+	 * state of the watch thread
+	 */
+	memset(staged, 0, sizeof(*staged));
+	staged->watch_mode = inotify->watch_mode;
+	staged->fd = inotify->fd;
+
+	staged->inode_map = kh_init(wd_to_inode);
+	if (!staged->inode_map) {
+		XAL_DEBUG("FAILED: kh_init()");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+void
+xal_be_fiemap_inotify_publish(struct xal_inotify *inotify, struct xal_inotify *staged)
+{
+	if (inotify->inode_map_retired) {
+		kh_destroy(wd_to_inode, inotify->inode_map_retired);
+	}
+
+	inotify->inode_map_retired = inotify->inode_map;
+	inotify->inode_map = staged->inode_map;
+	staged->inode_map = NULL;
+}
+
+void
+xal_be_fiemap_inotify_discard(struct xal_inotify *staged)
+{
+	if (staged->inode_map) {
+		kh_destroy(wd_to_inode, staged->inode_map);
+		staged->inode_map = NULL;
+	}
+}
+
+void
+xal_be_fiemap_inotify_relocate(struct xal_inotify *inotify, struct xal *xal,
+			       const xal_idx_t *inodes_map)
+{
+	khash_t(wd_to_inode) *inode_map = inotify->inode_map;
+
+	for (khiter_t iter = kh_begin(inode_map); iter != kh_end(inode_map); ++iter) {
+		if (kh_exist(inode_map, iter)) {
+			xal_idx_t idx = inodes_map[xal_inode_idx(xal, kh_value(inode_map, iter))];
+
+			kh_value(inode_map, iter) = xal_inode_at(xal, idx);
+		}
+	}
+}
+
 int
 xal_be_fiemap_inotify_add_watcher(struct xal_inotify *inotify, char *path, struct xal_inode *inode)
 {
@@ -179,14 +249,13 @@ check_events(struct xal *xal, struct xal_inotify *inotify)
 	struct xal_inode *dir_inode, *inode;
 	kh_wd_to_inode_t *inode_map;
 	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
-	char path[XAL_PATH_MAXLEN];
+	char path[PATH_MAX];
 	khiter_t iter;
 	ssize_t len, i;
 	struct stat st;
+	int cancelstate;
 	int err;
 
-	inode_map = inotify->inode_map;
-
 	len = read(inotify->fd, buf, sizeof buf);
 	while (len > 0) {
 		int wd;
@@ -202,7 +271,8 @@ check_events(struct xal *xal, struct xal_inotify *inotify)
 			XAL_DEBUG_FCALL(inotify_event_mask_pp, event->mask, mask_pp, 128);
 			XAL_DEBUG("INFO: mask(%s) for event with wd(%d) and name(%s)", &mask_pp[1], wd, event->name)
 
-			if (inotify->watch_mode == XAL_WATCHMODE_DIRTY_DETECTION) {
+			if (inotify->watch_mode == XAL_WATCHMODE_DIRTY_DETECTION ||
+			    atomic_load(&xal->sealed)) {
 				XAL_DEBUG("INFO: File system has changed;");
 				return 1;
 			}
@@ -213,37 +283,63 @@ check_events(struct xal *xal, struct xal_inotify *inotify)
 			}
 
 			if (event->mask & (IN_MODIFY | IN_CLOSE_WRITE)) {
+				/**
+				 * The map, and the inodes it points to, are replaced when xal_index()
+				 * publishes, thus, they are looked up under the lock held while publishing.
+				 * The update is not cancelled midway, which would leave the lock held.
+				 */
+				pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancelstate);
+				pthread_mutex_lock(&inotify->lock);
+
+				/**
+				 * xal_seal() holds the lock while sealing, thus, once it is taken, the
+				 * pools are either writable or sealed
+				 */
+				if (atomic_load(&xal->sealed)) {
+					pthread_mutex_unlock(&inotify->lock);
+					pthread_setcancelstate(cancelstate, NULL);
+					XAL_DEBUG("INFO: File system has changed; the index is sealed");
+					return 1;
+				}
+
+				xal_write_begin(xal);
+
+				inode_map = inotify->inode_map;
+
 				iter = kh_get(wd_to_inode, inode_map, wd);
 				if (iter == kh_end(inode_map)) {
 					XAL_DEBUG("FAILED: kh_get(%d) for event with name(%s)", wd, event->name);
-					return -EINVAL;
+					err = -EINVAL;
+					goto failed_with_lock;
 				}
 
 				XAL_DEBUG("INFO: found watch descriptor(%d) for event with name(%s)", wd, event->name);
 
 				dir_inode = kh_val(inode_map, iter);
 				if (!xal_inode_is_dir(dir_inode)) {
-					XAL_DEBUG("FAILED: found inode(%s) is not a directory", dir_inode->name);
-					return -EINVAL;
+					XAL_DEBUG("FAILED: found inode(%s) is not a directory",
+						  xal_inode_name(xal, dir_inode));
+					err = -EINVAL;
+					goto failed_with_lock;
 				}
 
 				if (dir_inode->namelen + 1 + strlen(event->name) + 1 > sizeof(path)) {
 					XAL_DEBUG("FAILED: event(%s) full path too long(%zu)",
 							event->name, dir_inode->namelen + 1 + strlen(event->name) + 1);
-					return -EINVAL;
+					err = -EINVAL;
+					goto failed_with_lock;
 				}
-				memcpy(path, dir_inode->name, dir_inode->namelen);
+				memcpy(path, xal_inode_name(xal, dir_inode), dir_inode->namelen);
 				path[dir_inode->namelen] = '/';
 				memcpy(path + dir_inode->namelen + 1, event->name, strlen(event->name));
 				path[dir_inode->namelen + 1 + strlen(event->name)] = '\0';
 
 				XAL_DEBUG("INFO: got full path of event: %s", path);
-				atomic_fetch_add(&xal->seq_lock, 1);
 
 				for (uint32_t j = 0; j < dir_inode->content.dentries.count; ++j) {
 					struct xal_inode *child = xal_inode_at(xal, dir_inode->content.dentries.inodes_idx + j);
 
-					if (strcmp(child->name, path) == 0) {
+					if (strcmp(xal_inode_name(xal, child), path) == 0) {
 						inode = child;
 						break;
 					}
@@ -276,7 +372,10 @@ check_events(struct xal *xal, struct xal_inotify *inotify)
 				XAL_DEBUG("INFO: finished reprocessing inode:");
 				XAL_DEBUG_FCALL(xal_inode_pp, xal, inode);
 
-				atomic_fetch_add(&xal->seq_lock, 1);
+				xal_manifest_publish(xal);
+				xal_write_end(xal);
+				pthread_mutex_unlock(&inotify->lock);
+				pthread_setcancelstate(cancelstate, NULL);
 
 			} else if (event->mask & (IN_CREATE | IN_DELETE | IN_MOVE)) {
 				XAL_DEBUG("INFO: File system has changed, event mask:%s", mask_pp);
@@ -292,7 +391,9 @@ check_events(struct xal *xal, struct xal_inotify *inotify)
 	return 0;
 
 failed_with_lock:
-	atomic_fetch_add(&xal->seq_lock, 1);
+	xal_write_end(xal);
+	pthread_mutex_unlock(&inotify->lock);
+	pthread_setcancelstate(cancelstate, NULL);
 
 	return err;
 }
@@ -1,22 +1,30 @@
+#define _GNU_SOURCE
 #include <asm-generic/errno.h>
 #include <libxnvme.h>
-#define _GNU_SOURCE
 #include <assert.h>
 #include <endian.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <khash.h>
 #include <libxal.h>
+#include <limits.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <xal.h>
+#include <xal_be_fiemap.h>
 #include <xal_be_xfs.h>
+#include <xal_crc32c.h>
 #include <xal_odf.h>
+#include <xal_queue.h>
 
 struct pair_u64 {
 	uint64_t l0;
@@ -25,18 +33,44 @@ struct pair_u64 {
 
 KHASH_MAP_INIT_INT64(ino_to_dinode, struct xal_odf_dinode *);
 
+#define PIPELINE_QDEPTH_DEFAULT 32
+
+/**
+ * An inode-chunk located via the inode allocation B+tree, to be read and decoded
+ */
+struct chunk_desc {
+	struct xal_odf_inobt_rec rec; ///< In host-endianess
+	uint64_t ofz;                 ///< Offset on disk, in bytes
+	uint64_t index;               ///< Index in 'be->dinodes' of the first allocated dinode
+	uint32_t ninodes;             ///< Number of allocated dinodes in the chunk
+};
+
+struct chunk_descs {
+	struct chunk_desc *descs;
+	size_t count;
+	size_t capacity;
+	uint64_t ninodes; ///< Sum of allocated dinodes over all chunks
+};
+
 static int
-decode_dentry(void *buf, struct xal_inode *dentry);
+decode_dentry(void *buf, struct xal_inode *dentry, const char **name);
 
 static int
-retrieve_dinodes_via_iab3(struct xal *xal, struct xal_ag *ag, uint64_t blkno, uint64_t *index);
+retrieve_dinodes_via_iab3(struct xal *xal, struct xal_ag *ag, uint64_t blkno,
+			  struct chunk_descs *chunks);
 
 static int
 process_ino(struct xal *xal, uint64_t ino, struct xal_inode *self);
 
+static int
+process_dinode_dir_extents_dblock(struct xal *xal, uint64_t fsbno, struct xal_inode *self);
+
 int
 xal_be_xfs_index(struct xal *xal);
 
+static void
+step_term(struct xal *xal, struct xal_be_xfs_step *step);
+
 static int
 dev_read(struct xnvme_dev *dev, void *buf, size_t count, uint64_t offset)
 {
@@ -86,6 +120,216 @@ dev_read_into(struct xnvme_dev *dev, void *iobuf, size_t count, off_t offset, vo
 	return 0;
 }
 
+/**
+ * Verify the CRC32C of the given metadata buffer, when enabled, and account for the result
+ *
+ * This is invoked on the buffer as it is read from disk, before endianess conversion, thus the
+ * data is cache-hot when subsequently decoded. A mismatch is counted, not treated as an error.
+ *
+ * @param type The type of metadata block, used for accounting
+ * @param buf Buffer in on-disk-format
+ * @param nbytes Number of bytes covered by the checksum
+ * @param cksum_ofz Offset of the checksum field within 'buf'
+ */
+static void
+verify_crc(struct xal *xal, enum xal_crc_blk type, const void *buf, size_t nbytes,
+	   size_t cksum_ofz)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+
+	if (!be->verify_crc) {
+		return;
+	}
+
+	// Inode-chunks are verified by the decoder threads of the pipeline, thus atomic updates
+	__atomic_fetch_add(&be->crc_stats.nchecked[type], 1, __ATOMIC_RELAXED);
+
+	if (!xal_crc32c_verify(buf, nbytes, cksum_ofz)) {
+		XAL_DEBUG("FAILED: crc mismatch; type(%d), nbytes(%zu)", type, nbytes);
+		__atomic_fetch_add(&be->crc_stats.nmismatch[type], 1, __ATOMIC_RELAXED);
+	}
+}
+
+/**
+ * Decode an inode-chunk, as described by 'rec', copying allocated dinodes into 'be->dinodes'
+ *
+ * The dinodes are copied to consecutive positions starting at '*index'; they are not entered into
+ * 'be->dinodes_map', see dinodes_link(). Thus, chunks with disjoint positions can be decoded
+ * concurrently.
+ *
+ * This is the body of a "template"; 'inodesize' is a compile-time constant in the instances
+ * generated by XAL_BE_XFS_DECODERS_DEFINE() and the runtime value in the generic instance.
+ */
+static inline __attribute__((always_inline)) int
+decode_inode_chunk_tmpl(struct xal *xal, struct xal_odf_inobt_rec *rec, const uint8_t *chunk,
+			uint64_t *index, const size_t inodesize)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+
+	/**
+	 * Traverse the inodes in the chunk, skipping unused and free inodes.
+	 */
+	for (uint8_t chunk_index = 0; chunk_index < rec->count; ++chunk_index) {
+		const uint8_t *chunk_cursor = &chunk[chunk_index * inodesize];
+		uint64_t is_unused = (rec->holemask & (1ULL << chunk_index)) >> chunk_index;
+		uint64_t is_free = (rec->free & (1ULL << chunk_index)) >> chunk_index;
+
+		if (is_unused || is_free) {
+			continue;
+		}
+
+		verify_crc(xal, XAL_CRC_BLK_DINODE, chunk_cursor, inodesize,
+			   offsetof(struct xal_odf_dinode, di_crc));
+
+		memcpy(&be->dinodes[*index * inodesize], chunk_cursor, inodesize);
+
+		*index += 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Decode the directory entries of a directory data block into inodes, children of 'self'
+ *
+ * This is the body of a "template"; 'dirblocksize' is a compile-time constant in the instances
+ * generated by XAL_BE_XFS_DECODERS_DEFINE() and the runtime value in the generic instance.
+ */
+static inline __attribute__((always_inline)) int
+decode_dblock_tmpl(struct xal *xal, uint8_t *dblock, struct xal_inode *self,
+		   const size_t dirblocksize)
+{
+	int err;
+
+	for (uint64_t ofz = 64; ofz < dirblocksize;) {
+		uint8_t *dentry_cursor = dblock + ofz;
+		struct xal_inode dentry = {0};
+		const char *name = NULL;
+		xal_idx_t slot;
+
+		ofz += decode_dentry(dentry_cursor, &dentry, &name);
+
+		/**
+		 * Seems like the only way to determine that there are no more
+		 * entries are if one start to decode uinvalid entries.
+		 * Such as a namelength of 0 or inode number 0.
+		 * Thus, checking for that here.
+		 */
+		if ((!dentry.ino) || (!dentry.namelen)) {
+			break;
+		}
+
+		/**
+		 * Skip processing the mandatory dentries: '.' and '..'
+		 */
+		if ((dentry.namelen == 1) && (name[0] == '.')) {
+			continue;
+		}
+		if ((dentry.namelen == 2) && (name[0] == '.') && (name[1] == '.')) {
+			continue;
+		}
+
+		err = xal_inodes_claim(xal, 1, &slot);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_inodes_claim(...)");
+			return err;
+		}
+
+		dentry.parent_idx = xal_inode_idx(xal, self);
+		*xal_inode_at(xal, slot) = dentry;
+		self->content.dentries.count += 1;
+
+		err = xal_inode_name_set(xal, xal_inode_at(xal, slot), name, dentry.namelen);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_inode_name_set(); err(%d)", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+struct xal_be_xfs_decoders {
+	const char *name;
+	uint32_t blocksize;    ///< Geometry handled by the decoders; 0 for any
+	uint16_t inodesize;    ///< Geometry handled by the decoders; 0 for any
+	uint32_t dirblocksize; ///< Geometry handled by the decoders; 0 for any
+
+	int (*decode_inode_chunk)(struct xal *xal, struct xal_odf_inobt_rec *rec,
+				  const uint8_t *chunk, uint64_t *index);
+	int (*decode_dblock)(struct xal *xal, uint8_t *dblock, struct xal_inode *self);
+};
+
+/**
+ * Instantiate the decoders for a fixed geometry
+ *
+ * The geometry arguments are compile-time constants, thus strides, copy-sizes and loop-bounds
+ * are folded into the generated code rather than loaded from 'xal->sb'.
+ */
+#define XAL_BE_XFS_DECODERS_DEFINE(SUFFIX, BLOCKSIZE, INODESIZE, DIRBLOCKSIZE)                   \
+	static int decode_inode_chunk_##SUFFIX(struct xal *xal, struct xal_odf_inobt_rec *rec,   \
+					       const uint8_t *chunk, uint64_t *index)            \
+	{                                                                                          \
+		return decode_inode_chunk_tmpl(xal, rec, chunk, index, INODESIZE);                 \
+	}                                                                                          \
+	static int decode_dblock_##SUFFIX(struct xal *xal, uint8_t *dblock,                       \
+					  struct xal_inode *self)                                 \
+	{                                                                                          \
+		return decode_dblock_tmpl(xal, dblock, self, DIRBLOCKSIZE);                        \
+	}                                                                                          \
+	static const struct xal_be_xfs_decoders decoders_##SUFFIX = {                             \
+	    .name = #SUFFIX,                                                                       \
+	    .blocksize = BLOCKSIZE,                                                                \
+	    .inodesize = INODESIZE,                                                                \
+	    .dirblocksize = DIRBLOCKSIZE,                                                          \
+	    .decode_inode_chunk = decode_inode_chunk_##SUFFIX,                                     \
+	    .decode_dblock = decode_dblock_##SUFFIX,                                               \
+	};
+
+static int
+decode_inode_chunk_generic(struct xal *xal, struct xal_odf_inobt_rec *rec, const uint8_t *chunk,
+			   uint64_t *index)
+{
+	return decode_inode_chunk_tmpl(xal, rec, chunk, index, xal->sb.inodesize);
+}
+
+static int
+decode_dblock_generic(struct xal *xal, uint8_t *dblock, struct xal_inode *self)
+{
+	return decode_dblock_tmpl(xal, dblock, self, xal->sb.dirblocksize);
+}
+
+static const struct xal_be_xfs_decoders decoders_generic = {
+    .name = "generic",
+    .decode_inode_chunk = decode_inode_chunk_generic,
+    .decode_dblock = decode_dblock_generic,
+};
+
+/// The mkfs.xfs defaults: 4K blocks, 512 byte inodes, and directory blocks of a single fs-block
+XAL_BE_XFS_DECODERS_DEFINE(b4k_i512_d4k, 4096, 512, 4096)
+
+static const struct xal_be_xfs_decoders *decoders_specialised[] = {
+    &decoders_b4k_i512_d4k,
+};
+
+/**
+ * Select the specialised decoders matching the geometry in 'sb'; falling back to the generic
+ */
+static const struct xal_be_xfs_decoders *
+decoders_select(const struct xal_sb *sb)
+{
+	for (size_t i = 0; i < sizeof(decoders_specialised) / sizeof(*decoders_specialised); ++i) {
+		const struct xal_be_xfs_decoders *cand = decoders_specialised[i];
+
+		if ((cand->blocksize == sb->blocksize) && (cand->inodesize == sb->inodesize) &&
+		    (cand->dirblocksize == sb->dirblocksize)) {
+			return cand;
+		}
+	}
+
+	return &decoders_generic;
+}
+
 static __attribute__((unused)) uint32_t
 ino_abs_to_rel(struct xal *xal, uint64_t inoabs)
 {
@@ -145,8 +389,10 @@ xal_ino_decode_absolute(struct xal *xal, uint64_t ino, uint32_t *seqno, uint64_t
 static uint64_t
 xal_agbno_absolute_offset(struct xal *xal, uint32_t seqno, uint64_t agbno)
 {
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+
 	// Absolute Inode offset in bytes
-	return (seqno * (uint64_t)xal->sb.agblocks + agbno) * xal->sb.blocksize;
+	return (seqno * (uint64_t)xal->sb.agblocks + agbno) << be->geo.blocklog;
 }
 
 /**
@@ -171,6 +417,73 @@ xal_ino_decode_absolute_offset(struct xal *xal, uint64_t ino)
 	return offset + ((uint64_t)agbino * xal->sb.inodesize);
 }
 
+/**
+ * Settle the mounted file system, if any, before its on-disk format is parsed
+ *
+ * With XAL_QUIESCE_FREEZE the file system stays frozen until quiesce_end(); calling this while
+ * frozen is a no-op.
+ */
+static int
+quiesce_begin(struct xal *xal)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	int fd, err;
+
+	if ((!be->mountpoint) || (be->quiesce == XAL_QUIESCE_NONE) || (be->freeze_fd >= 0)) {
+		return 0;
+	}
+
+	fd = open(be->mountpoint, O_RDONLY | O_DIRECTORY);
+	if (fd < 0) {
+		XAL_DEBUG("FAILED: open(%s); errno(%d)", be->mountpoint, errno);
+		return -errno;
+	}
+
+	switch (be->quiesce) {
+	case XAL_QUIESCE_SYNCFS:
+		err = syncfs(fd) ? -errno : 0;
+		close(fd);
+		if (err) {
+			XAL_DEBUG("FAILED: syncfs(%s); err(%d)", be->mountpoint, err);
+		}
+		return err;
+
+	case XAL_QUIESCE_FREEZE:
+		if (ioctl(fd, FIFREEZE, 0)) {
+			err = -errno;
+			XAL_DEBUG("FAILED: ioctl(FIFREEZE, %s); err(%d)", be->mountpoint, err);
+			close(fd);
+			return err;
+		}
+		be->freeze_fd = fd;
+		return 0;
+
+	default:
+		close(fd);
+		XAL_DEBUG("FAILED: unknown quiesce(%d)", be->quiesce);
+		return -EINVAL;
+	}
+}
+
+/**
+ * Thaw the file system if it was frozen by quiesce_begin()
+ */
+static void
+quiesce_end(struct xal *xal)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+
+	if (be->freeze_fd < 0) {
+		return;
+	}
+
+	if (ioctl(be->freeze_fd, FITHAW, 0)) {
+		XAL_DEBUG("FAILED: ioctl(FITHAW, %s); errno(%d)", be->mountpoint, errno);
+	}
+	close(be->freeze_fd);
+	be->freeze_fd = -1;
+}
+
 void
 xal_be_xfs_close(struct xal *xal)
 {
@@ -182,6 +495,14 @@ xal_be_xfs_close(struct xal *xal)
 
 	be = (struct xal_be_xfs *)xal->be;
 
+	if (be->step) {
+		step_term(xal, be->step);
+		be->step = NULL;
+	}
+
+	quiesce_end(xal);
+	free(be->mountpoint);
+
 	xnvme_buf_free(xal->dev, be->buf);
 	kh_destroy(ino_to_dinode, be->dinodes_map);
 	free(be->dinodes);
@@ -279,6 +600,9 @@ read_iab3_block(struct xal *xal, struct xal_ag *ag, uint64_t blkno, void *buf)
 		return err;
 	}
 
+	verify_crc(xal, XAL_CRC_BLK_IAB3, buf, xal->sb.blocksize,
+		   offsetof(struct xal_odf_btree_sfmt, bb_crc));
+
 	if (XAL_ODF_IBT_CRC_MAGIC != be32toh(block->magic.num)) {
 		XAL_DEBUG("FAILED: expected magic(IAB3) got magic('%.4s', 0x%" PRIx32 "); ",
 			  block->magic.text, block->magic.num);
@@ -307,18 +631,38 @@ read_iab3_block(struct xal *xal, struct xal_ag *ag, uint64_t blkno, void *buf)
 	return 0;
 }
 
+/**
+ * Count the allocated inodes in the chunk described by 'rec'; as skipped by the chunk decoders
+ */
+static uint32_t
+chunk_ninodes(const struct xal_odf_inobt_rec *rec)
+{
+	uint32_t ninodes = 0;
+
+	for (uint8_t chunk_index = 0; chunk_index < rec->count; ++chunk_index) {
+		uint64_t is_unused = (rec->holemask & (1ULL << chunk_index)) >> chunk_index;
+		uint64_t is_free = (rec->free & (1ULL << chunk_index)) >> chunk_index;
+
+		ninodes += !(is_unused || is_free);
+	}
+
+	return ninodes;
+}
+
+/**
+ * Decode the leaf records, appending a descriptor of each inode-chunk to 'chunks'
+ */
 static int
-decode_iab3_leaf_records(struct xal *xal, struct xal_ag *ag, void *buf, uint64_t *index)
+decode_iab3_leaf_records(struct xal *xal, struct xal_ag *ag, void *buf, struct chunk_descs *chunks)
 {
 	struct xal_odf_btree_sfmt *root = (void *)buf;
 	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
-	int err = 0;
 
 	XAL_DEBUG("ENTER");
 
 	for (uint16_t reci = 0; reci < root->pos.numrecs; ++reci) {
-		uint8_t inodechunk[BUF_NBYTES] = {0};
 		struct xal_odf_inobt_rec *rec;
+		struct chunk_desc *desc;
 		uint32_t agbino;
 		uint64_t agbno;
 
@@ -343,53 +687,26 @@ decode_iab3_leaf_records(struct xal *xal, struct xal_ag *ag, void *buf, uint64_t
 		 */
 		assert(agbino == 0);
 
-		/**
-		 * Populate the inode-buffer with data from all the blocks
-		 */
-		{
-			uint64_t chunk_nbytes =
-			    (CHUNK_NINO / xal->sb.inopblock) * xal->sb.blocksize;
-			uint64_t chunk_offset = agbno * xal->sb.blocksize + ag->offset;
-
-			assert(chunk_nbytes < BUF_NBYTES);
+		if (chunks->count == chunks->capacity) {
+			size_t capacity = chunks->capacity ? chunks->capacity * 2 : 1024;
+			struct chunk_desc *descs;
 
-			memset(be->buf, 0, chunk_nbytes);
-
-			err = dev_read(xal->dev, be->buf, chunk_nbytes, chunk_offset);
-			if (err) {
-				XAL_DEBUG("FAILED: dev_read(chunk)");
-				return err;
+			descs = realloc(chunks->descs, capacity * sizeof(*descs));
+			if (!descs) {
+				XAL_DEBUG("FAILED: realloc(); errno(%d)", errno);
+				return -errno;
 			}
-			memcpy(inodechunk, be->buf, chunk_nbytes);
+			chunks->descs = descs;
+			chunks->capacity = capacity;
 		}
 
-		/**
-		 * Traverse the inodes in the chunk, skipping unused and free inodes.
-		 */
-		for (uint8_t chunk_index = 0; chunk_index < rec->count; ++chunk_index) {
-			uint8_t *chunk_cursor = &inodechunk[chunk_index * xal->sb.inodesize];
-			uint64_t is_unused = (rec->holemask & (1ULL << chunk_index)) >> chunk_index;
-			uint64_t is_free = (rec->free & (1ULL << chunk_index)) >> chunk_index;
-			khash_t(ino_to_dinode) *dinodes_map = be->dinodes_map;
-			struct xal_odf_dinode *dinode;
-			khiter_t iter;
-
-			if (is_unused || is_free) {
-				continue;
-			}
-
-			dinode = (void *)&be->dinodes[*index * xal->sb.inodesize];
-			memcpy(dinode, (void *)chunk_cursor, xal->sb.inodesize);
-
-			iter = kh_put(ino_to_dinode, dinodes_map, be64toh(dinode->ino), &err);
-			if (err < 0) {
-				XAL_DEBUG("FAILED: kh_put()");
-				return -EIO;
-			}
-			kh_value(dinodes_map, iter) = dinode;
+		desc = &chunks->descs[chunks->count++];
+		desc->rec = *rec;
+		desc->ofz = (agbno << be->geo.blocklog) + ag->offset;
+		desc->index = chunks->ninodes;
+		desc->ninodes = chunk_ninodes(rec);
 
-			*index += 1;
-		}
+		chunks->ninodes += desc->ninodes;
 	}
 
 	XAL_DEBUG("EXIT");
@@ -401,7 +718,7 @@ decode_iab3_leaf_records(struct xal *xal, struct xal_ag *ag, void *buf, uint64_t
  * Decodes the node and invokes retrieve_dinodes_via_iab3() for each decoded record.
  */
 static int
-decode_iab3_node_records(struct xal *xal, struct xal_ag *ag, void *buf, uint64_t *index)
+decode_iab3_node_records(struct xal *xal, struct xal_ag *ag, void *buf, struct chunk_descs *chunks)
 {
 	uint32_t pointers[ODF_BLOCK_FS_BYTES_MAX / sizeof(uint32_t)] = {0};
 	struct xal_odf_btree_sfmt *node = (void *)buf;
@@ -420,7 +737,7 @@ decode_iab3_node_records(struct xal *xal, struct xal_ag *ag, void *buf, uint64_t
 		uint32_t blkno = be32toh(pointers[rec]);
 
 		XAL_DEBUG("INFO: ptr[%" PRIu16 "] = 0x%" PRIx32, rec, blkno);
-		err = retrieve_dinodes_via_iab3(xal, ag, blkno, index);
+		err = retrieve_dinodes_via_iab3(xal, ag, blkno, chunks);
 		if (err) {
 			XAL_DEBUG("FAILED: retrieve_dinodes_via_iab3() : err(%d)", err);
 			return err;
@@ -438,7 +755,8 @@ decode_iab3_node_records(struct xal *xal, struct xal_ag *ag, void *buf, uint64_t
  * It is assumed that the inode-allocation-b+tree is rooted at the given 'blkno'
  */
 static int
-retrieve_dinodes_via_iab3(struct xal *xal, struct xal_ag *ag, uint64_t blkno, uint64_t *index)
+retrieve_dinodes_via_iab3(struct xal *xal, struct xal_ag *ag, uint64_t blkno,
+			  struct chunk_descs *chunks)
 {
 	uint8_t block[ODF_BLOCK_FS_BYTES_MAX] = {0};
 	struct xal_odf_btree_sfmt *node = (void *)block;
@@ -455,7 +773,7 @@ retrieve_dinodes_via_iab3(struct xal *xal, struct xal_ag *ag, uint64_t blkno, ui
 
 	switch (node->pos.level) {
 	case 1:
-		err = decode_iab3_node_records(xal, ag, block, index);
+		err = decode_iab3_node_records(xal, ag, block, chunks);
 		if (err) {
 			XAL_DEBUG("FAILED: decode_iab3_node(); err(%d)", err);
 			return err;
@@ -463,7 +781,7 @@ retrieve_dinodes_via_iab3(struct xal *xal, struct xal_ag *ag, uint64_t blkno, ui
 		break;
 
 	case 0:
-		err = decode_iab3_leaf_records(xal, ag, block, index);
+		err = decode_iab3_leaf_records(xal, ag, block, chunks);
 		if (err) {
 			XAL_DEBUG("FAILED: decode_iab3_leaf(); err(%d)", err);
 			return err;
@@ -480,85 +798,505 @@ retrieve_dinodes_via_iab3(struct xal *xal, struct xal_ag *ag, uint64_t blkno, ui
 	return 0;
 }
 
-int
-xal_dinodes_retrieve(struct xal *xal)
+/**
+ * Enter the dinodes at positions [begin, end) of 'be->dinodes' into 'be->dinodes_map'
+ */
+static int
+dinodes_link(struct xal *xal, uint64_t begin, uint64_t end)
 {
 	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
-	uint64_t index = 0;
-
-	if (be->base.type != XAL_BACKEND_XFS) {
-		XAL_DEBUG("SKIPPED: Backend is not XFS");
-		return 0;
-	}
-
-	XAL_DEBUG("ENTER");
-
-	be->dinodes_map = kh_init(ino_to_dinode);
-	if (!be->dinodes_map) {
-		XAL_DEBUG("FAILED: kh_init()");
-		return -EINVAL;
-	}
-
-	be->dinodes = calloc(1, xal->sb.nallocated * xal->sb.inodesize);
-	if (!be->dinodes) {
-		XAL_DEBUG("FAILED: calloc()");
-		return -errno;
-	}
+	khash_t(ino_to_dinode) *dinodes_map = be->dinodes_map;
 
-	for (uint32_t seqno = 0; seqno < xal->sb.agcount; ++seqno) {
-		struct xal_ag *ag = &be->ags[seqno];
+	for (uint64_t index = begin; index < end; ++index) {
+		struct xal_odf_dinode *dinode = (void *)&be->dinodes[index << be->geo.inodelog];
+		khiter_t iter;
 		int err;
 
-		XAL_DEBUG("INFO: seqno: %" PRIu32 "", seqno);
-
-		err = retrieve_dinodes_via_iab3(xal, ag, ag->agi_root, &index);
-		if (err) {
-			XAL_DEBUG("FAILED: retrieve_dinodes_via_iab3(); err(%d)", err);
-			free(be->dinodes);
-			be->dinodes = NULL;
-			return err;
+		iter = kh_put(ino_to_dinode, dinodes_map, be64toh(dinode->ino), &err);
+		if (err < 0) {
+			XAL_DEBUG("FAILED: kh_put()");
+			return -EIO;
 		}
+		kh_value(dinodes_map, iter) = dinode;
 	}
 
-	XAL_DEBUG("EXIT");
-
 	return 0;
 }
 
 /**
- * Decodes the XFS Extent information in l0 and l1 into the given 'extent' structure
- *
- * @param l0 First 64bits; little-endian
- * @param l1 Last 64bits; little-endian
+ * Decode the inode-chunk described by 'desc' from 'buf' and enter its dinodes into the map
  */
-static void
-decode_xfs_extent(uint64_t l0, uint64_t l1, struct xal_extent *extent)
+static int
+chunk_decode(struct xal *xal, struct chunk_desc *desc, const uint8_t *buf)
 {
-	// Extract start offset (l0:9-62)
-	extent->start_offset = (l0 << 1) >> 10;
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	uint64_t index = desc->index;
+	int err;
 
-	// Extract start block (l0:0-8 and l1:21-63)
-	extent->start_block = ((l0 & 0x1FF) << 43) | (l1 >> 21);
+	err = be->decoders->decode_inode_chunk(xal, &desc->rec, buf, &index);
+	if (err) {
+		XAL_DEBUG("FAILED: decode_inode_chunk(); err(%d)", err);
+		return err;
+	}
 
-	// Extract block count (l1:0-20)
-	extent->nblocks = l1 & 0x1FFFFF;
+	err = dinodes_link(xal, desc->index, index);
+	if (err) {
+		XAL_DEBUG("FAILED: dinodes_link(); err(%d)", err);
+		return err;
+	}
 
-	extent->flag = l1 >> 63;
+	return 0;
 }
 
 /**
- * Find the dinode with inode number 'ino'
+ * Submit an asynchronous read of the inode-chunk described by 'desc' into 'buf'
  *
- * @return On success, 0 is returned. On error, -errno is returned to indicate the error.
+ * Returns -EBUSY or -EAGAIN when the queue is full; the caller is to reap completions and retry.
  */
 static int
-dinodes_get(struct xal *xal, uint64_t ino, void **dinode)
+chunk_read_submit(struct xal *xal, struct xnvme_queue *queue, struct chunk_desc *desc, void *buf,
+		  xnvme_queue_cb cb, void *cb_arg)
 {
 	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
-	kh_ino_to_dinode_t *dinode_map = be->dinodes_map;
-	khiter_t iter;
+	const struct xnvme_geo *geo = xnvme_dev_get_geo(xal->dev);
+	const uint64_t chunk_nbytes = (uint64_t)CHUNK_NINO << be->geo.inodelog;
+	struct xnvme_cmd_ctx *ctx;
+	int err;
 
-	iter = kh_get(ino_to_dinode, dinode_map, ino);
+	ctx = xnvme_queue_get_cmd_ctx(queue);
+	if (!ctx) {
+		return -EBUSY;
+	}
+	ctx->async.cb = cb;
+	ctx->async.cb_arg = cb_arg;
+
+	err = xnvme_nvm_read(ctx, xnvme_dev_get_nsid(xal->dev), desc->ofz / geo->lba_nbytes,
+			     (chunk_nbytes / geo->lba_nbytes) - 1, buf, NULL);
+	if (err) {
+		xnvme_queue_put_cmd_ctx(queue, ctx);
+	}
+
+	return err;
+}
+
+/**
+ * Read and decode the inode-chunks one at a time using the io-buffer
+ */
+static int
+dinodes_decode_inline(struct xal *xal, struct chunk_descs *chunks)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	const uint64_t chunk_nbytes = (uint64_t)CHUNK_NINO << be->geo.inodelog;
+
+	for (size_t i = 0; i < chunks->count; ++i) {
+		int err;
+
+		err = dev_read(xal->dev, be->buf, chunk_nbytes, chunks->descs[i].ofz);
+		if (err) {
+			XAL_DEBUG("FAILED: dev_read(chunk)");
+			return err;
+		}
+
+		err = chunk_decode(xal, &chunks->descs[i], be->buf);
+		if (err) {
+			XAL_DEBUG("FAILED: chunk_decode(); err(%d)", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+struct pipeline;
+
+/**
+ * An io-buffer circulating through the stages of the pipeline
+ */
+struct pipeline_slot {
+	struct pipeline *pipeline;
+	struct chunk_desc *desc; ///< The chunk read into 'buf'
+	void *buf;               ///< io-buffer of 'chunk_nbytes' allocated via xnvme_buf_alloc()
+	int err;                 ///< Completion status of the read
+};
+
+/**
+ * Pipeline for reading and decoding inode-chunks
+ *
+ * The stages are connected by bounded queues:
+ *
+ *   reader --[completed]--> decoders --[decoded]--> linker
+ *      ^                        |
+ *      +---------[free]---------+
+ *
+ * The reader, running in the calling thread, submits reads asynchronously and reaps their
+ * completions. The decoders copy the dinodes into 'be->dinodes' at the positions pre-assigned to
+ * the chunk, thus they can run concurrently. The linker enters the decoded dinodes into
+ * 'be->dinodes_map', as the hash-map is not thread-safe.
+ */
+struct pipeline {
+	struct xal *xal;
+	struct xal_queue free;      ///< Slots available for submission
+	struct xal_queue completed; ///< Slots with a completed read; NULL stops a decoder
+	struct xal_queue decoded;   ///< Chunks with decoded dinodes; NULL stops the linker
+	struct pipeline_slot *slots;
+	uint32_t nslots;
+	atomic_int err; ///< The first error encountered by any stage
+};
+
+static void
+pipeline_fail(struct pipeline *pipeline, int err)
+{
+	int expected = 0;
+
+	atomic_compare_exchange_strong(&pipeline->err, &expected, err);
+}
+
+static void
+pipeline_read_cb(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct pipeline_slot *slot = cb_arg;
+
+	slot->err = xnvme_cmd_ctx_cpl_status(ctx) ? -EIO : 0;
+
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+	xal_queue_push(&slot->pipeline->completed, slot);
+}
+
+static void *
+pipeline_decoder(void *arg)
+{
+	struct pipeline *pipeline = arg;
+	struct xal *xal = pipeline->xal;
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	struct pipeline_slot *slot;
+
+	while ((slot = xal_queue_pop(&pipeline->completed))) {
+		uint64_t index = slot->desc->index;
+		int err = slot->err;
+
+		if (!err && !atomic_load(&pipeline->err)) {
+			err = be->decoders->decode_inode_chunk(xal, &slot->desc->rec, slot->buf,
+							       &index);
+			if (!err) {
+				xal_queue_push(&pipeline->decoded, slot->desc);
+			}
+		}
+		if (err) {
+			XAL_DEBUG("FAILED: read or decode of chunk; err(%d)", err);
+			pipeline_fail(pipeline, err);
+		}
+
+		xal_queue_push(&pipeline->free, slot);
+	}
+
+	return NULL;
+}
+
+static void *
+pipeline_linker(void *arg)
+{
+	struct pipeline *pipeline = arg;
+	struct chunk_desc *desc;
+
+	while ((desc = xal_queue_pop(&pipeline->decoded))) {
+		int err;
+
+		if (atomic_load(&pipeline->err)) {
+			continue;
+		}
+
+		err = dinodes_link(pipeline->xal, desc->index, desc->index + desc->ninodes);
+		if (err) {
+			XAL_DEBUG("FAILED: dinodes_link(); err(%d)", err);
+			pipeline_fail(pipeline, err);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Submit the read of every chunk, reaping completions whenever no slot is available
+ *
+ * There are more slots than the queue has entries, the spare slots are those held by decoders;
+ * thus, a read is only submitted while fewer than 'qdepth' reads are outstanding.
+ */
+static int
+pipeline_read(struct pipeline *pipeline, struct xnvme_queue *queue, uint32_t qdepth,
+	      struct chunk_descs *chunks)
+{
+	struct xal *xal = pipeline->xal;
+
+	for (size_t i = 0; (i < chunks->count) && !atomic_load(&pipeline->err);) {
+		struct pipeline_slot *slot;
+		int err;
+
+		if (xnvme_queue_get_outstanding(queue) >= qdepth) {
+			err = xnvme_queue_poke(queue, 0);
+			if (err < 0) {
+				XAL_DEBUG("FAILED: xnvme_queue_poke(); err(%d)", err);
+				return err;
+			}
+			continue;
+		}
+
+		slot = xal_queue_trypop(&pipeline->free);
+		if (!slot) {
+			if (xnvme_queue_get_outstanding(queue)) {
+				err = xnvme_queue_poke(queue, 0);
+				if (err < 0) {
+					XAL_DEBUG("FAILED: xnvme_queue_poke(); err(%d)", err);
+					return err;
+				}
+				continue;
+			}
+			slot = xal_queue_pop(&pipeline->free);
+		}
+
+		slot->desc = &chunks->descs[i];
+		slot->err = 0;
+
+		while (((err = chunk_read_submit(xal, queue, slot->desc, slot->buf, pipeline_read_cb,
+						 slot)) == -EBUSY) ||
+		       (err == -EAGAIN)) {
+			xnvme_queue_poke(queue, 0);
+		}
+		if (err) {
+			XAL_DEBUG("FAILED: chunk_read_submit(); err(%d)", err);
+			xal_queue_push(&pipeline->free, slot);
+			return err;
+		}
+
+		i += 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Read and decode the inode-chunks via the pipeline described by 'struct pipeline'
+ */
+static int
+dinodes_decode_pipelined(struct xal *xal, struct chunk_descs *chunks)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	const uint64_t chunk_nbytes = (uint64_t)CHUNK_NINO << be->geo.inodelog;
+	const uint32_t qdepth = be->qdepth ? be->qdepth : PIPELINE_QDEPTH_DEFAULT;
+	struct pipeline pipeline = {.xal = xal};
+	pthread_t decoders[XAL_NTHREADS_MAX];
+	uint32_t ndecoders = 0;
+	struct xnvme_queue *queue;
+	pthread_t linker;
+	bool linking = false;
+	int err;
+
+	err = xnvme_queue_init(xal->dev, qdepth, 0, &queue);
+	if (err) {
+		XAL_DEBUG("INFO: xnvme_queue_init(); err(%d); decoding inline", err);
+		return dinodes_decode_inline(xal, chunks);
+	}
+
+	pipeline.nslots = qdepth + be->nthreads;
+	pipeline.slots = calloc(pipeline.nslots, sizeof(*pipeline.slots));
+	if (!pipeline.slots) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		err = -errno;
+		goto exit;
+	}
+
+	if ((err = xal_queue_init(&pipeline.free, pipeline.nslots)) ||
+	    (err = xal_queue_init(&pipeline.completed, pipeline.nslots)) ||
+	    (err = xal_queue_init(&pipeline.decoded, pipeline.nslots))) {
+		XAL_DEBUG("FAILED: xal_queue_init(); err(%d)", err);
+		goto exit;
+	}
+
+	for (uint32_t i = 0; i < pipeline.nslots; ++i) {
+		struct pipeline_slot *slot = &pipeline.slots[i];
+
+		slot->pipeline = &pipeline;
+		slot->buf = xnvme_buf_alloc(xal->dev, chunk_nbytes);
+		if (!slot->buf) {
+			XAL_DEBUG("FAILED: xnvme_buf_alloc(); errno(%d)", errno);
+			err = -errno;
+			goto exit;
+		}
+		xal_queue_push(&pipeline.free, slot);
+	}
+
+	err = pthread_create(&linker, NULL, pipeline_linker, &pipeline);
+	if (err) {
+		XAL_DEBUG("FAILED: pthread_create(linker); err(%d)", err);
+		err = -err;
+		goto exit;
+	}
+	linking = true;
+
+	for (; ndecoders < be->nthreads; ++ndecoders) {
+		err = pthread_create(&decoders[ndecoders], NULL, pipeline_decoder, &pipeline);
+		if (err) {
+			XAL_DEBUG("FAILED: pthread_create(decoder); err(%d)", err);
+			err = -err;
+			goto exit;
+		}
+	}
+
+	err = pipeline_read(&pipeline, queue, qdepth, chunks);
+	if (err) {
+		pipeline_fail(&pipeline, err);
+	}
+
+exit:
+	xnvme_queue_drain(queue);
+
+	for (uint32_t i = 0; i < ndecoders; ++i) {
+		xal_queue_push(&pipeline.completed, NULL);
+	}
+	for (uint32_t i = 0; i < ndecoders; ++i) {
+		pthread_join(decoders[i], NULL);
+	}
+	if (linking) {
+		xal_queue_push(&pipeline.decoded, NULL);
+		pthread_join(linker, NULL);
+	}
+
+	if (!err) {
+		err = atomic_load(&pipeline.err);
+	}
+
+	xal_queue_term(&pipeline.decoded);
+	xal_queue_term(&pipeline.completed);
+	xal_queue_term(&pipeline.free);
+
+	for (uint32_t i = 0; pipeline.slots && (i < pipeline.nslots); ++i) {
+		xnvme_buf_free(xal->dev, pipeline.slots[i].buf);
+	}
+	free(pipeline.slots);
+
+	xnvme_queue_term(queue);
+
+	return err;
+}
+
+int
+xal_dinodes_retrieve(struct xal *xal)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	const uint64_t chunk_nbytes = (uint64_t)CHUNK_NINO << be->geo.inodelog;
+	struct chunk_descs chunks = {0};
+	int err;
+
+	if (be->base.type != XAL_BACKEND_XFS) {
+		XAL_DEBUG("SKIPPED: Backend is not XFS");
+		return 0;
+	}
+	if (be->step) {
+		XAL_DEBUG("FAILED: incremental indexing in progress");
+		return -EBUSY;
+	}
+
+	XAL_DEBUG("ENTER");
+
+	assert(chunk_nbytes < BUF_NBYTES);
+
+	err = quiesce_begin(xal);
+	if (err) {
+		XAL_DEBUG("FAILED: quiesce_begin(); err(%d)", err);
+		return err;
+	}
+
+	be->dinodes_map = kh_init(ino_to_dinode);
+	if (!be->dinodes_map) {
+		XAL_DEBUG("FAILED: kh_init()");
+		err = -EINVAL;
+		goto failed;
+	}
+
+	/**
+	 * Locate all inode-chunks via the inode allocation B+trees, then read and decode them
+	 */
+	for (uint32_t seqno = 0; seqno < xal->sb.agcount; ++seqno) {
+		struct xal_ag *ag = &be->ags[seqno];
+
+		XAL_DEBUG("INFO: seqno: %" PRIu32 "", seqno);
+
+		err = retrieve_dinodes_via_iab3(xal, ag, ag->agi_root, &chunks);
+		if (err) {
+			XAL_DEBUG("FAILED: retrieve_dinodes_via_iab3(); err(%d)", err);
+			goto failed;
+		}
+	}
+
+	if (chunks.ninodes > xal->sb.nallocated) {
+		XAL_DEBUG("FAILED: ninodes(%" PRIu64 ") > nallocated(%" PRIu64 ")", chunks.ninodes,
+			  xal->sb.nallocated);
+		err = -EINVAL;
+		goto failed;
+	}
+
+	be->dinodes = calloc(1, xal->sb.nallocated * xal->sb.inodesize);
+	if (!be->dinodes) {
+		XAL_DEBUG("FAILED: calloc()");
+		err = -errno;
+		goto failed;
+	}
+
+	err = be->nthreads ? dinodes_decode_pipelined(xal, &chunks)
+			   : dinodes_decode_inline(xal, &chunks);
+	if (err) {
+		XAL_DEBUG("FAILED: dinodes_decode(); err(%d)", err);
+		free(be->dinodes);
+		be->dinodes = NULL;
+		goto failed;
+	}
+
+	free(chunks.descs);
+
+	XAL_DEBUG("EXIT");
+
+	return 0;
+
+failed:
+	free(chunks.descs);
+	quiesce_end(xal);
+
+	return err;
+}
+
+/**
+ * Decodes the XFS Extent information in l0 and l1 into the given 'extent' structure
+ *
+ * @param l0 First 64bits; little-endian
+ * @param l1 Last 64bits; little-endian
+ */
+static void
+decode_xfs_extent(uint64_t l0, uint64_t l1, struct xal_extent *extent)
+{
+	// Extract start offset (l0:9-62)
+	extent->start_offset = (l0 << 1) >> 10;
+
+	// Extract start block (l0:0-8 and l1:21-63)
+	extent->start_block = ((l0 & 0x1FF) << 43) | (l1 >> 21);
+
+	// Extract block count (l1:0-20)
+	extent->nblocks = l1 & 0x1FFFFF;
+
+	extent->flag = l1 >> 63;
+}
+
+/**
+ * Find the dinode with inode number 'ino'
+ *
+ * @return On success, 0 is returned. On error, -errno is returned to indicate the error.
+ */
+static int
+dinodes_get(struct xal *xal, uint64_t ino, void **dinode)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	kh_ino_to_dinode_t *dinode_map = be->dinodes_map;
+	khiter_t iter;
+
+	iter = kh_get(ino_to_dinode, dinode_map, ino);
 	if (iter == kh_end(dinode_map)) {
 		XAL_DEBUG("FAILED: kh_get(0x%" PRIx64 ")", ino);
 		return -EINVAL;
@@ -652,6 +1390,9 @@ retrieve_and_decode_primary_superblock(struct xnvme_dev *dev, void *buf, struct
 
 	cand->root_idx = XAL_POOL_IDX_NONE;
 	cand->dirty = &cand->_dirty_storage;
+	cand->seq_lock = &cand->_seq_lock_storage;
+	cand->generation = &cand->_generation_storage;
+	cand->manifest_fd = -1;
 
 	be = (struct xal_be_xfs *)&cand->be;
 
@@ -676,18 +1417,22 @@ retrieve_and_decode_primary_superblock(struct xnvme_dev *dev, void *buf, struct
 	cand->sb.agcount = agcount;
 	cand->sb.dirblocksize = cand->sb.blocksize << psb->dirblklog;
 
+	be->geo.blocklog = psb->blocklog;
+	be->geo.inodelog = psb->inodelog;
+	be->geo.dirblkfsblog = psb->dirblklog;
+	be->geo.agblklog = psb->agblklog;
+	be->geo.agbno_mask = (1ULL << psb->agblklog) - 1;
+
 	*xal = cand;
 
 	return 0;
 }
 
 int
-xal_be_xfs_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts)
+xal_be_xfs_open(struct xnvme_dev *dev, struct xal **xal, char *mountpoint, struct xal_opts *opts)
 {
 	struct xal *cand = NULL;
 	struct xal_be_xfs *be;
-	char shm_name[XAL_PATH_MAXLEN + 9];
-	const char *shm;
 	void *buf;
 	int err;
 
@@ -711,6 +1456,31 @@ xal_be_xfs_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts)
 	be->base.index = xal_be_xfs_index;
 
 	be->buf = buf;
+	be->freeze_fd = -1;
+	be->verify_crc = opts->verify_crc;
+
+	if (mountpoint) {
+		be->mountpoint = strdup(mountpoint);
+		if (!be->mountpoint) {
+			XAL_DEBUG("FAILED: strdup(); errno(%d)", errno);
+			err = -errno;
+			goto failed;
+		}
+		be->quiesce = opts->quiesce;
+		be->validate_every = opts->validate_every;
+	}
+	if (opts->nthreads > XAL_NTHREADS_MAX || opts->qdepth > XAL_QDEPTH_MAX) {
+		XAL_DEBUG("FAILED: nthreads(%" PRIu32 ") or qdepth(%" PRIu32 ") out of range",
+			  opts->nthreads, opts->qdepth);
+		err = -EINVAL;
+		goto failed;
+	}
+	be->nthreads = opts->nthreads;
+	be->qdepth = opts->qdepth;
+	cand->merge_extents = opts->merge_extents;
+	be->decoders = decoders_select(&cand->sb);
+
+	XAL_DEBUG("INFO: decoders(%s)", be->decoders->name);
 
 	for (uint32_t seqno = 0; seqno < cand->sb.agcount; ++seqno) {
 		err = retrieve_and_decode_allocation_group(dev, buf, seqno, cand);
@@ -723,33 +1493,10 @@ xal_be_xfs_open(struct xnvme_dev *dev, struct xal **xal, struct xal_opts *opts)
 		cand->sb.nallocated += be->ags[seqno].agi_count;
 	}
 
-	if (opts->shm_name && strlen(opts->shm_name) > XAL_PATH_MAXLEN) {
-		XAL_DEBUG("FAILED: shm_name too long");
-		err = -EINVAL;
-		goto failed;
-	}
-
-	shm = NULL;
-	if (opts->shm_name) {
-		snprintf(shm_name, sizeof(shm_name), "%s_inodes", opts->shm_name);
-		shm = shm_name;
-	}
-	err = xal_pool_map(&cand->inodes, 40000000UL, cand->sb.nallocated, sizeof(struct xal_inode),
-	                   shm);
-	if (err) {
-		XAL_DEBUG("FAILED: xal_pool_map(inodes); err(%d)", err);
-		goto failed;
-	}
-
-	shm = NULL;
-	if (opts->shm_name) {
-		snprintf(shm_name, sizeof(shm_name), "%s_extents", opts->shm_name);
-		shm = shm_name;
-	}
-	err = xal_pool_map(&cand->extents, 40000000UL, cand->sb.nallocated, sizeof(struct xal_extent),
-	                   shm);
+	err = xal_pools_map(cand, cand->sb.nallocated,
+			    (size_t)cand->sb.agcount * cand->sb.agblocks, opts);
 	if (err) {
-		XAL_DEBUG("FAILED: xal_pool_map(extents); err(%d)", err);
+		XAL_DEBUG("FAILED: xal_pools_map(); err(%d)", err);
 		goto failed;
 	}
 
@@ -787,6 +1534,9 @@ btree_lblock_read(struct xal *xal, uint64_t fsbno, void *buf)
 		return err;
 	}
 
+	verify_crc(xal, XAL_CRC_BLK_BMA3, buf, xal->sb.blocksize,
+		   offsetof(struct xal_odf_btree_lfmt, bb_crc));
+
 	block->pos.level = be16toh(block->pos.level);
 	block->pos.numrecs = be16toh(block->pos.numrecs);
 	block->siblings.left = be64toh(block->siblings.left);
@@ -807,6 +1557,27 @@ btree_lblock_read(struct xal *xal, uint64_t fsbno, void *buf)
 	return err;
 }
 
+/**
+ * Returns the number of blocks of the given directory extent which are in the data segment
+ *
+ * Leaf and free-index blocks are mapped at XAL_ODF_DIR2_LEAF_OFFSET and beyond; they carry no
+ * directory entries and are thus not read.
+ */
+static uint64_t
+dir_extent_data_nblocks(struct xal *xal, const struct xal_extent *extent)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	const uint64_t leaf_fsblk = XAL_ODF_DIR2_LEAF_OFFSET >> be->geo.blocklog;
+
+	if (extent->start_offset >= leaf_fsblk) {
+		return 0;
+	}
+
+	return extent->nblocks < leaf_fsblk - extent->start_offset
+		   ? extent->nblocks
+		   : leaf_fsblk - extent->start_offset;
+}
+
 /**
  * Decodes BMA3 Block of directory-extents in the given 'buf' and
  */
@@ -816,7 +1587,7 @@ btree_lblock_decode_leaf_records(struct xal *xal, void *buf, struct xal_inode *s
 	struct xal_odf_btree_lfmt *leaf = buf;
 	struct pair_u64 *pairs = (void *)(((uint8_t *)buf) + sizeof(*leaf));
 	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
-	const uint32_t fsblk_per_dblk = xal->sb.dirblocksize / xal->sb.blocksize;
+	const uint32_t fsblk_per_dblk = 1U << be->geo.dirblkfsblog;
 
 	XAL_DEBUG("ENTER: Directory Extents -- B+Tree -- Leaf Node");
 
@@ -838,12 +1609,10 @@ btree_lblock_decode_leaf_records(struct xal *xal, void *buf, struct xal_inode *s
 
 		decode_xfs_extent(be64toh(pairs[rec].l0), be64toh(pairs[rec].l1), &extent);
 
+		extent.nblocks = dir_extent_data_nblocks(xal, &extent);
+
 		for (size_t fsblk = 0; fsblk < extent.nblocks; fsblk += fsblk_per_dblk) {
-			uint8_t dblock[ODF_BLOCK_FS_BYTES_MAX] = {0};
 			uint64_t fsbno = extent.start_block + fsblk;
-
-			union xal_odf_btree_magic *magic = (void *)(dblock);
-			size_t ofz_disk = xal_fsbno_offset(xal, fsbno);
 			int err;
 
 			XAL_DEBUG("INFO:  fsbno(0x%" PRIu64 ") @ ofz(%" PRIu64 ")", fsbno,
@@ -852,59 +1621,11 @@ btree_lblock_decode_leaf_records(struct xal *xal, void *buf, struct xal_inode *s
 			XAL_DEBUG("INFO:   dblk(%zu/%zu)", (fsblk / fsblk_per_dblk) + 1,
 				  extent.nblocks / fsblk_per_dblk);
 
-			err = dev_read_into(xal->dev, be->buf, xal->sb.dirblocksize, ofz_disk,
-					    dblock);
+			err = process_dinode_dir_extents_dblock(xal, fsbno, self);
 			if (err) {
-				XAL_DEBUG("FAILED: !dev_read(directory-extent)");
-				return err;
-			}
-
-			XAL_DEBUG("INFO: magic('%.4s', 0x%" PRIx32 "); ", magic->text, magic->num);
-
-			if ((be32toh(magic->num) != XAL_ODF_DIR3_DATA_MAGIC) &&
-			    (be32toh(magic->num) != XAL_ODF_DIR3_BLOCK_MAGIC)) {
-				XAL_DEBUG("FAILED: looks like invalid magic value");
+				XAL_DEBUG("FAILED: process_dinode_dir_extents_dblock():err(%d)", err);
 				return err;
 			}
-
-			for (uint64_t ofz = 64; ofz < xal->sb.dirblocksize;) {
-				uint8_t *dentry_cursor = dblock + ofz;
-				struct xal_inode dentry = {0};
-				uint32_t slot;
-
-				ofz += decode_dentry(dentry_cursor, &dentry);
-
-				/**
-				 * Seems like the only way to determine that there are no more
-				 * entries are if one start to decode uinvalid entries.
-				 * Such as a namelength of 0 or inode number 0.
-				 * Thus, checking for that here.
-				 */
-				if ((!dentry.ino) || (!dentry.namelen)) {
-					break;
-				}
-
-				/**
-				 * Skip processing the mandatory dentries: '.' and '..'
-				 */
-				if ((dentry.namelen == 1) && (dentry.name[0] == '.')) {
-					continue;
-				}
-				if ((dentry.namelen == 2) && (dentry.name[0] == '.') &&
-				    (dentry.name[1] == '.')) {
-					continue;
-				}
-
-				err = xal_pool_claim_inodes(&xal->inodes, 1, &slot);
-				if (err) {
-					XAL_DEBUG("FAILED: xal_pool_claim_inodes(...)");
-					return err;
-				}
-
-				dentry.parent_idx = xal_inode_idx(xal, self);
-				*xal_inode_at(xal, slot) = dentry;
-				self->content.dentries.count += 1;
-			}
 		}
 	}
 
@@ -1009,22 +1730,11 @@ process_dinode_dir_btree_root(struct xal *xal, struct xal_odf_dinode *dinode,
 		}
 	}
 
-	XAL_DEBUG("=### Processing: inodes constructed when chasing File-System Block Pointers")
 	XAL_DEBUG("INFO: dentries.count(%" PRIu32 ")", self->content.dentries.count);
-	for (uint32_t i = 0; i < self->content.dentries.count; ++i) {
-		struct xal_inode *inode = xal_inode_at(xal, self->content.dentries.inodes_idx + i);
-
-		XAL_DEBUG("INFO: inode->name(%.*s)", inode->namelen, inode->name);
-		err = process_ino(xal, inode->ino, inode);
-		if (err) {
-			XAL_DEBUG("FAILED: process_ino():err(%d)", err);
-			return err;
-		}
-	}
 
 	XAL_DEBUG("EXIT");
 
-	return err;
+	return 0;
 }
 
 static int
@@ -1033,8 +1743,7 @@ process_file_btree_leaf(struct xal *xal, uint64_t fsbno, struct xal_inode *self)
 	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
 	uint64_t ofz = xal_fsbno_offset(xal, fsbno);
 	struct xal_odf_btree_lfmt leaf = {0};
-	struct xal_extent *extents;
-	uint32_t extent_start;
+	xal_idx_t extent_start;
 	int err;
 
 	XAL_DEBUG("ENTER: File Extents -- B+Tree -- Leaf Node");
@@ -1044,6 +1753,9 @@ process_file_btree_leaf(struct xal *xal, uint64_t fsbno, struct xal_inode *self)
 		XAL_DEBUG("FAILED: dev_read(); err: %d", err);
 		return err;
 	}
+
+	verify_crc(xal, XAL_CRC_BLK_BMA3, be->buf, xal->sb.blocksize,
+		   offsetof(struct xal_odf_btree_lfmt, bb_crc));
 	memcpy(&leaf, be->buf, sizeof(leaf));
 
 	if (XAL_ODF_BMAP_CRC_MAGIC != be32toh(leaf.magic.num)) {
@@ -1075,11 +1787,11 @@ process_file_btree_leaf(struct xal *xal, uint64_t fsbno, struct xal_inode *self)
 		XAL_DEBUG("FAILED: xal_pool_claim_extents(); err(%d)", err);
 		return err;
 	}
-	extents = xal_extent_at(xal, extent_start);
 	self->content.extents.count += leaf.pos.numrecs;
 
 	for (uint16_t rec = 0; rec < leaf.pos.numrecs; ++rec) {
 		uint8_t *cursor = be->buf;
+		struct xal_extent extent;
 		uint64_t l0, l1;
 
 		cursor += sizeof(leaf) + 16ULL * rec;
@@ -1090,7 +1802,13 @@ process_file_btree_leaf(struct xal *xal, uint64_t fsbno, struct xal_inode *self)
 		l1 = be64toh(*((uint64_t *)cursor));
 		cursor += 8;
 
-		decode_xfs_extent(l0, l1, &extents[rec]);
+		decode_xfs_extent(l0, l1, &extent);
+
+		err = xal_extent_set(xal, extent_start + rec, &extent);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extent_set(); err(%d)", err);
+			return err;
+		}
 	}
 
 	XAL_DEBUG("EXIT");
@@ -1127,6 +1845,9 @@ process_file_btree_node(struct xal *xal, uint64_t fsbno, struct xal_inode *self)
 		XAL_DEBUG("FAILED: dev_read(); err: %d", err);
 		return err;
 	}
+
+	verify_crc(xal, XAL_CRC_BLK_BMA3, be->buf, xal->sb.blocksize,
+		   offsetof(struct xal_odf_btree_lfmt, bb_crc));
 	memcpy(&node, be->buf, sizeof(node));
 	memcpy(&pointers, be->buf + pointers_ofz, xal->sb.blocksize - pointers_ofz);
 
@@ -1272,21 +1993,26 @@ process_dinode_dir_local(struct xal *xal, struct xal_odf_dinode *dinode, struct
 
 	self->content.dentries.count = count;
 
-	err = xal_pool_claim_inodes(&xal->inodes, count, &self->content.dentries.inodes_idx);
+	err = xal_inodes_claim(xal, count, &self->content.dentries.inodes_idx);
 	if (err) {
-		XAL_DEBUG("FAILED: xal_pool_claim_inodes(); err(%d)", err);
+		XAL_DEBUG("FAILED: xal_inodes_claim(); err(%d)", err);
 		return err;
 	}
 
 	/** DECODE: namelen[1], offset[2], name[namelen], ftype[1], ino[4] | ino[8] */
 	for (int i = 0; i < count; ++i) {
 		struct xal_inode *dentry = xal_inode_at(xal, self->content.dentries.inodes_idx + i);
+		uint8_t namelen;
 
-		dentry->namelen = *cursor;
+		namelen = *cursor;
 		cursor += 1 + 2; ///< Advance past 'namelen' and 'offset[2]'
 
-		memcpy(dentry->name, cursor, dentry->namelen);
-		cursor += dentry->namelen; ///< Advance past 'name'
+		err = xal_inode_name_set(xal, dentry, (const char *)cursor, namelen);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_inode_name_set(); err(%d)", err);
+			return err;
+		}
+		cursor += namelen; ///< Advance past 'name'
 
 		dentry->ftype = *cursor;
 		cursor += 1; ///< Advance past 'ftype'
@@ -1305,11 +2031,6 @@ process_dinode_dir_local(struct xal *xal, struct xal_odf_dinode *dinode, struct
 		struct xal_inode *dentry = xal_inode_at(xal, self->content.dentries.inodes_idx + i);
 
 		dentry->parent_idx = xal_inode_idx(xal, self);
-		err = process_ino(xal, dentry->ino, dentry);
-		if (err) {
-			XAL_DEBUG("FAILED: process_ino()");
-			return err;
-		}
 	}
 
 	XAL_DEBUG("EXIT");
@@ -1325,7 +2046,6 @@ static int
 process_dinode_file_extents(struct xal *xal, struct xal_odf_dinode *dinode, struct xal_inode *self)
 {
 	struct pair_u64 *pairs = (void *)((uint8_t *)dinode + sizeof(*dinode));
-	struct xal_extent *extents;
 	uint64_t nextents;
 	int err;
 
@@ -1333,7 +2053,7 @@ process_dinode_file_extents(struct xal *xal, struct xal_odf_dinode *dinode, stru
 	    (dinode->di_nextents) ? be32toh(dinode->di_nextents) : be64toh(dinode->di_big_nextents);
 
 	XAL_DEBUG("ENTER: File Extents -- Dinode Inline");
-	XAL_DEBUG("INFO: name(%.*s)", self->namelen, self->name);
+	XAL_DEBUG("INFO: name(%.*s)", self->namelen, xal_inode_name(xal, self));
 	XAL_DEBUG("INFO: nextents(%" PRIu64 ")", nextents);
 
 	err = xal_pool_claim_extents(&xal->extents, nextents, &self->content.extents.extent_idx);
@@ -1343,11 +2063,18 @@ process_dinode_file_extents(struct xal *xal, struct xal_odf_dinode *dinode, stru
 	}
 	self->content.extents.count = nextents;
 
-	extents = xal_extent_at(xal, self->content.extents.extent_idx);
 	for (uint64_t rec = 0; rec < nextents; ++rec) {
+		struct xal_extent extent;
+
 		XAL_DEBUG("INFO: i(%" PRIu64 ")", rec);
 
-		decode_xfs_extent(be64toh(pairs[rec].l0), be64toh(pairs[rec].l1), &extents[rec]);
+		decode_xfs_extent(be64toh(pairs[rec].l0), be64toh(pairs[rec].l1), &extent);
+
+		err = xal_extent_set(xal, self->content.extents.extent_idx + rec, &extent);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extent_set(); err(%d)", err);
+			return err;
+		}
 	}
 
 	XAL_DEBUG("INFO: content.dentries(%" PRIu32 ")", self->content.dentries.count);
@@ -1359,10 +2086,12 @@ process_dinode_file_extents(struct xal *xal, struct xal_odf_dinode *dinode, stru
 /**
  * Decode the dentry starting at the given buffer
  *
+ * The name is not copied; 'name' is set to point at it within the given buffer.
+ *
  * @return The size, in bytes and including alignment padding, of the decoded directory entry.
  */
 static int
-decode_dentry(void *buf, struct xal_inode *dentry)
+decode_dentry(void *buf, struct xal_inode *dentry, const char **name)
 {
 	uint8_t *cursor = buf;
 	uint16_t nbytes = 8 + 1 + 1 + 2;
@@ -1383,7 +2112,7 @@ decode_dentry(void *buf, struct xal_inode *dentry)
 	dentry->namelen = *cursor;
 	cursor += 1;
 
-	memcpy(dentry->name, cursor, dentry->namelen);
+	*name = (const char *)cursor;
 	cursor += dentry->namelen;
 
 	dentry->ftype = *cursor;
@@ -1418,50 +2147,21 @@ process_dinode_dir_extents_dblock(struct xal *xal, uint64_t fsbno, struct xal_in
 		return err;
 	}
 
+	verify_crc(xal, XAL_CRC_BLK_DIR3, dblock, xal->sb.dirblocksize,
+		   offsetof(struct xfs_odf_dir_blk_hdr, crc));
+
 	XAL_DEBUG("INFO: magic('%.4s', 0x%" PRIx32 "); ", magic->text, magic->num);
 
 	if ((be32toh(magic->num) != XAL_ODF_DIR3_DATA_MAGIC) &&
 	    (be32toh(magic->num) != XAL_ODF_DIR3_BLOCK_MAGIC)) {
-		XAL_DEBUG("FAILED: looks like invalid magic value");
-		return err;
+		XAL_DEBUG("FAILED: expected magic(XDB3 | XDD3)");
+		return -EINVAL;
 	}
 
-	for (uint64_t ofz = 64; ofz < xal->sb.dirblocksize;) {
-		uint8_t *dentry_cursor = dblock + ofz;
-		struct xal_inode dentry = {0};
-		uint32_t slot;
-
-		ofz += decode_dentry(dentry_cursor, &dentry);
-
-		/**
-		 * Seems like the only way to determine that there are no more
-		 * entries are if one start to decode uinvalid entries.
-		 * Such as a namelength of 0 or inode number 0.
-		 * Thus, checking for that here.
-		 */
-		if ((!dentry.ino) || (!dentry.namelen)) {
-			break;
-		}
-
-		/**
-		 * Skip processing the mandatory dentries: '.' and '..'
-		 */
-		if ((dentry.namelen == 1) && (dentry.name[0] == '.')) {
-			continue;
-		}
-		if ((dentry.namelen == 2) && (dentry.name[0] == '.') && (dentry.name[1] == '.')) {
-			continue;
-		}
-
-		err = xal_pool_claim_inodes(&xal->inodes, 1, &slot);
-		if (err) {
-			XAL_DEBUG("FAILED: xal_pool_claim_inodes(...)");
-			return err;
-		}
-
-		dentry.parent_idx = xal_inode_idx(xal, self);
-		*xal_inode_at(xal, slot) = dentry;
-		self->content.dentries.count += 1;
+	err = be->decoders->decode_dblock(xal, dblock, self);
+	if (err) {
+		XAL_DEBUG("FAILED: decode_dblock(); err(%d)", err);
+		return err;
 	}
 
 	XAL_DEBUG("EXIT");
@@ -1508,9 +2208,9 @@ static int
 process_dinode_dir_extents(struct xal *xal, struct xal_odf_dinode *dinode, struct xal_inode *self)
 {
 	struct pair_u64 *extents = (void *)(((uint8_t *)dinode) + sizeof(struct xal_odf_dinode));
-	const uint32_t fsblk_per_dblk = xal->sb.dirblocksize / xal->sb.blocksize;
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	const uint32_t fsblk_per_dblk = 1U << be->geo.dirblkfsblog;
 	uint64_t nextents = be32toh(dinode->di_nextents);
-	int64_t nbytes = be64toh(dinode->size);
 	int err;
 
 	/**
@@ -1523,21 +2223,25 @@ process_dinode_dir_extents(struct xal *xal, struct xal_odf_dinode *dinode, struc
 	}
 	XAL_DEBUG("INFO:       nextents(%" PRIu64 ")", nextents);
 	XAL_DEBUG("INFO: fsblk_per_dblk(%" PRIu32 ")", fsblk_per_dblk);
-	XAL_DEBUG("INFO:         nbytes(%" PRIu64 ")", nbytes);
 
 	self->content.dentries.inodes_idx = xal->inodes.free;
 
 	/**
-	 * Decode the extents and process each block
+	 * Decode the extents and process the data blocks; extents are sorted by logical offset, thus
+	 * the first extent mapping the leaf segment ends the data segment.
 	 */
-	for (uint64_t i = 0; (nbytes > 0) && (i < nextents); ++i) {
+	for (uint64_t i = 0; i < nextents; ++i) {
 		struct xal_extent extent = {0};
 
 		XAL_DEBUG("INFO: extent(%" PRIu64 "/%" PRIu64 ")", i + 1, nextents);
-		XAL_DEBUG("INFO: nbytes(%" PRIu64 ")", nbytes);
 
 		decode_xfs_extent(be64toh(extents[i].l0), be64toh(extents[i].l1), &extent);
 
+		extent.nblocks = dir_extent_data_nblocks(xal, &extent);
+		if (!extent.nblocks) {
+			break;
+		}
+
 		for (size_t fsblk = 0; fsblk < extent.nblocks; fsblk += fsblk_per_dblk) {
 			uint64_t fsbno = extent.start_block + fsblk;
 
@@ -1554,22 +2258,262 @@ process_dinode_dir_extents(struct xal *xal, struct xal_odf_dinode *dinode, struc
 				return err;
 			}
 		}
+	}
+
+	return 0;
+}
+
+/**
+ * Construct the absolute path of 'inode' below the mountpoint, by walking its parents
+ */
+static int
+inode_path(struct xal *xal, struct xal_inode *inode, char *buf, size_t buflen)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	size_t mountpoint_len = strlen(be->mountpoint);
+	size_t ofz = buflen - 1;
+
+	buf[ofz] = '\0';
+
+	for (struct xal_inode *cur = inode; cur->parent_idx != XAL_POOL_IDX_NONE;
+	     cur = xal_inode_at(xal, cur->parent_idx)) {
+		if ((size_t)cur->namelen + 1 > ofz) {
+			return -ENAMETOOLONG;
+		}
+		ofz -= cur->namelen;
+		memcpy(&buf[ofz], xal_inode_name(xal, cur), cur->namelen);
+		buf[--ofz] = '/';
+	}
 
-		nbytes -= extent.nblocks * xal->sb.blocksize;
+	if (mountpoint_len > ofz) {
+		return -ENAMETOOLONG;
 	}
+	ofz -= mountpoint_len;
+	memcpy(&buf[ofz], be->mountpoint, mountpoint_len);
 
-	XAL_DEBUG("=### Processing: inodes constructed when decoding dir(FMT_EXTENTS)")
-	for (uint32_t i = 0; i < self->content.dentries.count; ++i) {
-		struct xal_inode *inode = xal_inode_at(xal, self->content.dentries.inodes_idx + i);
+	memmove(buf, &buf[ofz], buflen - ofz);
 
-		err = process_ino(xal, inode->ino, inode);
+	return 0;
+}
+
+/**
+ * A mapping of file-offset to device-offset, in bytes
+ */
+struct mapping {
+	uint64_t logical;
+	uint64_t physical;
+	uint64_t length;
+};
+
+/**
+ * Merge adjacent mappings, in place, which are contiguous both in the file and on the device
+ *
+ * FIEMAP may report physically contiguous XFS extents as one, thus both sides are normalized
+ * before comparison.
+ */
+static uint32_t
+mappings_merge(struct mapping *maps, uint32_t nmaps)
+{
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < nmaps; ++i) {
+		if (n && (maps[n - 1].logical + maps[n - 1].length == maps[i].logical) &&
+		    (maps[n - 1].physical + maps[n - 1].length == maps[i].physical)) {
+			maps[n - 1].length += maps[i].length;
+			continue;
+		}
+		maps[n++] = maps[i];
+	}
+
+	return n;
+}
+
+static bool
+fiemap_extent_is_located(const struct fiemap_extent *fe)
+{
+	return !(fe->fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DELALLOC));
+}
+
+/**
+ * Compare the extents decoded on-disk for 'self' with those reported by FIEMAP
+ *
+ * Only the location of the extents is compared; extents without a location on the device, e.g.
+ * delayed allocations, are left out of the FIEMAP side, as they have no on-disk counterpart.
+ */
+static int
+extents_match_fiemap(struct xal *xal, struct xal_inode *self, const struct fiemap *fiemap,
+		     bool *match)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	uint32_t ndisk = self->content.extents.count;
+	uint32_t nfiemap = 0;
+	struct mapping *disk, *fm;
+
+	disk = calloc(ndisk + fiemap->fm_mapped_extents + 1, sizeof(*disk));
+	if (!disk) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		return -errno;
+	}
+	fm = &disk[ndisk];
+
+	for (uint32_t i = 0; i < ndisk; ++i) {
+		struct xal_extent extent;
+
+		xal_extent_get(xal, self->content.extents.extent_idx + i, &extent);
+
+		disk[i].logical = extent.start_offset << be->geo.blocklog;
+		disk[i].physical = xal_fsbno_offset(xal, extent.start_block);
+		disk[i].length = extent.nblocks << be->geo.blocklog;
+	}
+
+	for (uint32_t i = 0; i < fiemap->fm_mapped_extents; ++i) {
+		const struct fiemap_extent *fe = &fiemap->fm_extents[i];
+
+		if (!fiemap_extent_is_located(fe)) {
+			continue;
+		}
+
+		fm[nfiemap].logical = fe->fe_logical;
+		fm[nfiemap].physical = fe->fe_physical;
+		fm[nfiemap].length = fe->fe_length;
+		nfiemap += 1;
+	}
+
+	ndisk = mappings_merge(disk, ndisk);
+	nfiemap = mappings_merge(fm, nfiemap);
+
+	*match = (ndisk == nfiemap) && !memcmp(disk, fm, ndisk * sizeof(*disk));
+
+	free(disk);
+
+	return 0;
+}
+
+/**
+ * Convert a device offset, in bytes, to a filesystem block number in AG-encoded format
+ */
+static uint64_t
+fsbno_from_offset(struct xal *xal, uint64_t ofz)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	uint64_t blkno = ofz >> be->geo.blocklog;
+
+	return ((blkno / xal->sb.agblocks) << be->geo.agblklog) | (blkno % xal->sb.agblocks);
+}
+
+/**
+ * Replace the extents of 'self' with those reported by FIEMAP
+ *
+ * The extents are overwritten in place when they fit, otherwise a new range is claimed from the
+ * pool and the previous one is left unused until the next xal_index().
+ */
+static int
+extents_from_fiemap(struct xal *xal, struct xal_inode *self, const struct fiemap *fiemap)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	struct xal_extents *extents = &self->content.extents;
+	uint32_t nextents = 0;
+	int err;
+
+	for (uint32_t i = 0; i < fiemap->fm_mapped_extents; ++i) {
+		const struct fiemap_extent *fe = &fiemap->fm_extents[i];
+
+		if (fiemap_extent_is_located(fe)) {
+			nextents += xal_extent_nrecords(xal, fe->fe_length >> be->geo.blocklog);
+		}
+	}
+
+	if (nextents > extents->count) {
+		err = xal_pool_claim_extents(&xal->extents, nextents, &extents->extent_idx);
 		if (err) {
-			XAL_DEBUG("FAILED: process_ino():err(%d)", err);
+			XAL_DEBUG("FAILED: xal_pool_claim_extents(); err(%d)", err);
 			return err;
 		}
 	}
+	extents->count = 0;
 
-	return err;
+	for (uint32_t i = 0; i < fiemap->fm_mapped_extents; ++i) {
+		const struct fiemap_extent *fe = &fiemap->fm_extents[i];
+		struct xal_extent extent;
+
+		if (!fiemap_extent_is_located(fe)) {
+			continue;
+		}
+
+		extent.start_offset = fe->fe_logical >> be->geo.blocklog;
+		extent.start_block = fsbno_from_offset(xal, fe->fe_physical);
+		extent.nblocks = fe->fe_length >> be->geo.blocklog;
+		extent.flag = !!(fe->fe_flags & FIEMAP_EXTENT_UNWRITTEN);
+
+		err = xal_extent_set(xal, extents->extent_idx + extents->count, &extent);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extent_set(); err(%d)", err);
+			return err;
+		}
+		extents->count += xal_extent_nrecords(xal, extent.nblocks);
+	}
+
+	return 0;
+}
+
+/**
+ * Validate the on-disk decoded extents of every n'th regular file against FIEMAP
+ *
+ * On mismatch the extents of the file are replaced by those from FIEMAP. A file which no longer
+ * exists is counted as a mismatch and left as decoded.
+ */
+static int
+validate_file(struct xal *xal, struct xal_inode *self)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	struct xal_validate_stats *stats = &be->validate_stats;
+	struct fiemap *fiemap;
+	char path[PATH_MAX];
+	bool match = false;
+	int err;
+
+	stats->nfiles += 1;
+
+	if ((!be->validate_every) || ((stats->nfiles - 1) % be->validate_every)) {
+		return 0;
+	}
+	stats->nsampled += 1;
+
+	err = inode_path(xal, self, path, sizeof(path));
+	if (err) {
+		XAL_DEBUG("FAILED: inode_path(); err(%d)", err);
+		return err;
+	}
+
+	err = xal_be_fiemap_retrieve(path, &fiemap);
+	if (err == -ENOENT) {
+		XAL_DEBUG("INFO: path(%s) removed since the on-disk parse", path);
+		stats->nmismatch += 1;
+		return 0;
+	}
+	if (err) {
+		XAL_DEBUG("FAILED: xal_be_fiemap_retrieve(%s); err(%d)", path, err);
+		return err;
+	}
+
+	err = extents_match_fiemap(xal, self, fiemap, &match);
+	if (err || match) {
+		free(fiemap);
+		return err;
+	}
+
+	XAL_DEBUG("INFO: path(%s) extents differ from FIEMAP; falling back", path);
+	stats->nmismatch += 1;
+
+	err = extents_from_fiemap(xal, self, fiemap);
+	free(fiemap);
+	if (err) {
+		XAL_DEBUG("FAILED: extents_from_fiemap(); err(%d)", err);
+		return err;
+	}
+	stats->nfallback += 1;
+
+	return 0;
 }
 
 /**
@@ -1578,6 +2522,7 @@ process_dinode_dir_extents(struct xal *xal, struct xal_odf_dinode *dinode, struc
 static int
 process_ino(struct xal *xal, uint64_t ino, struct xal_inode *self)
 {
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
 	struct xal_odf_dinode *dinode;
 	int err;
 
@@ -1606,7 +2551,7 @@ process_ino(struct xal *xal, uint64_t ino, struct xal_inode *self)
 	self->ino = be64toh(dinode->ino);
 
 	XAL_DEBUG("INFO: ino(0x%" PRIx64 ") @ ofz(%" PRIu64 "), name(%.*s)[%" PRIu8 "]", ino,
-		  xal_ino_decode_absolute_offset(xal, ino), self->namelen, self->name,
+		  xal_ino_decode_absolute_offset(xal, ino), self->namelen, xal_inode_name(xal, self),
 		  self->namelen);
 	XAL_DEBUG("INFO: format(0x%" PRIu8 ")", dinode->di_format);
 
@@ -1687,45 +2632,659 @@ process_ino(struct xal *xal, uint64_t ino, struct xal_inode *self)
 		return -ENOSYS;
 	}
 
+	if ((self->ftype == XAL_ODF_DIR3_FT_REG_FILE) && be->mountpoint) {
+		err = validate_file(xal, self);
+		if (err) {
+			XAL_DEBUG("FAILED: validate_file(); err(%d)", err);
+			return err;
+		}
+	}
+
+	if ((self->ftype == XAL_ODF_DIR3_FT_REG_FILE) && xal->merge_extents) {
+		err = xal_extents_merge(xal, &self->content.extents);
+		if (err) {
+			XAL_DEBUG("FAILED: xal_extents_merge(); err(%d)", err);
+			return err;
+		}
+	}
+
 	XAL_DEBUG("EXIT");
 
 	return 0;
 }
 
-int
-xal_be_xfs_index(struct xal *xal)
-{
-	struct xal_inode *root;
-	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
-	int err;
+/**
+ * Stack of inodes, by index in the inode pool, which are yet to be processed
+ */
+struct ino_stack {
+	xal_idx_t *idxs;
+	size_t count;
+	size_t capacity;
+};
 
-	if (!be->dinodes) {
-		return -EINVAL;
+static int
+ino_stack_push(struct ino_stack *stack, xal_idx_t idx)
+{
+	if (stack->count == stack->capacity) {
+		size_t capacity = stack->capacity ? stack->capacity * 2 : 1024;
+		xal_idx_t *idxs;
+
+		idxs = realloc(stack->idxs, capacity * sizeof(*idxs));
+		if (!idxs) {
+			XAL_DEBUG("FAILED: realloc(); errno(%d)", errno);
+			return -errno;
+		}
+		stack->idxs = idxs;
+		stack->capacity = capacity;
 	}
 
-	xal_pool_clear(&xal->inodes);
-	xal_pool_clear(&xal->extents);
+	stack->idxs[stack->count++] = idx;
 
-	err = xal_pool_claim_inodes(&xal->inodes, 1, &xal->root_idx);
+	return 0;
+}
+
+/**
+ * Clear the pools and setup the root inode as the single inode on the stack
+ */
+static int
+index_prepare(struct xal *xal, struct ino_stack *stack)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	struct xal_inode *root;
+	int err;
+
+	xal_pools_clear(xal);
+	memset(&be->validate_stats, 0, sizeof(be->validate_stats));
+
+	err = xal_inodes_claim(xal, 1, &xal->root_idx);
 	if (err) {
+		XAL_DEBUG("FAILED: xal_inodes_claim(); err(%d)", err);
 		return err;
 	}
 
 	root = xal_inode_at(xal, xal->root_idx);
 	root->ino = xal->sb.rootino;
 	root->ftype = XAL_ODF_DIR3_FT_DIR;
-	root->namelen = 0;
 	root->parent_idx = XAL_POOL_IDX_NONE;
 	root->content.extents.count = 0;
 	root->content.dentries.count = 0;
 
-	err = process_ino(xal, root->ino, root);
+	err = xal_inode_name_set(xal, root, "", 0);
 	if (err) {
-		XAL_DEBUG("FAILED: process_ino(); err(%d)", err);
+		XAL_DEBUG("FAILED: xal_inode_name_set(); err(%d)", err);
+		return err;
+	}
+
+	stack->count = 0;
+
+	return ino_stack_push(stack, xal->root_idx);
+}
+
+/**
+ * Process at most 'budget' inodes from the stack, pushing the children of directories
+ *
+ * The children are pushed in reverse, thus the inodes are processed, and their children claimed
+ * from the pool, in the same depth-first order as a recursive traversal would.
+ *
+ * @return 0 when the stack is exhausted, -EAGAIN when the budget is, and negative errno on error.
+ */
+static int
+index_walk(struct xal *xal, struct ino_stack *stack, uint64_t budget, uint64_t *nprocessed)
+{
+	while (stack->count) {
+		struct xal_inode *inode;
+		int err;
+
+		if (!budget) {
+			return -EAGAIN;
+		}
+		budget -= 1;
+
+		inode = xal_inode_at(xal, stack->idxs[--stack->count]);
+
+		err = process_ino(xal, inode->ino, inode);
+		if (err) {
+			XAL_DEBUG("FAILED: process_ino(); err(%d)", err);
+			return err;
+		}
+		*nprocessed += 1;
+
+		if (!xal_inode_is_dir(inode)) {
+			continue;
+		}
+
+		for (uint32_t i = inode->content.dentries.count; i > 0; --i) {
+			err = ino_stack_push(stack, inode->content.dentries.inodes_idx + i - 1);
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int
+xal_be_xfs_index(struct xal *xal)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	struct ino_stack stack = {0};
+	uint64_t nprocessed = 0;
+	int err;
+
+	if (!be->dinodes) {
+		return -EINVAL;
+	}
+	if (be->step) {
+		XAL_DEBUG("FAILED: incremental indexing in progress");
+		return -EBUSY;
+	}
+
+	err = index_prepare(xal, &stack);
+	if (!err) {
+		err = index_walk(xal, &stack, UINT64_MAX, &nprocessed);
+	}
+
+	free(stack.idxs);
+	quiesce_end(xal);
+
+	if (err) {
+		XAL_DEBUG("FAILED: index_walk(); err(%d)", err);
 		return err;
 	}
 
 	atomic_store(xal->dirty, false);
 
+	return 0;
+}
+
+enum step_phase {
+	STEP_PHASE_LOCATE = 0, ///< Walking the inode allocation B+tree of an AG at a time
+	STEP_PHASE_CHUNKS = 1, ///< Reading and decoding inode-chunks
+	STEP_PHASE_TREE   = 2, ///< Processing inodes into the directory tree
+	STEP_PHASE_DONE   = 3,
+};
+
+struct step_slot {
+	struct xal_be_xfs_step *step;
+	struct chunk_desc *desc;
+	void *buf; ///< io-buffer of 'chunk_nbytes' allocated via xnvme_buf_alloc()
+};
+
+/**
+ * State of incremental indexing, see xal_index_begin()
+ */
+struct xal_be_xfs_step {
+	struct xal *xal;
+	enum step_phase phase;
+	uint32_t seqno;             ///< The allocation group to walk next
+	struct chunk_descs chunks;
+	size_t nsubmitted;          ///< Number of chunks submitted for reading
+	size_t ndecoded;            ///< Number of chunks decoded
+	struct xnvme_queue *queue;  ///< NULL when reads are done synchronously
+	struct step_slot *slots;
+	struct step_slot **free;    ///< Stack of slots available for submission
+	uint32_t nslots;
+	uint32_t nfree;
+	int err;                    ///< Error of a completion, reported by the next step
+	struct ino_stack stack;
+	uint64_t ninodes;           ///< Number of inodes processed into the tree
+};
+
+static void
+step_read_cb(struct xnvme_cmd_ctx *ctx, void *cb_arg)
+{
+	struct step_slot *slot = cb_arg;
+	struct xal_be_xfs_step *step = slot->step;
+	int err = -EIO;
+
+	if (!xnvme_cmd_ctx_cpl_status(ctx)) {
+		err = chunk_decode(step->xal, slot->desc, slot->buf);
+	}
+	if (err && !step->err) {
+		XAL_DEBUG("FAILED: read or decode of chunk; err(%d)", err);
+		step->err = err;
+	}
+
+	xnvme_queue_put_cmd_ctx(ctx->async.queue, ctx);
+
+	step->free[step->nfree++] = slot;
+	step->ndecoded += 1;
+}
+
+static void
+step_term(struct xal *xal, struct xal_be_xfs_step *step)
+{
+	if (step->queue) {
+		xnvme_queue_drain(step->queue);
+		xnvme_queue_term(step->queue);
+	}
+	for (uint32_t i = 0; step->slots && (i < step->nslots); ++i) {
+		xnvme_buf_free(xal->dev, step->slots[i].buf);
+	}
+	free(step->slots);
+	free(step->free);
+	free(step->chunks.descs);
+	free(step->stack.idxs);
+	free(step);
+}
+
+/**
+ * Setup the queue and slots for asynchronous chunk reads; without them reads are synchronous
+ */
+static void
+step_queue_init(struct xal *xal, struct xal_be_xfs_step *step)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	const uint64_t chunk_nbytes = (uint64_t)CHUNK_NINO << be->geo.inodelog;
+	const uint32_t qdepth = be->qdepth ? be->qdepth : PIPELINE_QDEPTH_DEFAULT;
+	int err;
+
+	err = xnvme_queue_init(xal->dev, qdepth, 0, &step->queue);
+	if (err) {
+		XAL_DEBUG("INFO: xnvme_queue_init(); err(%d); reading synchronously", err);
+		step->queue = NULL;
+		return;
+	}
+
+	step->slots = calloc(qdepth, sizeof(*step->slots));
+	step->free = calloc(qdepth, sizeof(*step->free));
+	if (!step->slots || !step->free) {
+		goto failed;
+	}
+	step->nslots = qdepth;
+
+	for (uint32_t i = 0; i < qdepth; ++i) {
+		step->slots[i].step = step;
+		step->slots[i].buf = xnvme_buf_alloc(xal->dev, chunk_nbytes);
+		if (!step->slots[i].buf) {
+			goto failed;
+		}
+		step->free[step->nfree++] = &step->slots[i];
+	}
+
+	return;
+
+failed:
+	XAL_DEBUG("INFO: failed allocating slots; reading synchronously");
+	for (uint32_t i = 0; step->slots && (i < qdepth); ++i) {
+		xnvme_buf_free(xal->dev, step->slots[i].buf);
+	}
+	free(step->slots);
+	free(step->free);
+	step->slots = NULL;
+	step->free = NULL;
+	step->nslots = 0;
+	step->nfree = 0;
+	xnvme_queue_term(step->queue);
+	step->queue = NULL;
+}
+
+/**
+ * Walk the inode allocation B+tree of one AG per unit of budget
+ */
+static int
+step_locate(struct xal *xal, struct xal_be_xfs_step *step, uint64_t *budget)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+
+	for (; step->seqno < xal->sb.agcount; ++step->seqno) {
+		struct xal_ag *ag = &be->ags[step->seqno];
+		int err;
+
+		if (!*budget) {
+			return -EAGAIN;
+		}
+		*budget -= 1;
+
+		err = retrieve_dinodes_via_iab3(xal, ag, ag->agi_root, &step->chunks);
+		if (err) {
+			XAL_DEBUG("FAILED: retrieve_dinodes_via_iab3(); err(%d)", err);
+			return err;
+		}
+	}
+
+	if (step->chunks.ninodes > xal->sb.nallocated) {
+		XAL_DEBUG("FAILED: ninodes(%" PRIu64 ") > nallocated(%" PRIu64 ")",
+			  step->chunks.ninodes, xal->sb.nallocated);
+		return -EINVAL;
+	}
+
+	be->dinodes = calloc(1, xal->sb.nallocated * xal->sb.inodesize);
+	if (!be->dinodes) {
+		XAL_DEBUG("FAILED: calloc()");
+		return -errno;
+	}
+
+	return 0;
+}
+
+/**
+ * Read and decode one inode-chunk per unit of budget
+ *
+ * With a queue, reads are submitted for all free slots and completions are reaped without
+ * blocking; when none have completed -EAGAIN is returned, such that the caller can yield.
+ */
+static int
+step_chunks(struct xal *xal, struct xal_be_xfs_step *step, uint64_t *budget)
+{
+	struct xal_be_xfs *be = (struct xal_be_xfs *)&xal->be;
+	const uint64_t chunk_nbytes = (uint64_t)CHUNK_NINO << be->geo.inodelog;
+
+	while (step->ndecoded < step->chunks.count) {
+		struct chunk_desc *descs = step->chunks.descs;
+		int err;
+
+		if (step->err) {
+			return step->err;
+		}
+		if (!*budget) {
+			return -EAGAIN;
+		}
+
+		if (!step->queue) {
+			err = dev_read(xal->dev, be->buf, chunk_nbytes, descs[step->ndecoded].ofz);
+			if (err) {
+				XAL_DEBUG("FAILED: dev_read(chunk)");
+				return err;
+			}
+
+			err = chunk_decode(xal, &descs[step->ndecoded], be->buf);
+			if (err) {
+				XAL_DEBUG("FAILED: chunk_decode(); err(%d)", err);
+				return err;
+			}
+
+			step->ndecoded += 1;
+			*budget -= 1;
+			continue;
+		}
+
+		while (step->nfree && (step->nsubmitted < step->chunks.count)) {
+			struct step_slot *slot = step->free[step->nfree - 1];
+
+			slot->desc = &descs[step->nsubmitted];
+
+			err = chunk_read_submit(xal, step->queue, slot->desc, slot->buf,
+						step_read_cb, slot);
+			if ((err == -EBUSY) || (err == -EAGAIN)) {
+				break;
+			}
+			if (err) {
+				XAL_DEBUG("FAILED: chunk_read_submit(); err(%d)", err);
+				return err;
+			}
+
+			step->nfree -= 1;
+			step->nsubmitted += 1;
+		}
+
+		err = xnvme_queue_poke(step->queue, *budget < UINT32_MAX ? *budget : UINT32_MAX);
+		if (err < 0) {
+			XAL_DEBUG("FAILED: xnvme_queue_poke(); err(%d)", err);
+			return err;
+		}
+		if (!err) {
+			return -EAGAIN;
+		}
+
+		*budget -= ((uint64_t)err < *budget) ? (uint64_t)err : *budget;
+	}
+
+	return step->err;
+}
+
+int
+xal_index_begin(struct xal *xal)
+{
+	struct xal_be_xfs *be;
+	struct xal_be_xfs_step *step;
+	bool dirty;
+	int err;
+
+	if (!xal) {
+		return -EINVAL;
+	}
+
+	be = (struct xal_be_xfs *)&xal->be;
+	if (be->base.type != XAL_BACKEND_XFS) {
+		XAL_DEBUG("FAILED: incremental indexing is only supported by the XFS backend");
+		return -ENOSYS;
+	}
+	if (xal->shared_view) {
+		return -EINVAL;
+	}
+	if (atomic_load(&xal->sealed)) {
+		XAL_DEBUG("FAILED: the index is sealed");
+		return -EPERM;
+	}
+	if (atomic_load(&xal->snapshots)) {
+		XAL_DEBUG("FAILED: the index is pinned by snapshots");
+		return -EBUSY;
+	}
+	if (be->step) {
+		XAL_DEBUG("FAILED: incremental indexing already in progress");
+		return -EBUSY;
+	}
+
+	step = calloc(1, sizeof(*step));
+	if (!step) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		return -errno;
+	}
+	step->xal = xal;
+
+	/**
+	 * The inodes are retrieved as part of the steps, unless done already via
+	 * xal_dinodes_retrieve()
+	 */
+	step->phase = be->dinodes ? STEP_PHASE_TREE : STEP_PHASE_LOCATE;
+
+	/**
+	 * The index is modified from here on, by index_prepare() or by the steps; readers are to
+	 * retry, and the index is dirty until xal_index_done() completes it
+	 */
+	dirty = atomic_load(xal->dirty);
+	xal_write_begin(xal);
+	atomic_store(xal->dirty, true);
+
+	if (step->phase == STEP_PHASE_LOCATE) {
+		err = quiesce_begin(xal);
+		if (err) {
+			XAL_DEBUG("FAILED: quiesce_begin(); err(%d)", err);
+			atomic_store(xal->dirty, dirty);
+			xal_write_end(xal);
+			free(step);
+			return err;
+		}
+
+		be->dinodes_map = kh_init(ino_to_dinode);
+		if (!be->dinodes_map) {
+			XAL_DEBUG("FAILED: kh_init()");
+			quiesce_end(xal);
+			atomic_store(xal->dirty, dirty);
+			xal_write_end(xal);
+			free(step);
+			return -ENOMEM;
+		}
+
+		step_queue_init(xal, step);
+	} else {
+		err = index_prepare(xal, &step->stack);
+		if (err) {
+			XAL_DEBUG("FAILED: index_prepare(); err(%d)", err);
+			step_term(xal, step);
+			xal_manifest_publish(xal);
+			xal_write_end(xal);
+			return err;
+		}
+	}
+
+	be->step = step;
+
+	return 0;
+}
+
+int
+xal_index_step(struct xal *xal, uint32_t budget, struct xal_index_progress *progress)
+{
+	struct xal_be_xfs *be;
+	struct xal_be_xfs_step *step;
+	uint64_t remaining = budget;
+	int err = 0;
+
+	if (!xal) {
+		return -EINVAL;
+	}
+
+	be = (struct xal_be_xfs *)&xal->be;
+	if (be->base.type != XAL_BACKEND_XFS) {
+		return -ENOSYS;
+	}
+
+	step = be->step;
+	if (!step) {
+		XAL_DEBUG("FAILED: no incremental indexing in progress; see xal_index_begin()");
+		return -EINVAL;
+	}
+
+	switch (step->phase) {
+	case STEP_PHASE_LOCATE:
+		err = step_locate(xal, step, &remaining);
+		if (err) {
+			break;
+		}
+		step->phase = STEP_PHASE_CHUNKS;
+		/* fall through */
+
+	case STEP_PHASE_CHUNKS:
+		err = step_chunks(xal, step, &remaining);
+		if (err) {
+			break;
+		}
+		step->phase = STEP_PHASE_TREE;
+
+		err = index_prepare(xal, &step->stack);
+		if (err) {
+			XAL_DEBUG("FAILED: index_prepare(); err(%d)", err);
+			break;
+		}
+		/* fall through */
+
+	case STEP_PHASE_TREE:
+		err = index_walk(xal, &step->stack, remaining, &step->ninodes);
+		if (err) {
+			break;
+		}
+		step->phase = STEP_PHASE_DONE;
+		/* fall through */
+
+	case STEP_PHASE_DONE:
+		break;
+	}
+
+	if (progress) {
+		progress->nags_walked = step->seqno;
+		progress->nchunks = step->chunks.count;
+		progress->nchunks_decoded = step->ndecoded;
+		progress->ninodes = step->ninodes;
+		progress->npending = step->stack.count;
+	}
+
+	if (err && (err != -EAGAIN)) {
+		XAL_DEBUG("FAILED: step in phase(%d); err(%d)", step->phase, err);
+	}
+
 	return err;
 }
+
+int
+xal_index_done(struct xal *xal)
+{
+	struct xal_be_xfs *be;
+	struct xal_be_xfs_step *step;
+	bool complete, retrieved;
+
+	if (!xal) {
+		return -EINVAL;
+	}
+
+	be = (struct xal_be_xfs *)&xal->be;
+	if (be->base.type != XAL_BACKEND_XFS) {
+		return -ENOSYS;
+	}
+
+	step = be->step;
+	if (!step) {
+		return -EINVAL;
+	}
+
+	complete = step->phase == STEP_PHASE_DONE;
+	retrieved = step->phase >= STEP_PHASE_TREE;
+
+	step_term(xal, step);
+	be->step = NULL;
+
+	if (!retrieved) {
+		/**
+		 * Aborted before all dinodes were retrieved; discard them such that a following
+		 * xal_index_begin() starts over
+		 */
+		free(be->dinodes);
+		be->dinodes = NULL;
+		if (be->dinodes_map) {
+			kh_destroy(ino_to_dinode, be->dinodes_map);
+			be->dinodes_map = NULL;
+		}
+	}
+
+	quiesce_end(xal);
+
+	if (complete) {
+		atomic_store(xal->dirty, false);
+		xal_manifest_publish(xal);
+	}
+	xal_write_end(xal);
+
+	return complete ? 0 : -ECANCELED;
+}
+
+int
+xal_get_crc_stats(struct xal *xal, struct xal_crc_stats *stats)
+{
+	struct xal_be_xfs *be;
+
+	if (!xal || !stats) {
+		return -EINVAL;
+	}
+
+	be = (struct xal_be_xfs *)&xal->be;
+	if (be->base.type != XAL_BACKEND_XFS) {
+		XAL_DEBUG("FAILED: Backend is not XFS");
+		return -EINVAL;
+	}
+
+	*stats = be->crc_stats;
+
+	return 0;
+}
+
+int
+xal_get_validate_stats(struct xal *xal, struct xal_validate_stats *stats)
+{
+	struct xal_be_xfs *be;
+
+	if (!xal || !stats) {
+		return -EINVAL;
+	}
+
+	be = (struct xal_be_xfs *)&xal->be;
+	if (be->base.type != XAL_BACKEND_XFS) {
+		XAL_DEBUG("FAILED: Backend is not XFS");
+		return -EINVAL;
+	}
+
+	*stats = be->validate_stats;
+
+	return 0;
+}
@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include <endian.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <xal_crc32c.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+#define CRC32C_POLY_REFLECTED 0x82F63B78
+
+typedef uint32_t (*crc32c_fn)(uint32_t crc, const uint8_t *buf, size_t len);
+
+static uint32_t crc32c_table[8][256];
+static crc32c_fn crc32c_impl;
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Table-driven slice-by-8; consumes eight bytes per iteration using eight 1KB lookup tables
+ */
+static uint32_t
+crc32c_sw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+	while (len && ((uintptr_t)buf & 7)) {
+		crc = crc32c_table[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+		len--;
+	}
+
+	while (len >= 8) {
+		uint64_t word;
+
+		memcpy(&word, buf, sizeof(word));
+		word = htole64(word) ^ crc;
+
+		crc = crc32c_table[7][word & 0xFF] ^ crc32c_table[6][(word >> 8) & 0xFF] ^
+		      crc32c_table[5][(word >> 16) & 0xFF] ^ crc32c_table[4][(word >> 24) & 0xFF] ^
+		      crc32c_table[3][(word >> 32) & 0xFF] ^ crc32c_table[2][(word >> 40) & 0xFF] ^
+		      crc32c_table[1][(word >> 48) & 0xFF] ^ crc32c_table[0][word >> 56];
+
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len--) {
+		crc = crc32c_table[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) static uint32_t
+crc32c_hw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+	uint64_t crc64 = crc;
+
+	while (len >= 8) {
+		uint64_t word;
+
+		memcpy(&word, buf, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+		buf += 8;
+		len -= 8;
+	}
+
+	crc = crc64;
+	while (len--) {
+		crc = _mm_crc32_u8(crc, *buf++);
+	}
+
+	return crc;
+}
+
+static bool
+crc32c_hw_supported(void)
+{
+	return __builtin_cpu_supports("sse4.2");
+}
+#elif defined(__aarch64__)
+__attribute__((target("+crc"))) static uint32_t
+crc32c_hw(uint32_t crc, const uint8_t *buf, size_t len)
+{
+	while (len >= 8) {
+		uint64_t word;
+
+		memcpy(&word, buf, sizeof(word));
+		crc = __builtin_aarch64_crc32cx(crc, word);
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len--) {
+		crc = __builtin_aarch64_crc32cb(crc, *buf++);
+	}
+
+	return crc;
+}
+
+static bool
+crc32c_hw_supported(void)
+{
+	return getauxval(AT_HWCAP) & HWCAP_CRC32;
+}
+#endif
+
+static void
+crc32c_init(void)
+{
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+
+		for (int bit = 0; bit < 8; ++bit) {
+			crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY_REFLECTED : 0);
+		}
+		crc32c_table[0][i] = crc;
+	}
+
+	for (uint32_t i = 0; i < 256; ++i) {
+		for (int slice = 1; slice < 8; ++slice) {
+			uint32_t prev = crc32c_table[slice - 1][i];
+
+			crc32c_table[slice][i] = (prev >> 8) ^ crc32c_table[0][prev & 0xFF];
+		}
+	}
+
+	crc32c_impl = crc32c_sw;
+
+#if defined(__x86_64__) || defined(__aarch64__)
+	if (crc32c_hw_supported()) {
+		crc32c_impl = crc32c_hw;
+	}
+#endif
+}
+
+uint32_t
+xal_crc32c(uint32_t crc, const void *buf, size_t len)
+{
+	pthread_once(&crc32c_once, crc32c_init);
+
+	return crc32c_impl(crc, buf, len);
+}
+
+bool
+xal_crc32c_verify(const void *buf, size_t nbytes, size_t cksum_ofz)
+{
+	const uint8_t *cursor = buf;
+	const uint32_t zero = 0;
+	uint32_t stored, crc;
+
+	if (cksum_ofz + sizeof(stored) > nbytes) {
+		return false;
+	}
+
+	memcpy(&stored, cursor + cksum_ofz, sizeof(stored));
+
+	crc = xal_crc32c(~0U, cursor, cksum_ofz);
+	crc = xal_crc32c(crc, &zero, sizeof(zero));
+	crc = xal_crc32c(crc, cursor + cksum_ofz + sizeof(zero),
+			 nbytes - cksum_ofz - sizeof(zero));
+
+	return le32toh(stored) == ~crc;
+}
@@ -1,160 +1,1228 @@
 #define _GNU_SOURCE
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <libxal.h>
+#include <limits.h>
+#include <linux/mempolicy.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 #include <xal_pool.h>
 
+static size_t
+align_up(size_t nbytes, size_t alignment)
+{
+	return (nbytes + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Returns the default huge page size, in bytes, as reported by /proc/meminfo; 0 if unknown
+ */
+static size_t
+hugepage_size(void)
+{
+	char line[128];
+	size_t kib = 0;
+	FILE *f;
+
+	f = fopen("/proc/meminfo", "r");
+	if (!f) {
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "Hugepagesize: %zu kB", &kib) == 1) {
+			break;
+		}
+	}
+	fclose(f);
+
+	return kib * 1024;
+}
+
+unsigned long
+xal_pool_numa_online(void)
+{
+	unsigned long nodemask = 0;
+	unsigned int first, last;
+	char list[256], *cursor;
+	FILE *f;
+
+	f = fopen("/sys/devices/system/node/online", "r");
+	if (!f) {
+		return 1;
+	}
+	cursor = fgets(list, sizeof(list), f);
+	fclose(f);
+
+	/**
+	 * The list is of comma-separated nodes and ranges of nodes, e.g. "0-1,3"
+	 */
+	while (cursor && *cursor) {
+		int nchars = 0;
+
+		if (sscanf(cursor, "%u-%u%n", &first, &last, &nchars) != 2) {
+			if (sscanf(cursor, "%u%n", &first, &nchars) != 1) {
+				break;
+			}
+			last = first;
+		}
+		for (unsigned int node = first; node <= last && node < XAL_POOL_NUMA_NODES_MAX; ++node) {
+			nodemask |= 1UL << node;
+		}
+
+		cursor += nchars;
+		if (*cursor != ',') {
+			break;
+		}
+		cursor += 1;
+	}
+
+	return nodemask ? nodemask : 1;
+}
+
+/**
+ * Apply the memory policy of the pool to the given range; before the pages are touched
+ *
+ * For shared memory, the policy is that of the object, thus it holds for other mappings as well.
+ */
+static int
+pool_mbind(struct xal_pool *pool, void *addr, size_t nbytes)
+{
+	if (!pool->numa_mode) {
+		return 0;
+	}
+
+	if (syscall(SYS_mbind, addr, nbytes, pool->numa_mode, &pool->numa_nodemask,
+		    sizeof(pool->numa_nodemask) * CHAR_BIT + 1, 0)) {
+		XAL_DEBUG("FAILED: mbind(); errno(%d)", errno);
+		return -errno;
+	}
+
+	return 0;
+}
+
 int
 xal_pool_unmap(struct xal_pool *pool)
 {
-	return munmap(pool->memory, pool->reserved * pool->element_size);
+	if (!pool->memory) {
+		return 0;
+	}
+
+	if (pool->shared && pool->fd >= 0) {
+		close(pool->fd);
+		pool->fd = -1;
+	}
+
+	return munmap(pool->memory, align_up(pool->reserved * pool->element_size, pool->pagesize));
+}
+
+/**
+ * Map the range of 'nbytes' at 'begin' of a private pool with explicit huge pages
+ *
+ * The page at 'begin' is already mapped when the allocated elements end within it; mapping over it
+ * would discard its content, thus, only the pages beyond it are mapped. The kernel reserves the
+ * huge pages of each step at mmap-time; when the first step cannot be reserved, the pool falls back
+ * to transparent huge pages, rather than failing, and is grown with mprotect() as regular memory.
+ */
+static int
+pool_grow_hugetlb(struct xal_pool *pool, uint8_t *begin, size_t nbytes)
+{
+	uint8_t *tail = (uint8_t *)pool->memory + pool->allocated * pool->element_size;
+	uint8_t *mapped = (uint8_t *)align_up((uintptr_t)tail, pool->pagesize);
+	void *mem;
+
+	if (mapped >= begin + nbytes) {
+		return 0;
+	}
+
+	mem = mmap(mapped, begin + nbytes - mapped, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0);
+	if (mem == MAP_FAILED) {
+		int err = -errno;
+
+		/**
+		 * A failed MAP_FIXED may have unmapped the range; it is reserved again, such that the
+		 * address space of the pool is not handed out to other mappings
+		 */
+		mem = mmap(mapped, begin + nbytes - mapped, PROT_NONE,
+			   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+		if (mem == MAP_FAILED) {
+			XAL_DEBUG("FAILED: mmap(PROT_NONE); errno(%d)", errno);
+			return -errno;
+		}
+		if (pool_mbind(pool, mapped, begin + nbytes - mapped)) {
+			XAL_DEBUG("INFO: pool_mbind(...); continuing");
+		}
+
+		if (pool->allocated) {
+			XAL_DEBUG("FAILED: mmap(MAP_HUGETLB); err(%d)", err);
+			return err;
+		}
+
+		XAL_DEBUG("INFO: mmap(MAP_HUGETLB); err(%d); using transparent huge pages", err);
+		pool->hugetlb = false;
+		pool->thp = true;
+		if (madvise(pool->memory, align_up(pool->reserved * pool->element_size, pool->pagesize),
+			    MADV_HUGEPAGE)) {
+			XAL_DEBUG("INFO: madvise(MADV_HUGEPAGE); errno(%d); continuing", errno);
+		}
+
+		if (mprotect(begin, nbytes, PROT_READ | PROT_WRITE)) {
+			XAL_DEBUG("FAILED: mprotect(...); errno(%d)", errno);
+			return -errno;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * The mapping replaces that of the reservation, thus, the memory policy is applied anew
+	 */
+	if (pool_mbind(pool, mapped, begin + nbytes - mapped)) {
+		XAL_DEBUG("INFO: pool_mbind(...); continuing");
+	}
+
+	return 0;
 }
 
+/**
+ * Make 'growby' more elements read / writeable; only the tail beyond what is allocated is changed
+ *
+ * The range is extended to whole pages of 'pool->pagesize', thus, with huge pages, a grown range
+ * is backed by huge pages rather than split into regular pages. For private memory the range is
+ * made accessible with mprotect(); for shared memory, the backing object is extended with
+ * ftruncate() and the range mapped from it, thus the object is only as large as what is allocated.
+ * Either way the range reads as zeroes without being written, thus its pages are committed as they
+ * are claimed and written, not when grown. With explicit huge pages in private memory, the range
+ * is mapped with MAP_HUGETLB instead, see pool_grow_hugetlb().
+ */
 int
 xal_pool_grow(struct xal_pool *pool, size_t growby)
 {
-	size_t growby_nbytes = growby * pool->element_size;
-	size_t allocated_nbytes = growby_nbytes + pool->allocated * pool->element_size;
+	const uintptr_t pagemask = pool->pagesize - 1;
 	uint8_t *cursor = pool->memory;
+	uint8_t *tail = &cursor[pool->allocated * pool->element_size];
+	uint8_t *begin = (uint8_t *)((uintptr_t)tail & ~pagemask);
+	size_t growby_nbytes = growby * pool->element_size;
+	size_t nbytes;
+
+	if (pool->allocated + growby > pool->reserved) {
+		XAL_DEBUG("FAILED: pool exhausted; reserved(%zu)", pool->reserved);
+		return -ENOMEM;
+	}
 
-	if (mprotect(pool->memory, allocated_nbytes, PROT_READ | PROT_WRITE)) {
+	nbytes = align_up((tail - begin) + growby_nbytes, pool->pagesize);
+
+	if (pool->shared) {
+		off_t ofz = begin - cursor;
+		void *mem;
+
+		if (ftruncate(pool->fd, ofz + nbytes)) {
+			XAL_DEBUG("FAILED: ftruncate(...); errno(%d)", errno);
+			return -errno;
+		}
+
+		mem = mmap(begin, nbytes, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_FIXED | (pool->hugetlb ? 0 : MAP_NORESERVE), pool->fd, ofz);
+		if (mem == MAP_FAILED) {
+			XAL_DEBUG("FAILED: mmap(...); errno(%d)", errno);
+			return -errno;
+		}
+
+		if (pool_mbind(pool, begin, nbytes)) {
+			XAL_DEBUG("INFO: pool_mbind(...); continuing");
+		}
+
+		if (pool->thp && madvise(begin, nbytes, MADV_HUGEPAGE)) {
+			XAL_DEBUG("INFO: madvise(MADV_HUGEPAGE); errno(%d); continuing", errno);
+		}
+	} else if (pool->hugetlb) {
+		int err = pool_grow_hugetlb(pool, begin, nbytes);
+
+		if (err) {
+			XAL_DEBUG("FAILED: pool_grow_hugetlb(...); err(%d)", err);
+			return err;
+		}
+	} else if (mprotect(begin, nbytes, PROT_READ | PROT_WRITE)) {
 		XAL_DEBUG("FAILED: mprotect(...); errno(%d)", errno);
 		return -errno;
 	}
-	memset(&cursor[pool->free * pool->element_size], 0, growby_nbytes);
+
+	if (pool->mlock && mlock(begin, nbytes)) {
+		XAL_DEBUG("INFO: mlock(...); errno(%d); continuing", errno);
+	}
 
 	pool->allocated += growby;
 
 	return 0;
 }
 
+/**
+ * Ensure that 'count' elements beyond 'free' are allocated; growing the allocation geometrically
+ */
+static int
+pool_reserve(struct xal_pool *pool, size_t count)
+{
+	size_t growby;
+
+	if (pool->free + count > pool->reserved) {
+		XAL_DEBUG("FAILED: pool exhausted; free(%zu) + count(%zu) > reserved(%zu)",
+			  pool->free, count, pool->reserved);
+		return -ENOMEM;
+	}
+
+	if (pool->free + count <= pool->allocated) {
+		return 0;
+	}
+
+	growby = pool->allocated > pool->growby ? pool->allocated : pool->growby;
+	if (pool->free + count > pool->allocated + growby) {
+		growby = pool->free + count - pool->allocated;
+	}
+	if (pool->allocated + growby > pool->reserved) {
+		growby = pool->reserved - pool->allocated;
+	}
+
+	return xal_pool_grow(pool, growby);
+}
+
+/**
+ * Reserve 'nbytes' of address space, aligned to 'pool->pagesize', as PROT_NONE
+ *
+ * When the page size exceeds the system page size, the range is over-reserved by a page and
+ * trimmed, such that it starts at a page boundary, e.g. of a huge page.
+ */
+static int
+pool_reserve_va(struct xal_pool *pool, size_t nbytes)
+{
+	size_t padding_max = pool->pagesize > (size_t)sysconf(_SC_PAGESIZE) ? pool->pagesize : 0;
+	uint8_t *mem, *aligned;
+	size_t padding;
+
+	nbytes = align_up(nbytes, pool->pagesize);
+
+	mem = mmap(NULL, nbytes + padding_max, PROT_NONE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (MAP_FAILED == mem) {
+		XAL_DEBUG("FAILED: mmap(...); errno(%d)", errno);
+		return -errno;
+	}
+
+	aligned = (uint8_t *)align_up((uintptr_t)mem, pool->pagesize);
+	padding = aligned - mem;
+	if (padding) {
+		munmap(mem, padding);
+	}
+	if (padding_max - padding) {
+		munmap(aligned + nbytes, padding_max - padding);
+	}
+
+	pool->memory = aligned;
+
+	return 0;
+}
+
+/**
+ * Reserve 'nbytes' of private anonymous memory
+ *
+ * The range is made accessible by xal_pool_grow(). With explicit huge pages, only the address space
+ * is reserved here, as for regular pages; the huge pages are mapped, and thereby reserved by the
+ * kernel, a growth step at a time, see pool_grow_hugetlb().
+ */
+static int
+pool_map_anonymous(struct xal_pool *pool, size_t nbytes, enum xal_hugepages hugepages)
+{
+	size_t hpsize = hugepages ? hugepage_size() : 0;
+	int err;
+
+	if (hugepages && !hpsize) {
+		XAL_DEBUG("INFO: huge page size unknown; using regular pages");
+		hugepages = XAL_HUGEPAGES_NONE;
+	}
+
+	pool->pagesize = hugepages ? hpsize : (size_t)sysconf(_SC_PAGESIZE);
+
+	err = pool_reserve_va(pool, nbytes);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_reserve_va(...); err(%d)", err);
+		return err;
+	}
+
+	if (hugepages == XAL_HUGEPAGES_EXPLICIT) {
+		pool->hugetlb = true;
+		return 0;
+	}
+
+	if (hugepages && madvise(pool->memory, align_up(nbytes, hpsize), MADV_HUGEPAGE)) {
+		XAL_DEBUG("INFO: madvise(MADV_HUGEPAGE); errno(%d); continuing", errno);
+	}
+
+	return 0;
+}
+
+static void
+pool_hugetlbfs_path(char *path, size_t len, const char *shm_name)
+{
+	snprintf(path, len, "%s/%s", XAL_POOL_HUGETLBFS, shm_name[0] == '/' ? &shm_name[1] : shm_name);
+}
+
+/**
+ * Open, as 'pool->fd', the file in hugetlbfs named as the shared memory object would be
+ */
+static int
+pool_open_hugetlbfs(struct xal_pool *pool, const char *shm_name)
+{
+	size_t hpsize = hugepage_size();
+	char path[sizeof(XAL_POOL_HUGETLBFS) + XAL_PATH_MAXLEN + 16];
+	int fd;
+
+	if (!hpsize) {
+		return -ENOTSUP;
+	}
+
+	pool_hugetlbfs_path(path, sizeof(path), shm_name);
+
+	fd = open(path, O_CREAT | O_RDWR, 0666);
+	if (fd < 0) {
+		XAL_DEBUG("INFO: open(%s); errno(%d)", path, errno);
+		return -errno;
+	}
+
+	if (ftruncate(fd, 0)) {
+		XAL_DEBUG("INFO: ftruncate(%s); errno(%d)", path, errno);
+		close(fd);
+		unlink(path);
+		return -errno;
+	}
+
+	pool->fd = fd;
+	pool->pagesize = hpsize;
+	pool->hugetlb = true;
+
+	return 0;
+}
+
+/**
+ * Create, as 'pool->fd', a sealable memfd backing the pool
+ *
+ * With explicit huge pages, the memfd is created with MFD_HUGETLB, falling back to regular pages
+ * advised as transparent huge pages.
+ */
+static int
+pool_open_memfd(struct xal_pool *pool, const char *name, enum xal_hugepages hugepages)
+{
+	size_t hpsize = hugepages ? hugepage_size() : 0;
+
+	if (hugepages == XAL_HUGEPAGES_EXPLICIT && hpsize) {
+		pool->fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING | MFD_HUGETLB);
+		if (pool->fd >= 0) {
+			pool->pagesize = hpsize;
+			pool->hugetlb = true;
+		} else {
+			XAL_DEBUG("INFO: memfd_create(MFD_HUGETLB); errno(%d); using transparent", errno);
+		}
+	}
+
+	if (!pool->hugetlb) {
+		pool->fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		if (pool->fd < 0) {
+			XAL_DEBUG("FAILED: memfd_create(%s); errno(%d)", name, errno);
+			return -errno;
+		}
+
+		pool->thp = hugepages && hpsize;
+		pool->pagesize = pool->thp ? hpsize : (size_t)sysconf(_SC_PAGESIZE);
+	}
+	pool->memfd = true;
+
+	return 0;
+}
+
+/**
+ * Open, as 'pool->fd', the empty object backing a shared pool: the POSIX shared memory object or
+ * file in hugetlbfs named 'shm_name', or, with 'memfd', a memfd
+ */
+static int
+pool_open_shared(struct xal_pool *pool, const char *shm_name, enum xal_hugepages hugepages,
+		 bool memfd)
+{
+	size_t hpsize = hugepages ? hugepage_size() : 0;
+	int err;
+
+	if (memfd) {
+		return pool_open_memfd(pool, shm_name, hugepages);
+	}
+
+	if (hugepages == XAL_HUGEPAGES_EXPLICIT) {
+		err = pool_open_hugetlbfs(pool, shm_name);
+		if (err) {
+			XAL_DEBUG("INFO: pool_open_hugetlbfs(); err(%d); using transparent", err);
+			hugepages = XAL_HUGEPAGES_TRANSPARENT;
+		}
+	}
+
+	if (!pool->hugetlb) {
+		pool->fd = shm_open(shm_name, O_CREAT | O_RDWR, 0666);
+		if (pool->fd < 0) {
+			XAL_DEBUG("FAILED: shm_open(%s); errno(%d)", shm_name, errno);
+			return -errno;
+		}
+
+		/**
+		 * Truncating to zero discards the content of a pre-existing object, thus the pool
+		 * reads as zeroes without having to touch, and thereby commit, every page.
+		 */
+		if (ftruncate(pool->fd, 0)) {
+			XAL_DEBUG("FAILED: ftruncate(); errno(%d)", errno);
+			err = -errno;
+			close(pool->fd);
+			pool->fd = -1;
+			return err;
+		}
+
+		pool->thp = hugepages && hpsize;
+		pool->pagesize = pool->thp ? hpsize : (size_t)sysconf(_SC_PAGESIZE);
+	}
+
+	return 0;
+}
+
+/**
+ * Open, as 'pool->fd', the object backing the pool, see pool_open_shared(), and reserve address
+ * space for it; the object is extended as the pool grows, see xal_pool_grow()
+ */
+static int
+pool_map_shared(struct xal_pool *pool, size_t nbytes, const char *shm_name,
+		enum xal_hugepages hugepages, bool memfd)
+{
+	int err;
+
+	err = pool_open_shared(pool, shm_name, hugepages, memfd);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_open_shared(...); err(%d)", err);
+		return err;
+	}
+
+	err = pool_reserve_va(pool, nbytes);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_reserve_va(...); err(%d)", err);
+		close(pool->fd);
+		pool->fd = -1;
+		return err;
+	}
+
+	return 0;
+}
+
 int
 xal_pool_map(struct xal_pool *pool, size_t reserved, size_t allocated, size_t element_size,
-             const char *shm_name)
+             const struct xal_pool_opts *opts)
 {
+	const char *shm_name = opts->shm_name;
 	size_t nbytes = reserved * element_size;
 	int err;
 
-	if (pool->reserved) {
+	if (pool->reserved || allocated > reserved) {
 		XAL_DEBUG("FAILED: xal_pool_map(...); errno(%d)", EINVAL);
 		return -EINVAL;
 	}
 
 	pool->reserved = reserved;
+	pool->allocated = 0;
+	pool->growby = allocated;
 	pool->element_size = element_size;
 	pool->free = 0;
+	pool->used = 0;
+	pool->shared = shm_name != NULL;
+	pool->hugetlb = false;
+	pool->thp = false;
+	pool->memfd = false;
+	pool->mlock = false;
+	pool->fd = -1;
+	for (int i = 0; i < XAL_POOL_NCLASSES; ++i) {
+		pool->freelist[i] = XAL_POOL_IDX_NONE;
+	}
+
+	switch (opts->numa_policy) {
+	case XAL_NUMA_DEFAULT:
+		pool->numa_mode = 0;
+		pool->numa_nodemask = 0;
+		break;
+	case XAL_NUMA_INTERLEAVE:
+		pool->numa_mode = MPOL_INTERLEAVE;
+		pool->numa_nodemask = xal_pool_numa_online();
+		break;
+	case XAL_NUMA_BIND:
+		if (opts->numa_node < 0 || opts->numa_node >= XAL_POOL_NUMA_NODES_MAX) {
+			XAL_DEBUG("FAILED: invalid numa_node(%d)", opts->numa_node);
+			pool->reserved = 0;
+			return -EINVAL;
+		}
+		pool->numa_mode = MPOL_BIND;
+		pool->numa_nodemask = 1UL << opts->numa_node;
+		break;
+	}
 
 	if (shm_name) {
-		int fd;
+		err = pool_map_shared(pool, nbytes, shm_name, opts->hugepages, opts->memfd);
+	} else {
+		err = pool_map_anonymous(pool, nbytes, opts->hugepages);
+	}
+	if (err) {
+		XAL_DEBUG("FAILED: pool_map_*(...); err(%d)", err);
+		pool->reserved = 0;
+		return err;
+	}
 
-		fd = shm_open(shm_name, O_CREAT | O_RDWR, 0666);
-		if (fd < 0) {
-			XAL_DEBUG("FAILED: shm_open(%s); errno(%d)", shm_name, errno);
-			return -errno;
+	err = pool_mbind(pool, pool->memory, align_up(nbytes, pool->pagesize));
+	if (err) {
+		XAL_DEBUG("FAILED: pool_mbind(...); err(%d)", err);
+		xal_pool_unmap(pool);
+		pool->reserved = 0;
+		return err;
+	}
+
+	err = xal_pool_grow(pool, allocated);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_grow(...); err(%d)", err);
+		xal_pool_unmap(pool);
+		pool->reserved = 0;
+		return err;
+	}
+
+	return 0;
+}
+
+int
+xal_pool_attach_fd(struct xal_pool *pool, int fd, bool hugetlb, size_t element_size,
+		   size_t reserved_nbytes)
+{
+	char path[32];
+	struct stat st;
+	size_t nbytes;
+	void *mem;
+	int err;
+
+	/**
+	 * A shared mapping of a descriptor opened for writing may become writable, which refuses
+	 * the F_SEAL_WRITE of xal_seal(); the object is thus opened again, read-only
+	 */
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		XAL_DEBUG("FAILED: open(%s); errno(%d)", path, errno);
+		return -errno;
+	}
+
+	if (fstat(fd, &st)) {
+		XAL_DEBUG("FAILED: fstat(%d); errno(%d)", fd, errno);
+		err = -errno;
+		close(fd);
+		return err;
+	}
+	if (!st.st_size) {
+		XAL_DEBUG("FAILED: fd(%d) is empty", fd);
+		close(fd);
+		return -ENODATA;
+	}
+
+	memset(pool, 0, sizeof(*pool));
+	pool->element_size = element_size;
+	pool->pagesize = (size_t)sysconf(_SC_PAGESIZE);
+	if (hugetlb && hugepage_size()) {
+		pool->pagesize = hugepage_size();
+	}
+	pool->shared = true;
+	pool->hugetlb = hugetlb;
+	pool->fd = -1;
+	for (int i = 0; i < XAL_POOL_NCLASSES; ++i) {
+		pool->freelist[i] = XAL_POOL_IDX_NONE;
+	}
+
+	/**
+	 * The address space of the pool in the producer is reserved, such that the mapping can grow
+	 * in place, see xal_pool_refresh()
+	 */
+	nbytes = reserved_nbytes > (size_t)st.st_size ? reserved_nbytes : (size_t)st.st_size;
+	nbytes = align_up(nbytes, pool->pagesize);
+
+	err = pool_reserve_va(pool, nbytes);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_reserve_va(...); err(%d)", err);
+		close(fd);
+		return err;
+	}
+	pool->reserved = nbytes / element_size;
+
+	mem = mmap(pool->memory, st.st_size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0);
+	if (mem == MAP_FAILED) {
+		XAL_DEBUG("FAILED: mmap(%d); errno(%d)", fd, errno);
+		err = -errno;
+		xal_pool_unmap(pool);
+		pool->memory = NULL;
+		close(fd);
+		return err;
+	}
+	pool->allocated = st.st_size / element_size;
+	pool->fd = fd;
+
+	return 0;
+}
+
+int
+xal_pool_attach(struct xal_pool *pool, const char *shm_name, bool hugetlb, size_t element_size,
+		size_t reserved_nbytes)
+{
+	char path[sizeof(XAL_POOL_HUGETLBFS) + XAL_PATH_MAXLEN + 16];
+	int fd, err;
+
+	if (hugetlb) {
+		pool_hugetlbfs_path(path, sizeof(path), shm_name);
+		fd = open(path, O_RDONLY);
+	} else {
+		fd = shm_open(shm_name, O_RDONLY, 0);
+	}
+	if (fd < 0) {
+		XAL_DEBUG("FAILED: open(%s); errno(%d)", shm_name, errno);
+		return -errno;
+	}
+
+	err = xal_pool_attach_fd(pool, fd, hugetlb, element_size, reserved_nbytes);
+	close(fd);
+
+	return err;
+}
+
+int
+xal_pool_refresh(struct xal_pool *pool)
+{
+	size_t mapped = align_up(pool->allocated * pool->element_size, pool->pagesize);
+	size_t reserved = align_up(pool->reserved * pool->element_size, pool->pagesize);
+	struct stat st;
+	size_t nbytes;
+	void *mem;
+
+	if (!pool->shared || pool->fd < 0) {
+		XAL_DEBUG("FAILED: the pool is not attached, see xal_pool_attach()");
+		return -EINVAL;
+	}
+
+	if (fstat(pool->fd, &st)) {
+		XAL_DEBUG("FAILED: fstat(%d); errno(%d)", pool->fd, errno);
+		return -errno;
+	}
+
+	nbytes = (size_t)st.st_size < reserved ? (size_t)st.st_size : reserved;
+	if (nbytes <= mapped) {
+		return 0;
+	}
+
+	mem = mmap((uint8_t *)pool->memory + mapped, nbytes - mapped, PROT_READ,
+		   MAP_SHARED | MAP_FIXED, pool->fd, mapped);
+	if (mem == MAP_FAILED) {
+		XAL_DEBUG("FAILED: mmap(%d); errno(%d)", pool->fd, errno);
+		return -errno;
+	}
+
+	if (pool->mlock && mlock(mem, nbytes - mapped)) {
+		XAL_DEBUG("INFO: mlock(...); errno(%d); continuing", errno);
+	}
+
+	pool->allocated = nbytes / pool->element_size;
+
+	return 0;
+}
+
+int
+xal_pool_prefault(struct xal_pool *pool, int flags)
+{
+	size_t pagesize = pool->pagesize ? pool->pagesize : (size_t)sysconf(_SC_PAGESIZE);
+	size_t nbytes = align_up(pool->allocated * pool->element_size, pagesize);
+
+	if (!pool->memory || !nbytes) {
+		return 0;
+	}
+
+	if ((flags & XAL_PREFAULT_WILLNEED) && madvise(pool->memory, nbytes, MADV_WILLNEED)) {
+		XAL_DEBUG("INFO: madvise(MADV_WILLNEED); errno(%d); continuing", errno);
+	}
+
+	/**
+	 * MADV_POPULATE_READ maps the pages without writing them, thus, it also works for read-only
+	 * views; on kernels without it (< 5.14), a page is touched at a time
+	 */
+	if ((flags & XAL_PREFAULT_POPULATE) && madvise(pool->memory, nbytes, MADV_POPULATE_READ)) {
+		const volatile uint8_t *cursor = pool->memory;
+
+		XAL_DEBUG("INFO: madvise(MADV_POPULATE_READ); errno(%d); touching pages", errno);
+
+		for (size_t ofz = 0; ofz < nbytes; ofz += pagesize) {
+			(void)cursor[ofz];
 		}
+	}
 
-		err = ftruncate(fd, nbytes);
-		if (err) {
-			XAL_DEBUG("FAILED: ftruncate(); errno(%d)", errno);
-			close(fd);
+	if (flags & XAL_PREFAULT_MLOCK) {
+		if (mlock(pool->memory, nbytes)) {
+			XAL_DEBUG("FAILED: mlock(); errno(%d)", errno);
 			return -errno;
 		}
+		pool->mlock = true;
+	}
 
-		pool->memory = mmap(NULL, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-		close(fd);
-		if (pool->memory == MAP_FAILED) {
-			XAL_DEBUG("FAILED: mmap(); errno(%d)", errno);
+	return 0;
+}
+
+int
+xal_pool_replicate(struct xal_pool *dst, const struct xal_pool *src, int node)
+{
+	const size_t pagesize = src->pagesize ? src->pagesize : (size_t)sysconf(_SC_PAGESIZE);
+	size_t nbytes = align_up(src->free * src->element_size, pagesize);
+	int err;
+
+	if (node >= XAL_POOL_NUMA_NODES_MAX) {
+		XAL_DEBUG("FAILED: invalid node(%d)", node);
+		return -EINVAL;
+	}
+
+	memset(dst, 0, sizeof(*dst));
+	dst->element_size = src->element_size;
+	dst->reserved = src->free;
+	dst->allocated = src->free;
+	dst->free = src->free;
+	dst->used = src->free;
+	dst->pagesize = pagesize;
+	dst->fd = -1;
+	dst->numa_mode = node < 0 ? 0 : MPOL_BIND;
+	dst->numa_nodemask = node < 0 ? 0 : 1UL << node;
+	for (int i = 0; i < XAL_POOL_NCLASSES; ++i) {
+		dst->freelist[i] = XAL_POOL_IDX_NONE;
+	}
+
+	if (!nbytes) {
+		return 0;
+	}
+
+	dst->memory = mmap(NULL, nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (dst->memory == MAP_FAILED) {
+		XAL_DEBUG("FAILED: mmap(); errno(%d)", errno);
+		dst->memory = NULL;
+		return -errno;
+	}
+
+	err = pool_mbind(dst, dst->memory, nbytes);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_mbind(); err(%d)", err);
+		xal_pool_unmap(dst);
+		dst->memory = NULL;
+		return err;
+	}
+
+	if (pagesize > (size_t)sysconf(_SC_PAGESIZE) && madvise(dst->memory, nbytes, MADV_HUGEPAGE)) {
+		XAL_DEBUG("INFO: madvise(MADV_HUGEPAGE); errno(%d); continuing", errno);
+	}
+
+	memcpy(dst->memory, src->memory, src->free * src->element_size);
+
+	if (mprotect(dst->memory, nbytes, PROT_READ)) {
+		XAL_DEBUG("FAILED: mprotect(); errno(%d)", errno);
+		xal_pool_unmap(dst);
+		dst->memory = NULL;
+		return -errno;
+	}
+
+	return 0;
+}
+
+int
+xal_pool_map_like(struct xal_pool *dst, const struct xal_pool *src, const char *shm_name)
+{
+	const bool hugepages = src->pagesize > (size_t)sysconf(_SC_PAGESIZE);
+	const enum xal_hugepages kind = !hugepages      ? XAL_HUGEPAGES_NONE
+					: src->hugetlb ? XAL_HUGEPAGES_EXPLICIT
+						       : XAL_HUGEPAGES_TRANSPARENT;
+	size_t nbytes = src->reserved * src->element_size;
+	int err;
+
+	memset(dst, 0, sizeof(*dst));
+	dst->reserved = src->reserved;
+	dst->growby = src->growby;
+	dst->element_size = src->element_size;
+	dst->mlock = src->mlock;
+	dst->numa_mode = src->numa_mode;
+	dst->numa_nodemask = src->numa_nodemask;
+	dst->shared = shm_name != NULL;
+	dst->fd = -1;
+	for (int i = 0; i < XAL_POOL_NCLASSES; ++i) {
+		dst->freelist[i] = XAL_POOL_IDX_NONE;
+	}
+
+	if (shm_name) {
+		err = pool_map_shared(dst, nbytes, shm_name, kind, src->memfd);
+	} else {
+		err = pool_map_anonymous(dst, nbytes, kind);
+	}
+	if (err) {
+		XAL_DEBUG("FAILED: pool_map_*(...); err(%d)", err);
+		dst->reserved = 0;
+		return err;
+	}
+
+	err = pool_mbind(dst, dst->memory, align_up(nbytes, dst->pagesize));
+	if (err) {
+		XAL_DEBUG("FAILED: pool_mbind(...); err(%d)", err);
+		xal_pool_unmap(dst);
+		dst->reserved = 0;
+		return err;
+	}
+
+	err = xal_pool_grow(dst, src->growby);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_grow(...); err(%d)", err);
+		xal_pool_unmap(dst);
+		dst->reserved = 0;
+		return err;
+	}
+
+	return 0;
+}
+
+int
+xal_pool_renew(struct xal_pool *pool, const char *shm_name)
+{
+	const bool hugepages = pool->pagesize > (size_t)sysconf(_SC_PAGESIZE);
+	const enum xal_hugepages kind = !hugepages       ? XAL_HUGEPAGES_NONE
+					: pool->hugetlb ? XAL_HUGEPAGES_EXPLICIT
+							: XAL_HUGEPAGES_TRANSPARENT;
+	size_t nbytes = align_up(pool->allocated * pool->element_size, pool->pagesize);
+	void *mem;
+	int err;
+
+	if (!pool->shared) {
+		return xal_pool_clear(pool);
+	}
+
+	/**
+	 * The object is replaced by reserving its range anew, rather than unmapping it, such that a
+	 * reader still addressing the pool reads zeroes instead of faulting
+	 */
+	if (nbytes) {
+		mem = mmap(pool->memory, nbytes, PROT_READ,
+			   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+		if (mem == MAP_FAILED) {
+			XAL_DEBUG("FAILED: mmap(PROT_READ); errno(%d)", errno);
 			return -errno;
 		}
+		if (pool_mbind(pool, pool->memory, nbytes)) {
+			XAL_DEBUG("INFO: pool_mbind(...); continuing");
+		}
+	}
 
-		memset(pool->memory, 0, nbytes);
-		pool->allocated = reserved;
-		pool->growby = reserved;
+	if (pool->fd >= 0) {
+		close(pool->fd);
+		pool->fd = -1;
+	}
+	pool->allocated = 0;
+	pool->free = 0;
+	pool->used = 0;
+	pool->hugetlb = false;
+	pool->thp = false;
+	for (int i = 0; i < XAL_POOL_NCLASSES; ++i) {
+		pool->freelist[i] = XAL_POOL_IDX_NONE;
+	}
+
+	err = pool_open_shared(pool, shm_name, kind, pool->memfd);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_open_shared(...); err(%d)", err);
+		return err;
+	}
+
+	err = xal_pool_grow(pool, pool->growby);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_grow(...); err(%d)", err);
+		return err;
+	}
+
+	return 0;
+}
+
+int
+xal_pool_unlink(const struct xal_pool *pool, const char *shm_name)
+{
+	char path[sizeof(XAL_POOL_HUGETLBFS) + XAL_PATH_MAXLEN + 16];
+	int err;
+
+	if (!pool->shared || pool->memfd) {
+		return 0;
+	}
+
+	if (pool->hugetlb) {
+		pool_hugetlbfs_path(path, sizeof(path), shm_name);
+		err = unlink(path);
 	} else {
-		if (allocated > reserved) {
-			XAL_DEBUG("FAILED: xal_pool_map(...); errno(%d)", EINVAL);
-			return -EINVAL;
-		}
+		err = shm_unlink(shm_name);
+	}
+	if (err && errno != ENOENT) {
+		XAL_DEBUG("FAILED: unlink(%s); errno(%d)", shm_name, errno);
+		return -errno;
+	}
 
-		pool->allocated = 0;
-		pool->growby = allocated;
+	return 0;
+}
 
-		pool->memory =
-		    mmap(NULL, nbytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-		if (MAP_FAILED == pool->memory) {
-			XAL_DEBUG("FAILED: mmap(...); errno(%d)", errno);
-			return -errno;
+size_t
+xal_pool_resident(const struct xal_pool *pool)
+{
+	const size_t pagesize = sysconf(_SC_PAGESIZE);
+	size_t nbytes, npages, nresident = 0;
+	uint8_t *cursor = pool->memory;
+	unsigned char vec[256];
+
+	if (!pool->memory) {
+		return 0;
+	}
+
+	nbytes = align_up(pool->allocated * pool->element_size,
+			  pool->pagesize ? pool->pagesize : pagesize);
+	npages = nbytes / pagesize;
+
+	for (size_t page = 0; page < npages; page += sizeof(vec)) {
+		size_t count = npages - page < sizeof(vec) ? npages - page : sizeof(vec);
+
+		if (mincore(&cursor[page * pagesize], count * pagesize, vec)) {
+			XAL_DEBUG("FAILED: mincore(); errno(%d)", errno);
+			break;
 		}
 
-		err = xal_pool_grow(pool, allocated);
-		if (err) {
-			XAL_DEBUG("FAILED: xal_pool_grow(...); err(%d)", err);
-			xal_pool_unmap(pool);
-			return err;
+		for (size_t i = 0; i < count; ++i) {
+			nresident += vec[i] & 1;
 		}
 	}
 
-	return 0;
+	return nresident * pagesize;
 }
 
 int
-xal_pool_claim_inodes(struct xal_pool *pool, size_t count, uint32_t *idx)
+xal_pool_seal(struct xal_pool *pool)
 {
+	struct stat st;
+	void *mem;
 	int err;
 
-	if (count > pool->growby) {
-		XAL_DEBUG("FAILED: count > pool->growby");
+	if (!pool->memfd) {
+		XAL_DEBUG("FAILED: pool is not backed by a memfd");
 		return -EINVAL;
 	}
 
-	if (pool->allocated <= (pool->free + count)) {
-		err = xal_pool_grow(pool, pool->growby);
-		if (err) {
-			XAL_DEBUG("FAILED: xal_pool_grow(); err(%d)", err);
-			return err;
-		}
+	if (fstat(pool->fd, &st)) {
+		XAL_DEBUG("FAILED: fstat(); errno(%d)", errno);
+		return -errno;
+	}
+
+	/**
+	 * F_SEAL_WRITE is refused while a shared mapping which may become writable exists, thus,
+	 * the pool is replaced by inaccessible memory while sealing, and then mapped read-only at
+	 * the same address
+	 */
+	mem = mmap(pool->memory, st.st_size, PROT_NONE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+	if (mem == MAP_FAILED) {
+		XAL_DEBUG("FAILED: mmap(); errno(%d)", errno);
+		return -errno;
+	}
+
+	err = fcntl(pool->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+	if (err) {
+		err = -errno;
+		XAL_DEBUG("FAILED: fcntl(F_ADD_SEALS); errno(%d)", errno);
 	}
 
-	if (pool->free + count > UINT32_MAX) {
-		XAL_DEBUG("FAILED: pool->free exceeds uint32_t range");
+	mem = mmap(pool->memory, st.st_size, err ? PROT_READ | PROT_WRITE : PROT_READ,
+		   MAP_SHARED | MAP_FIXED | (pool->hugetlb ? 0 : MAP_NORESERVE), pool->fd, 0);
+	if (mem == MAP_FAILED) {
+		XAL_DEBUG("FAILED: mmap(); errno(%d)", errno);
+		return -errno;
+	}
+
+	return err;
+}
+
+int
+xal_pool_claim_inodes(struct xal_pool *pool, size_t count, xal_idx_t *idx)
+{
+	int err;
+
+	if (pool->free + count >= XAL_POOL_IDX_NONE) {
+		XAL_DEBUG("FAILED: pool->free exceeds xal_idx_t range");
 		return -EOVERFLOW;
 	}
 
+	err = pool_reserve(pool, count);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_reserve(); err(%d)", err);
+		return err;
+	}
+
 	if (idx) {
 		*idx = pool->free;
 	}
 	pool->free += count;
+	if (pool->free > pool->used) {
+		pool->used = pool->free;
+	}
 
 	return 0;
 }
 
 int
-xal_pool_claim_extents(struct xal_pool *pool, size_t count, uint32_t *idx)
+xal_pool_claim_extents(struct xal_pool *pool, size_t count, xal_idx_t *idx)
+{
+	return xal_pool_claim_inodes(pool, count, idx);
+}
+
+int
+xal_pool_claim_bytes(struct xal_pool *pool, size_t count, uint64_t *ofz)
 {
 	int err;
 
-	if (count > pool->growby) {
-		XAL_DEBUG("FAILED: count > pool->growby");
+	err = pool_reserve(pool, count);
+	if (err) {
+		XAL_DEBUG("FAILED: pool_reserve(); err(%d)", err);
+		return err;
+	}
+
+	*ofz = pool->free;
+	pool->free += count;
+	if (pool->free > pool->used) {
+		pool->used = pool->free;
+	}
+
+	return 0;
+}
+
+static inline struct xal_pool_range *
+pool_range_at(struct xal_pool *pool, xal_idx_t idx)
+{
+	return (struct xal_pool_range *)((uint8_t *)pool->memory + (size_t)idx * pool->element_size);
+}
+
+/**
+ * Returns the size class of a range of 'count' elements, that is, floor(log2(count))
+ */
+static inline int
+pool_class(size_t count)
+{
+	return 63 - __builtin_clzll(count);
+}
+
+int
+xal_pool_free(struct xal_pool *pool, xal_idx_t idx, size_t count, uint32_t epoch)
+{
+	struct xal_pool_range *range;
+	int class;
+
+	if (!count) {
+		return 0;
+	}
+	if (pool->element_size < sizeof(*range) || (size_t)idx + count > pool->free ||
+	    count > UINT32_MAX) {
+		XAL_DEBUG("FAILED: invalid range; idx(%" PRIxal_idx "), count(%zu)", idx, count);
 		return -EINVAL;
 	}
 
-	if (pool->allocated <= (pool->free + count)) {
-		err = xal_pool_grow(pool, pool->growby);
-		if (err) {
-			XAL_DEBUG("xal_pool_grow(); err(%d)", err);
-			return err;
+	class = pool_class(count);
+
+	range = pool_range_at(pool, idx);
+	range->next = pool->freelist[class];
+	range->count = count;
+	range->epoch = epoch;
+
+	pool->freelist[class] = idx;
+
+	return 0;
+}
+
+int
+xal_pool_claim_recycled(struct xal_pool *pool, size_t count, uint32_t epoch, xal_idx_t *idx)
+{
+	int err;
+
+	if (!count || count > UINT32_MAX) {
+		return xal_pool_claim_extents(pool, count, idx);
+	}
+
+	for (int class = pool_class(count); class < XAL_POOL_NCLASSES; ++class) {
+		xal_idx_t *link = &pool->freelist[class];
+
+		while (*link != XAL_POOL_IDX_NONE) {
+			struct xal_pool_range *range = pool_range_at(pool, *link);
+			xal_idx_t found = *link;
+			uint32_t remainder;
+
+			if (range->epoch >= epoch || range->count < count) {
+				link = &range->next;
+				continue;
+			}
+
+			*link = range->next;
+			remainder = range->count - count;
+			if (remainder) {
+				err = xal_pool_free(pool, found + count, remainder, range->epoch);
+				if (err) {
+					XAL_DEBUG("FAILED: xal_pool_free(); err(%d)", err);
+					return err;
+				}
+			}
+
+			*idx = found;
+
+			return 0;
 		}
 	}
 
-	if (idx) {
-		*idx = pool->free;
+	return xal_pool_claim_extents(pool, count, idx);
+}
+
+int
+xal_pool_release(struct xal_pool *pool, size_t count)
+{
+	uint8_t *cursor = pool->memory;
+
+	if (count > pool->free) {
+		XAL_DEBUG("FAILED: count(%zu) > free(%zu)", count, pool->free);
+		return -EINVAL;
+	}
+
+	pool->free -= count;
+	memset(&cursor[pool->free * pool->element_size], 0, count * pool->element_size);
+
+	return 0;
+}
+
+int
+xal_pool_truncate(struct xal_pool *pool, size_t count)
+{
+	int err;
+
+	if (count > pool->free) {
+		XAL_DEBUG("FAILED: count(%zu) > free(%zu)", count, pool->free);
+		return -EINVAL;
+	}
+
+	err = xal_pool_release(pool, pool->free - count);
+	if (err) {
+		XAL_DEBUG("FAILED: xal_pool_release(); err(%d)", err);
+		return err;
+	}
+
+	for (int i = 0; i < XAL_POOL_NCLASSES; ++i) {
+		pool->freelist[i] = XAL_POOL_IDX_NONE;
 	}
-	pool->free += count;
 
 	return 0;
 }
@@ -162,14 +1230,29 @@ xal_pool_claim_extents(struct xal_pool *pool, size_t count, uint32_t *idx)
 int
 xal_pool_clear(struct xal_pool *pool)
 {
-	if (mprotect(pool->memory, pool->reserved * pool->element_size, PROT_READ | PROT_WRITE)) {
-		XAL_DEBUG("FAILED: mprotect(...); errno(%d)", errno);
-		return -errno;
+	size_t nbytes = pool->used * pool->element_size;
+	size_t nbytes_pages = nbytes / pool->pagesize * pool->pagesize;
+	uint8_t *cursor = pool->memory;
+
+	/**
+	 * Locked pages are zeroed rather than dropped, keeping them resident
+	 */
+	if (pool->mlock) {
+		nbytes_pages = 0;
 	}
-	memset(pool->memory, 0, pool->reserved * pool->element_size);
+
+	if (nbytes_pages &&
+	    madvise(pool->memory, nbytes_pages, pool->shared ? MADV_REMOVE : MADV_DONTNEED)) {
+		XAL_DEBUG("INFO: madvise(); errno(%d); zeroing instead", errno);
+		nbytes_pages = 0;
+	}
+	memset(&cursor[nbytes_pages], 0, nbytes - nbytes_pages);
 
 	pool->free = 0;
-	pool->allocated = 0;
+	pool->used = 0;
+	for (int i = 0; i < XAL_POOL_NCLASSES; ++i) {
+		pool->freelist[i] = XAL_POOL_IDX_NONE;
+	}
 
 	return 0;
 }
@@ -0,0 +1,108 @@
+#include <errno.h>
+#include <libxal.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xal_queue.h>
+
+int
+xal_queue_init(struct xal_queue *queue, uint32_t capacity)
+{
+	if (!capacity) {
+		return -EINVAL;
+	}
+
+	queue->items = calloc(capacity, sizeof(*queue->items));
+	if (!queue->items) {
+		XAL_DEBUG("FAILED: calloc(); errno(%d)", errno);
+		return -errno;
+	}
+
+	queue->capacity = capacity;
+	queue->head = 0;
+	queue->count = 0;
+
+	pthread_mutex_init(&queue->mutex, NULL);
+	pthread_cond_init(&queue->nonempty, NULL);
+	pthread_cond_init(&queue->nonfull, NULL);
+
+	return 0;
+}
+
+void
+xal_queue_term(struct xal_queue *queue)
+{
+	if (!queue->items) {
+		return;
+	}
+
+	pthread_cond_destroy(&queue->nonfull);
+	pthread_cond_destroy(&queue->nonempty);
+	pthread_mutex_destroy(&queue->mutex);
+
+	free(queue->items);
+	queue->items = NULL;
+}
+
+void
+xal_queue_push(struct xal_queue *queue, void *item)
+{
+	pthread_mutex_lock(&queue->mutex);
+
+	while (queue->count == queue->capacity) {
+		pthread_cond_wait(&queue->nonfull, &queue->mutex);
+	}
+
+	queue->items[(queue->head + queue->count) % queue->capacity] = item;
+	queue->count += 1;
+
+	pthread_cond_signal(&queue->nonempty);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+static void *
+queue_take(struct xal_queue *queue)
+{
+	void *item = queue->items[queue->head];
+
+	queue->head = (queue->head + 1) % queue->capacity;
+	queue->count -= 1;
+
+	pthread_cond_signal(&queue->nonfull);
+
+	return item;
+}
+
+void *
+xal_queue_pop(struct xal_queue *queue)
+{
+	void *item;
+
+	pthread_mutex_lock(&queue->mutex);
+
+	while (!queue->count) {
+		pthread_cond_wait(&queue->nonempty, &queue->mutex);
+	}
+	item = queue_take(queue);
+
+	pthread_mutex_unlock(&queue->mutex);
+
+	return item;
+}
+
+void *
+xal_queue_trypop(struct xal_queue *queue)
+{
+	void *item = NULL;
+
+	pthread_mutex_lock(&queue->mutex);
+
+	if (queue->count) {
+		item = queue_take(queue);
+	}
+
+	pthread_mutex_unlock(&queue->mutex);
+
+	return item;
+}
@@ -0,0 +1,997 @@
+/**
+ * Behavioural scenarios of the library against a mounted file system, run by the cijoe tests
+ *
+ * Each scenario exercises one feature through the public API and prints its observations as YAML;
+ * the tests assert on these. The exit status is non-zero when the scenario could not be run, e.g.
+ * when opening or indexing fails, not when an observation is unexpected.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <libxal.h>
+#include <libxnvme.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define EXTENTS_MAX 4096 ///< Capacity of the copy-out buffers
+#define HOLE_NBYTES (1UL << 20) ///< Gap left by modify_file(), such that the file gains an extent
+#define WRITE_NBYTES 65536 ///< Number of bytes written by modify_file()
+#define SETTLE_MS 250 ///< Time without updates after which the watcher is taken to be idle
+#define FILES_MAX 2 ///< Number of files a scenario modifies
+#define RECYCLE_CYCLES 8 ///< Number of update cycles of the 'recycle' scenario
+#define SHM_NAME "/xal_scenarios" ///< The xal_opts.shm_name of the scenarios sharing an index
+#define REINDEX_ROUNDS 8 ///< Number of re-indexes of the 'reindex' scenarios
+
+struct extents {
+	struct xal_extent extents[EXTENTS_MAX];
+	uint32_t count;
+};
+
+struct files {
+	char *paths[FILES_MAX];
+	size_t count;
+};
+
+struct reindex {
+	struct xal *xal;
+	struct files *files;
+	struct extents *expected; ///< Extents of each file, as indexed before re-indexing
+	atomic_bool stop;
+	atomic_uint_fast64_t lookups;
+	atomic_uint_fast64_t errors;
+	atomic_uint_fast64_t inconsistent;
+	atomic_uint_fast64_t snapshots;
+};
+
+/**
+ * Callback of xal_walk() storing the paths of the first FILES_MAX regular files with extents
+ */
+static int
+find_files(struct xal *xal, struct xal_inode *inode, void *cb_args,
+	   int __attribute__((unused)) level)
+{
+	struct files *files = cb_args;
+
+	if (files->count == FILES_MAX || !xal_inode_is_file(inode) ||
+	    !inode->content.extents.count) {
+		return 0;
+	}
+
+	files->paths[files->count] = strdup(xal_inode_name(xal, inode));
+	if (!files->paths[files->count]) {
+		return -ENOMEM;
+	}
+	files->count += 1;
+
+	return 0;
+}
+
+static void
+files_free(struct files *files)
+{
+	for (size_t i = 0; i < files->count; ++i) {
+		free(files->paths[i]);
+	}
+}
+
+/**
+ * Callback of xal_walk() counting the regular files
+ */
+static int
+count_files(struct xal __attribute__((unused)) *xal, struct xal_inode *inode, void *cb_args,
+	    int __attribute__((unused)) level)
+{
+	size_t *count = cb_args;
+
+	*count += xal_inode_is_file(inode);
+
+	return 0;
+}
+
+/**
+ * Remove the shared memory objects of the index shared under SHM_NAME, see xal_attach(); those of
+ * the pools of either epoch, as re-indexing alternates between them
+ */
+static void
+shm_remove(void)
+{
+	const char *suffixes[] = {"_manifest", "_inodes", "_inodes_cold", "_extents", "_names"};
+	char name[64];
+
+	for (size_t i = 0; i < sizeof(suffixes) / sizeof(*suffixes); ++i) {
+		snprintf(name, sizeof(name), "%s%s", SHM_NAME, suffixes[i]);
+		shm_unlink(name);
+		snprintf(name, sizeof(name), "%s%s_1", SHM_NAME, suffixes[i]);
+		shm_unlink(name);
+	}
+}
+
+static int
+read_extents(struct xal *xal, char *path, struct extents *extents)
+{
+	int err;
+
+	err = xal_read_extents(xal, path, extents->extents, EXTENTS_MAX, &extents->count);
+	if (err == -ENOBUFS) {
+		extents->count = EXTENTS_MAX;
+		err = 0;
+	}
+
+	return err;
+}
+
+static bool
+extents_equal(const struct extents *a, const struct extents *b)
+{
+	return a->count == b->count &&
+	       !memcmp(a->extents, b->extents, a->count * sizeof(*a->extents));
+}
+
+/**
+ * Compare the extents of the given files in two indexes
+ */
+static int
+compare_files(struct xal *a, struct xal *b, struct files *files, bool *equal)
+{
+	struct extents *ea, *eb;
+	int err = 0;
+
+	ea = calloc(1, sizeof(*ea));
+	eb = calloc(1, sizeof(*eb));
+	if (!ea || !eb) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	*equal = true;
+	for (size_t i = 0; i < files->count; ++i) {
+		err = read_extents(a, files->paths[i], ea);
+		err = err ? err : read_extents(b, files->paths[i], eb);
+		if (err) {
+			printf("read_extents(%s); err(%d)\n", files->paths[i], err);
+			goto exit;
+		}
+		*equal = *equal && extents_equal(ea, eb);
+	}
+
+exit:
+	free(ea);
+	free(eb);
+
+	return err;
+}
+
+/**
+ * Write beyond the end of the file, leaving a hole, such that the file gains an extent; the size
+ * before is stored in 'size' for restore_file()
+ */
+static int
+modify_file(const char *path, off_t *size)
+{
+	char buf[WRITE_NBYTES];
+	struct stat sb;
+	int fd, err = 0;
+
+	memset(buf, 0xAB, sizeof(buf));
+
+	fd = open(path, O_WRONLY);
+	if (fd < 0) {
+		return -errno;
+	}
+
+	if (fstat(fd, &sb) ||
+	    pwrite(fd, buf, sizeof(buf), sb.st_size + HOLE_NBYTES) != sizeof(buf) || fsync(fd)) {
+		err = -errno;
+	}
+	*size = sb.st_size;
+
+	close(fd);
+
+	return err;
+}
+
+static int
+restore_file(const char *path, off_t size)
+{
+	return truncate(path, size) ? -errno : 0;
+}
+
+/**
+ * Wait for the watcher to update the index after 'last_gen', and then for it to become idle
+ */
+static int
+settle(struct xal *xal, uint32_t last_gen)
+{
+	int err;
+
+	err = xal_wait_generation(xal, last_gen, 10 * SETTLE_MS);
+	if (err) {
+		return err;
+	}
+
+	do {
+		last_gen = xal_get_generation(xal);
+		err = xal_wait_generation(xal, last_gen, SETTLE_MS);
+	} while (!err);
+
+	return err == -ETIMEDOUT ? 0 : err;
+}
+
+/**
+ * Modify the file as by modify_file(), and wait for the watcher to update the index
+ */
+static int
+modify_settled(struct xal *xal, const char *path, off_t *size)
+{
+	uint32_t gen = xal_get_generation(xal);
+	int err;
+
+	err = modify_file(path, size);
+
+	return err ? err : settle(xal, gen);
+}
+
+/**
+ * Restore the file as by restore_file(), and wait for the watcher to update the index
+ */
+static int
+restore_settled(struct xal *xal, const char *path, off_t size)
+{
+	uint32_t gen = xal_get_generation(xal);
+	int err;
+
+	err = restore_file(path, size);
+
+	return err ? err : settle(xal, gen);
+}
+
+static int
+open_indexed(struct xnvme_dev *dev, struct xal_opts *opts, struct xal **xal)
+{
+	int err;
+
+	err = xal_open(dev, xal, opts);
+	if (err) {
+		printf("xal_open(...); err(%d)\n", err);
+		return err;
+	}
+
+	err = xal_index(*xal);
+	if (err) {
+		printf("xal_index(...); err(%d)\n", err);
+		xal_close(*xal);
+		*xal = NULL;
+		return err;
+	}
+
+	return 0;
+}
+
+/**
+ * Take a snapshot, modify a file under XAL_WATCHMODE_EXTENT_UPDATE, and compare the extents of the
+ * file in the snapshot to those before the modification
+ */
+static int
+scenario_snapshot(struct xnvme_dev *dev)
+{
+	struct xal_opts opts = {0};
+	struct extents *before = NULL, *after = NULL, *live = NULL;
+	struct xal *xal = NULL, *snapshot = NULL;
+	struct files files = {0};
+	bool watching = false;
+	int index_pinned = 0, err;
+	off_t size = -1;
+	char *path;
+
+	opts.be = XAL_BACKEND_FIEMAP;
+	opts.file_lookupmode = XAL_FILE_LOOKUPMODE_HASHMAP;
+	opts.watch_mode = XAL_WATCHMODE_EXTENT_UPDATE;
+
+	before = calloc(1, sizeof(*before));
+	after = calloc(1, sizeof(*after));
+	live = calloc(1, sizeof(*live));
+	if (!before || !after || !live) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	err = open_indexed(dev, &opts, &xal);
+	if (err) {
+		goto exit;
+	}
+
+	err = xal_walk(xal, xal_get_root(xal), find_files, &files);
+	if (err || !files.count) {
+		printf("xal_walk(...); err(%d), no file with extents\n", err);
+		err = err ? err : -ENOENT;
+		goto exit;
+	}
+	path = files.paths[0];
+
+	err = xal_watch_filesystem(xal, NULL, NULL);
+	if (err) {
+		printf("xal_watch_filesystem(...); err(%d)\n", err);
+		goto exit;
+	}
+	watching = true;
+
+	err = xal_snapshot(xal, &snapshot);
+	if (err) {
+		printf("xal_snapshot(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	err = read_extents(snapshot, path, before);
+	if (err) {
+		printf("read_extents(snapshot, %s); err(%d)\n", path, err);
+		goto exit;
+	}
+
+	index_pinned = xal_index(xal);
+
+	err = modify_settled(xal, path, &size);
+	if (err) {
+		printf("modify_settled(%s); err(%d)\n", path, err);
+		goto exit;
+	}
+
+	err = read_extents(xal, path, live);
+	err = err ? err : read_extents(snapshot, path, after);
+	if (err) {
+		printf("read_extents(%s); err(%d)\n", path, err);
+		goto exit;
+	}
+
+	xal_close(snapshot);
+	snapshot = NULL;
+
+	/**
+	 * Once the snapshot is closed, the extents released while it was open are freed
+	 */
+	err = restore_settled(xal, path, size);
+	if (err) {
+		printf("restore_settled(%s); err(%d)\n", path, err);
+		goto exit;
+	}
+	size = -1;
+
+	printf("xal_scenarios:\n");
+	printf("  scenario: snapshot\n");
+	printf("  file: '%s'\n", path);
+	printf("  extents_before: %" PRIu32 "\n", before->count);
+	printf("  extents_live: %" PRIu32 "\n", live->count);
+	printf("  live_changed: %s\n", extents_equal(before, live) ? "false" : "true");
+	printf("  snapshot_unchanged: %s\n", extents_equal(before, after) ? "true" : "false");
+	printf("  index_while_pinned: %d\n", index_pinned);
+	printf("  restored: %s\n", read_extents(xal, path, live) ? "false" : "true");
+
+exit:
+	if (size >= 0) {
+		restore_file(files.paths[0], size);
+	}
+	xal_close(snapshot);
+	if (watching) {
+		xal_stop_watching_filesystem(xal);
+	}
+	xal_close(xal);
+	files_free(&files);
+	free(before);
+	free(after);
+	free(live);
+
+	return err;
+}
+
+/**
+ * Return the end of the extent records of the file, that is, the index past its last record
+ */
+static int
+records_end(struct xal *xal, char *path, uint64_t *end)
+{
+	struct xal_inode *inode;
+	int err;
+
+	err = xal_get_inode(xal, path, &inode);
+	if (err) {
+		return err;
+	}
+
+	*end = (uint64_t)inode->content.extents.extent_idx + inode->content.extents.count;
+
+	return 0;
+}
+
+/**
+ * Alternately grow two files under XAL_WATCHMODE_EXTENT_UPDATE, such that the records released by
+ * the one fit the records claimed by the other, and count the claims served below the highest
+ * record in use, that is, from released records rather than from the end of the pool
+ *
+ * Thereafter, the extents of the updated index are compared to those of a fresh index.
+ */
+static int
+scenario_recycle(struct xnvme_dev *dev)
+{
+	struct xal_opts opts = {0}, check_opts = {0};
+	struct extents *live = NULL, *fresh = NULL;
+	struct xal *xal = NULL, *check = NULL;
+	struct files files = {0};
+	off_t sizes[FILES_MAX] = {-1, -1}, grown, size;
+	uint64_t highwater = 0, highwater_begin, end;
+	uint32_t recycled = 0;
+	bool watching = false, consistent = false;
+	char *small, *large;
+	struct stat sb;
+	int err;
+
+	opts.be = XAL_BACKEND_FIEMAP;
+	opts.file_lookupmode = XAL_FILE_LOOKUPMODE_HASHMAP;
+	opts.watch_mode = XAL_WATCHMODE_EXTENT_UPDATE;
+
+	live = calloc(1, sizeof(*live));
+	fresh = calloc(1, sizeof(*fresh));
+	if (!live || !fresh) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	err = open_indexed(dev, &opts, &xal);
+	if (err) {
+		goto exit;
+	}
+
+	err = xal_walk(xal, xal_get_root(xal), find_files, &files);
+	if (err || files.count < 2) {
+		printf("xal_walk(...); err(%d), less than two files with extents\n", err);
+		err = err ? err : -ENOENT;
+		goto exit;
+	}
+
+	err = read_extents(xal, files.paths[0], fresh);
+	err = err ? err : read_extents(xal, files.paths[1], live);
+	if (err) {
+		printf("read_extents(...); err(%d)\n", err);
+		goto exit;
+	}
+	if (fresh->count > live->count) {
+		small = files.paths[1];
+		files.paths[1] = files.paths[0];
+		files.paths[0] = small;
+	}
+	small = files.paths[0];
+	large = files.paths[1];
+
+	err = xal_watch_filesystem(xal, NULL, NULL);
+	if (err) {
+		printf("xal_watch_filesystem(...); err(%d)\n", err);
+		goto exit;
+	}
+	watching = true;
+
+	/**
+	 * Grow the large file beyond the small one, such that its released records fit the claims
+	 * of the small one, which gains a record per cycle
+	 */
+	err = read_extents(xal, small, fresh);
+	err = err ? err : read_extents(xal, large, live);
+	for (int i = 0; !err && live->count <= fresh->count && i < 8; ++i) {
+		err = modify_settled(xal, large, sizes[1] < 0 ? &sizes[1] : &size);
+		err = err ? err : read_extents(xal, large, live);
+	}
+	if (err || stat(large, &sb)) {
+		printf("growing(%s); err(%d)\n", large, err);
+		err = err ? err : -errno;
+		goto exit;
+	}
+	grown = sb.st_size;
+	if (sizes[1] < 0) {
+		sizes[1] = grown;
+	}
+
+	err = records_end(xal, small, &highwater);
+	err = err ? err : records_end(xal, large, &end);
+	if (err) {
+		printf("records_end(...); err(%d)\n", err);
+		goto exit;
+	}
+	highwater = end > highwater ? end : highwater;
+	highwater_begin = highwater;
+
+	for (int cycle = 0; !err && cycle < RECYCLE_CYCLES; ++cycle) {
+		err = modify_settled(xal, large, &size);
+		err = err ? err : restore_settled(xal, large, grown);
+		err = err ? err : records_end(xal, large, &end);
+		if (err) {
+			break;
+		}
+		highwater = end > highwater ? end : highwater;
+
+		err = modify_settled(xal, small, &sizes[0]);
+		err = err ? err : records_end(xal, small, &end);
+		if (err) {
+			break;
+		}
+		recycled += end <= highwater;
+		highwater = end > highwater ? end : highwater;
+
+		err = restore_settled(xal, small, sizes[0]);
+		if (!err) {
+			sizes[0] = -1;
+		}
+	}
+	if (err) {
+		printf("cycle(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	check_opts.be = XAL_BACKEND_FIEMAP;
+
+	err = open_indexed(dev, &check_opts, &check);
+	if (err) {
+		goto exit;
+	}
+	err = compare_files(xal, check, &files, &consistent);
+	if (err) {
+		goto exit;
+	}
+
+	printf("xal_scenarios:\n");
+	printf("  scenario: recycle\n");
+	printf("  files: ['%s', '%s']\n", small, large);
+	printf("  cycles: %d\n", RECYCLE_CYCLES);
+	printf("  recycled: %" PRIu32 "\n", recycled);
+	printf("  highwater_growth: %" PRIu64 "\n", highwater - highwater_begin);
+	printf("  consistent: %s\n", consistent ? "true" : "false");
+
+exit:
+	for (size_t i = 0; i < files.count; ++i) {
+		if (sizes[i] >= 0) {
+			restore_file(files.paths[i], sizes[i]);
+		}
+	}
+	xal_close(check);
+	if (watching) {
+		xal_stop_watching_filesystem(xal);
+	}
+	xal_close(xal);
+	files_free(&files);
+	free(live);
+	free(fresh);
+
+	return err;
+}
+
+/**
+ * Share an index under SHM_NAME, attach to it, and compare the view to the producer; then
+ * re-index the producer and check that the view observes the new generation, and, refreshed
+ * after each of two re-indexes, that is, onto the pools of either epoch, describes the new index
+ */
+static int
+scenario_attach(struct xnvme_dev *dev)
+{
+	struct xal_opts opts = {0};
+	struct xal *xal = NULL, *view = NULL, *missing = NULL;
+	struct files files = {0};
+	size_t nfiles = 0, nfiles_view = 0, nfiles_refreshed = 0;
+	bool equal = false, refreshed_equal = false, generation_follows;
+	int attach_missing, refreshed, err;
+	uint32_t gen;
+
+	opts.be = XAL_BACKEND_FIEMAP;
+	opts.shm_name = SHM_NAME;
+
+	shm_remove();
+
+	attach_missing = xal_attach(SHM_NAME, &missing);
+	xal_close(attach_missing ? NULL : missing);
+
+	err = open_indexed(dev, &opts, &xal);
+	if (err) {
+		goto exit;
+	}
+
+	err = xal_attach(SHM_NAME, &view);
+	if (err) {
+		printf("xal_attach(%s); err(%d)\n", SHM_NAME, err);
+		goto exit;
+	}
+
+	err = xal_walk(xal, xal_get_root(xal), count_files, &nfiles);
+	err = err ? err : xal_walk(view, xal_get_root(view), count_files, &nfiles_view);
+	err = err ? err : xal_walk(xal, xal_get_root(xal), find_files, &files);
+	if (err) {
+		printf("xal_walk(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	err = compare_files(xal, view, &files, &equal);
+	if (err) {
+		goto exit;
+	}
+
+	gen = xal_get_generation(view);
+	err = xal_index(xal);
+	if (err) {
+		printf("xal_index(...); err(%d)\n", err);
+		goto exit;
+	}
+	generation_follows = xal_wait_generation(view, gen, SETTLE_MS) == 0;
+
+	refreshed = xal_attach_refresh(view);
+	err = xal_index(xal);
+	if (err) {
+		printf("xal_index(...); err(%d)\n", err);
+		goto exit;
+	}
+	refreshed = refreshed ? refreshed : xal_attach_refresh(view);
+
+	if (!refreshed) {
+		err = xal_walk(view, xal_get_root(view), count_files, &nfiles_refreshed);
+		err = err ? err : compare_files(xal, view, &files, &refreshed_equal);
+		if (err) {
+			printf("xal_walk(...) or compare_files(...); err(%d), refreshed\n", err);
+			goto exit;
+		}
+	}
+
+	printf("xal_scenarios:\n");
+	printf("  scenario: attach\n");
+	printf("  attach_missing: %d\n", attach_missing);
+	printf("  files: %zu\n", nfiles);
+	printf("  files_view: %zu\n", nfiles_view);
+	printf("  extents_equal: %s\n", equal ? "true" : "false");
+	printf("  generation_follows: %s\n", generation_follows ? "true" : "false");
+	printf("  refreshed: %d\n", refreshed);
+	printf("  files_refreshed: %zu\n", nfiles_refreshed);
+	printf("  refreshed_extents_equal: %s\n", refreshed_equal ? "true" : "false");
+
+exit:
+	xal_close(view);
+	xal_close(xal);
+	shm_remove();
+	files_free(&files);
+
+	return err;
+}
+
+/**
+ * Index into memfds, attach to them by descriptor, and seal the index; thereafter, modifying the
+ * index is refused while attaching to it still succeeds
+ */
+static int
+scenario_seal(struct xnvme_dev *dev)
+{
+	struct xal_opts opts = {0};
+	struct xal *xal = NULL, *view = NULL, *sealed_view = NULL;
+	struct xal_fds fds;
+	struct files files = {0};
+	size_t nfiles = 0, nfiles_view = 0;
+	bool equal = false, sealed_equal = false;
+	int index_sealed, compact_sealed, err;
+
+	opts.be = XAL_BACKEND_FIEMAP;
+	opts.memfd = true;
+
+	err = open_indexed(dev, &opts, &xal);
+	if (err) {
+		goto exit;
+	}
+
+	err = xal_get_fds(xal, &fds);
+	if (err) {
+		printf("xal_get_fds(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	err = xal_attach_fds(&fds, &view);
+	if (err) {
+		printf("xal_attach_fds(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	err = xal_walk(xal, xal_get_root(xal), count_files, &nfiles);
+	err = err ? err : xal_walk(view, xal_get_root(view), count_files, &nfiles_view);
+	err = err ? err : xal_walk(xal, xal_get_root(xal), find_files, &files);
+	if (err) {
+		printf("xal_walk(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	err = compare_files(xal, view, &files, &equal);
+	if (err) {
+		goto exit;
+	}
+
+	err = xal_seal(xal);
+	if (err) {
+		printf("xal_seal(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	index_sealed = xal_index(xal);
+	compact_sealed = xal_compact(xal);
+
+	err = xal_attach_fds(&fds, &sealed_view);
+	if (err) {
+		printf("xal_attach_fds(...); err(%d), after sealing\n", err);
+		goto exit;
+	}
+
+	err = compare_files(xal, sealed_view, &files, &sealed_equal);
+	if (err) {
+		goto exit;
+	}
+
+	printf("xal_scenarios:\n");
+	printf("  scenario: seal\n");
+	printf("  files: %zu\n", nfiles);
+	printf("  files_view: %zu\n", nfiles_view);
+	printf("  extents_equal: %s\n", equal ? "true" : "false");
+	printf("  index_sealed: %d\n", index_sealed);
+	printf("  compact_sealed: %d\n", compact_sealed);
+	printf("  sealed_extents_equal: %s\n", sealed_equal ? "true" : "false");
+
+exit:
+	xal_close(sealed_view);
+	xal_close(view);
+	xal_close(xal);
+	files_free(&files);
+
+	return err;
+}
+
+/**
+ * Look up the extents of the files while they are re-indexed, expecting them to be unchanged
+ */
+static void *
+reindex_reader(void *arg)
+{
+	struct reindex *rx = arg;
+	struct extents *extents;
+
+	extents = calloc(1, sizeof(*extents));
+	if (!extents) {
+		atomic_fetch_add(&rx->errors, 1);
+		return NULL;
+	}
+
+	for (size_t i = 0; !atomic_load(&rx->stop); i = (i + 1) % rx->files->count) {
+		if (read_extents(rx->xal, rx->files->paths[i], extents)) {
+			atomic_fetch_add(&rx->errors, 1);
+		} else if (!extents_equal(extents, &rx->expected[i])) {
+			atomic_fetch_add(&rx->inconsistent, 1);
+		}
+		atomic_fetch_add(&rx->lookups, 1);
+	}
+
+	free(extents);
+
+	return NULL;
+}
+
+/**
+ * Take snapshots while the files are re-indexed, such that some are taken while an index is built
+ * aside; the publish of that index is then refused, and the snapshot is to be unchanged
+ */
+static void *
+reindex_snapshotter(void *arg)
+{
+	struct reindex *rx = arg;
+	struct extents *extents;
+
+	extents = calloc(1, sizeof(*extents));
+	if (!extents) {
+		atomic_fetch_add(&rx->errors, 1);
+		return NULL;
+	}
+
+	while (!atomic_load(&rx->stop)) {
+		struct xal *snapshot;
+		int err;
+
+		err = xal_snapshot(rx->xal, &snapshot);
+		if (err) {
+			atomic_fetch_add(&rx->errors, 1);
+			continue;
+		}
+
+		for (size_t i = 0; i < rx->files->count; ++i) {
+			if (read_extents(snapshot, rx->files->paths[i], extents)) {
+				atomic_fetch_add(&rx->errors, 1);
+			} else if (!extents_equal(extents, &rx->expected[i])) {
+				atomic_fetch_add(&rx->inconsistent, 1);
+			}
+		}
+		atomic_fetch_add(&rx->snapshots, 1);
+
+		xal_close(snapshot);
+		usleep(1000);
+	}
+
+	free(extents);
+
+	return NULL;
+}
+
+/**
+ * Re-index repeatedly while readers look up extents and snapshots are taken; a re-index either
+ * publishes a new generation or, when a snapshot pins the index, fails with -EBUSY leaving the
+ * published index in place
+ */
+static int
+reindex(struct xnvme_dev *dev, bool shared)
+{
+	struct xal_opts opts = {0};
+	struct reindex rx = {0};
+	struct files files = {0};
+	pthread_t reader, snapshotter;
+	uint32_t published = 0, busy = 0, failed = 0, gen;
+	int nthreads = 0, err;
+
+	opts.be = XAL_BACKEND_FIEMAP;
+	opts.file_lookupmode = XAL_FILE_LOOKUPMODE_HASHMAP;
+	opts.shm_name = shared ? SHM_NAME : NULL;
+
+	if (shared) {
+		shm_remove();
+	}
+
+	err = open_indexed(dev, &opts, &rx.xal);
+	if (err) {
+		goto exit;
+	}
+
+	err = xal_walk(rx.xal, xal_get_root(rx.xal), find_files, &files);
+	if (err || !files.count) {
+		printf("xal_walk(...); err(%d), no file with extents\n", err);
+		err = err ? err : -ENOENT;
+		goto exit;
+	}
+	rx.files = &files;
+
+	rx.expected = calloc(files.count, sizeof(*rx.expected));
+	if (!rx.expected) {
+		err = -ENOMEM;
+		goto exit;
+	}
+	for (size_t i = 0; i < files.count; ++i) {
+		err = read_extents(rx.xal, files.paths[i], &rx.expected[i]);
+		if (err) {
+			printf("read_extents(%s); err(%d)\n", files.paths[i], err);
+			goto exit;
+		}
+	}
+
+	err = pthread_create(&reader, NULL, reindex_reader, &rx);
+	if (err) {
+		printf("pthread_create(...); err(%d)\n", err);
+		err = -err;
+		goto exit;
+	}
+	nthreads += 1;
+
+	err = pthread_create(&snapshotter, NULL, reindex_snapshotter, &rx);
+	if (err) {
+		printf("pthread_create(...); err(%d)\n", err);
+		err = -err;
+		goto exit;
+	}
+	nthreads += 1;
+
+	for (int round = 0; round < REINDEX_ROUNDS; ++round) {
+		gen = xal_get_generation(rx.xal);
+
+		err = xal_index(rx.xal);
+		if (!err) {
+			published += xal_get_generation(rx.xal) != gen;
+		} else if (err == -EBUSY) {
+			busy += 1;
+			failed += xal_get_generation(rx.xal) != gen;
+		} else {
+			printf("xal_index(...); err(%d)\n", err);
+			goto exit;
+		}
+	}
+	err = 0;
+
+exit:
+	atomic_store(&rx.stop, true);
+	if (nthreads > 1) {
+		pthread_join(snapshotter, NULL);
+	}
+	if (nthreads > 0) {
+		pthread_join(reader, NULL);
+	}
+
+	if (!err) {
+		printf("xal_scenarios:\n");
+		printf("  scenario: %s\n", shared ? "reindex_shared" : "reindex");
+		printf("  rounds: %d\n", REINDEX_ROUNDS);
+		printf("  published: %" PRIu32 "\n", published);
+		printf("  busy: %" PRIu32 "\n", busy);
+		printf("  busy_published: %" PRIu32 "\n", failed);
+		printf("  lookups: %" PRIuFAST64 "\n", atomic_load(&rx.lookups));
+		printf("  snapshots: %" PRIuFAST64 "\n", atomic_load(&rx.snapshots));
+		printf("  errors: %" PRIuFAST64 "\n", atomic_load(&rx.errors));
+		printf("  inconsistent: %" PRIuFAST64 "\n", atomic_load(&rx.inconsistent));
+	}
+
+	xal_close(rx.xal);
+	if (shared) {
+		shm_remove();
+	}
+	files_free(&files);
+	free(rx.expected);
+
+	return err;
+}
+
+static int
+scenario_reindex(struct xnvme_dev *dev)
+{
+	return reindex(dev, false);
+}
+
+static int
+scenario_reindex_shared(struct xnvme_dev *dev)
+{
+	return reindex(dev, true);
+}
+
+static const struct {
+	const char *name;
+	int (*func)(struct xnvme_dev *dev);
+} scenarios[] = {
+	{"snapshot", scenario_snapshot},
+	{"recycle", scenario_recycle},
+	{"attach", scenario_attach},
+	{"seal", scenario_seal},
+	{"reindex", scenario_reindex},
+	{"reindex_shared", scenario_reindex_shared},
+};
+
+int
+main(int argc, char *argv[])
+{
+	struct xnvme_opts xnvme_opts = {0};
+	struct xnvme_dev *dev;
+	bool found = false;
+	int err = 0;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <scenario> <dev_uri>\n", argv[0]);
+		return 1;
+	}
+
+	xnvme_opts_set_defaults(&xnvme_opts);
+
+	dev = xnvme_dev_open(argv[2], &xnvme_opts);
+	if (!dev) {
+		printf("xnvme_dev_open(...); err(%d)\n", errno);
+		return 1;
+	}
+
+	for (size_t i = 0; i < sizeof(scenarios) / sizeof(*scenarios); ++i) {
+		if (!strcmp(argv[1], scenarios[i].name)) {
+			err = scenarios[i].func(dev);
+			found = true;
+			break;
+		}
+	}
+	if (!found) {
+		fprintf(stderr, "Error: invalid scenario(%s)\n", argv[1]);
+		err = -EINVAL;
+	}
+
+	xnvme_dev_close(dev);
+
+	return err ? 1 : 0;
+}
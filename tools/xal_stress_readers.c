@@ -0,0 +1,385 @@
+/**
+ * Concurrent lookups of extents with xal_read_extents(), by many reader threads, optionally while
+ * the inotify writer updates the index (XAL_WATCHMODE_EXTENT_UPDATE)
+ *
+ * Every copy of extents is checked for being well-formed, that is, ordered and non-overlapping in
+ * the file; without the writer, also for matching the extents read before the readers started.
+ * The result is printed as YAML; the exit status is non-zero when any lookup failed or was
+ * inconsistent.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <libxal.h>
+#include <libxnvme.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define EXTENTS_MAX 4096 ///< Capacity of the copy-out buffer of a reader
+#define WRITE_NBYTES 4096 ///< Number of bytes appended, and truncated again, by the writer
+
+struct file {
+	char *path;
+	uint32_t nextents; ///< Number of extents when the readers started
+	uint64_t checksum; ///< Sum over the extents when the readers started
+};
+
+struct stress {
+	struct xal *xal;
+	struct file *files;
+	size_t nfiles;
+	size_t capacity;
+	atomic_bool stop;
+	atomic_uint_fast64_t lookups;
+	atomic_uint_fast64_t errors;
+	atomic_uint_fast64_t inconsistent;
+	atomic_uint_fast64_t writes;
+	bool writer;
+};
+
+struct stress_args {
+	uint32_t nthreads;
+	uint32_t seconds;
+	bool writer;
+	bool compact_extents;
+	char *dev_uri;
+};
+
+static uint64_t
+extents_checksum(const struct xal_extent *extents, uint32_t count)
+{
+	uint64_t sum = count;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		sum = sum * 31 + extents[i].start_offset;
+		sum = sum * 31 + extents[i].start_block;
+		sum = sum * 31 + extents[i].nblocks;
+	}
+
+	return sum;
+}
+
+static bool
+extents_wellformed(const struct xal_extent *extents, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		if (extents[i].flag > 1 || !extents[i].nblocks) {
+			return false;
+		}
+		if (i && extents[i].start_offset <
+			     extents[i - 1].start_offset + extents[i - 1].nblocks) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+collect_file(struct xal *xal, struct xal_inode *inode, void *cb_args,
+	     int __attribute__((unused)) level)
+{
+	struct stress *stress = cb_args;
+
+	if (!xal_inode_is_file(inode)) {
+		return 0;
+	}
+
+	if (stress->nfiles == stress->capacity) {
+		size_t capacity = stress->capacity ? 2 * stress->capacity : 1024;
+		struct file *files = realloc(stress->files, capacity * sizeof(*files));
+
+		if (!files) {
+			return -ENOMEM;
+		}
+		stress->files = files;
+		stress->capacity = capacity;
+	}
+
+	stress->files[stress->nfiles].path = strdup(xal_inode_name(xal, inode));
+	if (!stress->files[stress->nfiles].path) {
+		return -ENOMEM;
+	}
+	stress->nfiles += 1;
+
+	return 0;
+}
+
+static void *
+reader(void *arg)
+{
+	struct stress *stress = arg;
+	struct xal_extent *extents;
+	uint64_t state = (uintptr_t)&extents | 1;
+	uint64_t lookups = 0, errors = 0, inconsistent = 0;
+
+	extents = calloc(EXTENTS_MAX, sizeof(*extents));
+	if (!extents) {
+		atomic_fetch_add(&stress->errors, 1);
+		return NULL;
+	}
+
+	while (!atomic_load_explicit(&stress->stop, memory_order_relaxed)) {
+		struct file *file;
+		uint32_t count;
+		int err;
+
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		file = &stress->files[state % stress->nfiles];
+
+		err = xal_read_extents(stress->xal, file->path, extents, EXTENTS_MAX, &count);
+		lookups += 1;
+		if (err == -ENOBUFS) {
+			count = EXTENTS_MAX;
+		} else if (err) {
+			errors += 1;
+			continue;
+		}
+
+		if (!extents_wellformed(extents, count)) {
+			inconsistent += 1;
+		} else if (!stress->writer && (count != file->nextents ||
+					       extents_checksum(extents, count) != file->checksum)) {
+			inconsistent += 1;
+		}
+	}
+
+	atomic_fetch_add(&stress->lookups, lookups);
+	atomic_fetch_add(&stress->errors, errors);
+	atomic_fetch_add(&stress->inconsistent, inconsistent);
+
+	free(extents);
+
+	return NULL;
+}
+
+/**
+ * Append to a file and truncate it back, each a modification picked up by the inotify writer
+ */
+static void *
+writer(void *arg)
+{
+	struct stress *stress = arg;
+	char buf[WRITE_NBYTES];
+
+	memset(buf, 0xAB, sizeof(buf));
+
+	for (size_t i = 0; !atomic_load_explicit(&stress->stop, memory_order_relaxed); ++i) {
+		struct file *file = &stress->files[i % stress->nfiles];
+		struct stat sb;
+		int fd;
+
+		fd = open(file->path, O_WRONLY);
+		if (fd < 0) {
+			atomic_fetch_add(&stress->errors, 1);
+			continue;
+		}
+
+		if (!fstat(fd, &sb) && pwrite(fd, buf, sizeof(buf), sb.st_size) == sizeof(buf)) {
+			fsync(fd);
+			if (ftruncate(fd, sb.st_size)) {
+				atomic_fetch_add(&stress->errors, 1);
+			}
+			atomic_fetch_add(&stress->writes, 1);
+		}
+		close(fd);
+
+		usleep(1000);
+	}
+
+	return NULL;
+}
+
+static int
+parse_args(int argc, char *argv[], struct stress_args *args)
+{
+	args->nthreads = 4;
+	args->seconds = 5;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			args->nthreads = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			args->seconds = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--writer") == 0) {
+			args->writer = true;
+		} else if (strcmp(argv[i], "--compact-extents") == 0) {
+			args->compact_extents = true;
+		} else if (!args->dev_uri && argv[i][0] != '-') {
+			args->dev_uri = argv[i];
+		} else {
+			fprintf(stderr, "Error: invalid argument(%s)\n", argv[i]);
+			return -EINVAL;
+		}
+	}
+
+	if (!args->dev_uri || !args->nthreads) {
+		fprintf(stderr, "Usage: %s [--threads N] [--seconds S] [--writer] "
+				"[--compact-extents] <dev_uri>\n", argv[0]);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct xnvme_opts xnvme_opts = {0};
+	struct xal_opts opts = {0};
+	struct stress_args args = {0};
+	struct stress stress = {0};
+	struct xal_extent *extents = NULL;
+	pthread_t *threads = NULL, writer_thread;
+	struct timespec begin, end;
+	struct xnvme_dev *dev;
+	uint32_t generation;
+	double elapsed;
+	int err;
+
+	err = parse_args(argc, argv, &args);
+	if (err) {
+		return -err;
+	}
+
+	xnvme_opts_set_defaults(&xnvme_opts);
+
+	dev = xnvme_dev_open(args.dev_uri, &xnvme_opts);
+	if (!dev) {
+		printf("xnvme_dev_open(...); err(%d)\n", errno);
+		return errno;
+	}
+
+	opts.be = XAL_BACKEND_FIEMAP;
+	opts.file_lookupmode = XAL_FILE_LOOKUPMODE_HASHMAP;
+	opts.watch_mode = args.writer ? XAL_WATCHMODE_EXTENT_UPDATE : XAL_WATCHMODE_NONE;
+	opts.compact_extents = args.compact_extents;
+
+	err = xal_open(dev, &stress.xal, &opts);
+	if (err) {
+		printf("xal_open(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	err = xal_index(stress.xal);
+	if (err) {
+		printf("xal_index(...); err(%d)\n", err);
+		goto exit;
+	}
+
+	err = xal_walk(stress.xal, xal_get_root(stress.xal), collect_file, &stress);
+	if (err || !stress.nfiles) {
+		printf("xal_walk(...); err(%d), nfiles(%zu)\n", err, stress.nfiles);
+		err = err ? err : -ENOENT;
+		goto exit;
+	}
+
+	extents = calloc(EXTENTS_MAX, sizeof(*extents));
+	threads = calloc(args.nthreads, sizeof(*threads));
+	if (!extents || !threads) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	for (size_t i = 0; i < stress.nfiles; ++i) {
+		uint32_t count;
+
+		err = xal_read_extents(stress.xal, stress.files[i].path, extents, EXTENTS_MAX, &count);
+		if (err && err != -ENOBUFS) {
+			printf("xal_read_extents(%s); err(%d)\n", stress.files[i].path, err);
+			goto exit;
+		}
+		count = count < EXTENTS_MAX ? count : EXTENTS_MAX;
+
+		stress.files[i].nextents = count;
+		stress.files[i].checksum = extents_checksum(extents, count);
+	}
+	err = 0;
+
+	if (args.writer) {
+		err = xal_watch_filesystem(stress.xal, NULL, NULL);
+		if (err) {
+			printf("xal_watch_filesystem(...); err(%d)\n", err);
+			goto exit;
+		}
+	}
+	stress.writer = args.writer;
+	generation = xal_get_generation(stress.xal);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	for (uint32_t i = 0; i < args.nthreads; ++i) {
+		err = pthread_create(&threads[i], NULL, reader, &stress);
+		if (err) {
+			printf("pthread_create(...); err(%d)\n", err);
+			atomic_store(&stress.stop, true);
+			args.nthreads = i;
+			break;
+		}
+	}
+	if (!err && args.writer) {
+		err = pthread_create(&writer_thread, NULL, writer, &stress);
+		if (err) {
+			printf("pthread_create(...); err(%d)\n", err);
+			args.writer = false;
+		}
+	}
+
+	if (!err) {
+		sleep(args.seconds);
+	}
+	atomic_store(&stress.stop, true);
+
+	for (uint32_t i = 0; i < args.nthreads; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	if (args.writer) {
+		pthread_join(writer_thread, NULL);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	elapsed = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+	if (!err && stress.writer) {
+		xal_stop_watching_filesystem(stress.xal);
+	}
+
+	printf("xal_stress_readers:\n");
+	printf("  threads: %" PRIu32 "\n", args.nthreads);
+	printf("  seconds: %.3f\n", elapsed);
+	printf("  writer: %s\n", stress.writer ? "true" : "false");
+	printf("  files: %zu\n", stress.nfiles);
+	printf("  lookups: %" PRIuFAST64 "\n", atomic_load(&stress.lookups));
+	printf("  lookups_per_sec: %.0f\n", atomic_load(&stress.lookups) / elapsed);
+	printf("  writes: %" PRIuFAST64 "\n", atomic_load(&stress.writes));
+	printf("  updates: %" PRIu32 "\n", xal_get_generation(stress.xal) - generation);
+	printf("  errors: %" PRIuFAST64 "\n", atomic_load(&stress.errors));
+	printf("  inconsistent: %" PRIuFAST64 "\n", atomic_load(&stress.inconsistent));
+
+	if (!err && (atomic_load(&stress.errors) || atomic_load(&stress.inconsistent))) {
+		err = -EIO;
+	}
+
+exit:
+	for (size_t i = 0; i < stress.nfiles; ++i) {
+		free(stress.files[i].path);
+	}
+	free(stress.files);
+	free(extents);
+	free(threads);
+	xal_close(stress.xal);
+	xnvme_dev_close(dev);
+
+	return err ? 1 : 0;
+}